@@ -8,6 +8,170 @@
 #include "Analytics.hpp"
 #include "HMMCompiled.hpp"
 #include "Models.hpp"
+#include "DPWorkspace.hpp"
+#include "ThreadPool.hpp"
+#include "DatabaseEntry.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ * State of an evaluation which is shared by the threads decoding its sequences. It is
+ * owned by shared pointers since a worker may start after the evaluation has finished.
+ */
+struct Evaluation {
+	boost::shared_ptr<HMMCompiled> _hmm;
+	const std::vector<std::vector<std::string> >& _sequences;
+	const std::vector<std::vector<uint8_t> >& _annotations;
+	// indices of the sequences ordered by decreasing length
+	std::vector<int> _order;
+	// _labels[l] = code of DatabaseEntry::Label of the label l of the HMM. Labels without
+	// such a code get NUMBER_LABELS, thus they never match an annotation.
+	uint8_t _labels[256];
+
+	// guards the following members
+	boost::mutex _mutex;
+	boost::condition_variable _finished;
+	// position in _order of the next sequence to decode
+	int _next;
+	// number of threads which are decoding sequences
+	int _active;
+	Analytics::AnalyticsIntermediate _sum;
+	// if not NULL, the counts of every sequence are stored in it as well
+	std::vector<Analytics::AnalyticsIntermediate>* _intermediates;
+	// error message of the first thread which has thrown an exception
+	std::string _error;
+
+	Evaluation(boost::shared_ptr<HMMCompiled> hmm,
+			const std::vector<std::vector<std::string> >& sequences,
+			const std::vector<std::vector<uint8_t> >& annotations) :
+			_hmm(hmm), _sequences(sequences), _annotations(annotations), _next(
+					0), _active(0), _intermediates(NULL) {
+		std::fill(_labels, _labels + 256, DatabaseEntry::NUMBER_LABELS);
+
+		for (int l = 0; l < hmm->getNumberLabels(); l++) {
+			for (int k = 0; k < DatabaseEntry::NUMBER_LABELS; k++) {
+				if (hmm->getLabelName(l) == DatabaseEntry::getLabelName(k)) {
+					_labels[l] = k;
+				}
+			}
+		}
+	}
+};
+
+struct LongerSequence {
+	const std::vector<std::vector<std::string> >& _sequences;
+
+	LongerSequence(const std::vector<std::vector<std::string> >& sequences) :
+			_sequences(sequences) {
+	}
+
+	bool operator()(int a, int b) const {
+		return _sequences[a].size() > _sequences[b].size();
+	}
+};
+
+/**
+ * Decodes the sequence with the index index and counts its correctly predicted bases and
+ * exons. labels is a buffer which is reused for all sequences of a thread.
+ */
+Analytics::AnalyticsIntermediate analyseSequence(const Evaluation& evaluation,
+		int index, DPWorkspace& workspace, std::vector<uint8_t>& labels) {
+	int size = 0;
+
+	// calculate the structure labels of the most likely state sequence
+	evaluation._hmm->viterbiLabels(evaluation._sequences[index], labels,
+			workspace);
+
+	// States without a label are skipped like in Models::VeilAnnotation. The other
+	// labels are translated into the codes of the annotation.
+	for (int t = 0; t < (int) labels.size(); t++) {
+		if (labels[t] != HMMTopology::NO_LABEL) {
+			labels[size++] = evaluation._labels[labels[t]];
+		}
+	}
+
+	labels.resize(size);
+
+	// calculate the statistics
+	return Analytics::analyse(labels, evaluation._annotations[index],
+			DatabaseEntry::EXON, DatabaseEntry::INTRON);
+}
+
+/**
+ * Decodes sequences of evaluation until all of them have been taken and adds their counts
+ * to evaluation->_sum. A worker which starts after all sequences have been taken returns
+ * immediately, thus it does not access the sequences anymore.
+ */
+void evaluateSequences(boost::shared_ptr<Evaluation> evaluation) {
+	Analytics::AnalyticsIntermediate sum;
+	std::string error;
+	int size = evaluation->_order.size();
+
+	{
+		boost::lock_guard<boost::mutex> lock(evaluation->_mutex);
+
+		if (evaluation->_next >= size) {
+			return;
+		}
+
+		evaluation->_active++;
+	}
+
+	DPWorkspace workspace;
+	std::vector<uint8_t> labels;
+
+	try {
+		while (true) {
+			int index;
+
+			{
+				boost::lock_guard<boost::mutex> lock(evaluation->_mutex);
+
+				if (evaluation->_next >= size) {
+					break;
+				}
+
+				index = evaluation->_order[evaluation->_next++];
+			}
+
+			Analytics::AnalyticsIntermediate intermediate = analyseSequence(
+					*evaluation, index, workspace, labels);
+
+			// every sequence is decoded by exactly one thread
+			if (evaluation->_intermediates != NULL) {
+				(*evaluation->_intermediates)[index] = intermediate;
+			}
+
+			sum += intermediate;
+		}
+	} catch (std::exception& e) {
+		error = e.what();
+	}
+
+	boost::lock_guard<boost::mutex> lock(evaluation->_mutex);
+
+	evaluation->_sum += sum;
+
+	if (!error.empty()) {
+		if (evaluation->_error.empty()) {
+			evaluation->_error = error;
+		}
+
+		// the remaining sequences are not decoded anymore
+		evaluation->_next = size;
+	}
+
+	if (--evaluation->_active == 0) {
+		evaluation->_finished.notify_all();
+	}
+}
+}
 
 Analytics::AnalyticsResult::AnalyticsResult() :
 		_nucleotidesSensitivity(0), _nucleotidesSpecificity(0), _exonSensitivity(
@@ -58,8 +222,9 @@ std::ostream& Analytics::operator<<(std::ostream& os,
 
 double Analytics::evaluate(boost::shared_ptr<HMMCompiled> hmm,
 		const std::vector<std::vector<std::string> >& sequences,
-		const std::vector<std::vector<std::string> >& annotations) {
-	AnalyticsResult result = analyse(hmm, sequences, annotations);
+		const std::vector<std::vector<std::string> >& annotations,
+		ThreadPool* pool) {
+	AnalyticsResult result = analyse(hmm, sequences, annotations, pool);
 
 	return (result._exonSensitivity + result._exonSpecificity
 			+ result._nucleotidesSensitivity + result._nucleotidesSpecificity)
@@ -73,94 +238,172 @@ double Analytics::evaluate(const Analytics::AnalyticsResult& result) {
 }
 
 Analytics::AnalyticsIntermediate Analytics::analyse(
-		const std::vector<std::string>& estimation,
-		const std::vector<std::string>& annotation) {
+		const std::vector<uint8_t>& estimation,
+		const std::vector<uint8_t>& annotation, uint8_t exon, uint8_t intron) {
 	Analytics::AnalyticsIntermediate result;
-	bool isExon = false;
-	bool exactlyMatched = true;
-	bool matched = false;
-	bool exonStart = false;
+	// whether the preceding base belongs to an exon
+	int isExon = 0;
+	// whether all bases of the current exon are correctly predicted
+	int exactlyMatched = 1;
+	// whether the preceding base is correctly predicted
+	int matched = 0;
+	// whether the first base of the current exon is correctly predicted
+	int exonStart = 0;
 	result._numberNucleotides = estimation.size();
 
 	assert(estimation.size() == annotation.size());
 
-	for (int i = 0; i < estimation.size(); i++) {
+	const uint8_t* est = estimation.empty() ? NULL : &estimation[0];
+	const uint8_t* ann = annotation.empty() ? NULL : &annotation[0];
+	const int size = estimation.size();
+
+	for (int i = 0; i < size; i++) {
+		int equal = ann[i] == est[i];
+		int exonBase = ann[i] == exon;
 		// A coding region is either an intron or an exon
-		// Nucleotide Sensitivity
-		if (annotation[i] == "E" || annotation[i] == "I") {
-			result._numberCodingNucleotides++;
+		int coding = exonBase | (ann[i] == intron);
+		int begins = exonBase & !isExon;
+		int ends = (exonBase ^ 1) & isExon;
 
-			if (estimation[i] == annotation[i]) {
-				result._nucleotidesSensitivity++;
-			}
-		}
+		// Nucleotide Sensitivity
+		result._numberCodingNucleotides += coding;
+		result._nucleotidesSensitivity += coding & equal;
 
 		// Nucleotide Specificity
-		if (annotation[i] == "E") {
-			result._numberExonNucleotides++;
+		result._numberExonNucleotides += exonBase;
+		result._nucleotidesSpecificity += exonBase & equal;
 
-			if (estimation[i] == annotation[i]) {
-				result._nucleotidesSpecificity++;
-			}
+		// Exon Sensitivity and Specificity. An exon counts when its end is reached.
+		result._numberExons += begins;
+		result._exonSpecificity += ends & exactlyMatched;
+		result._exonSensitivity += ends & matched & exonStart;
+
+		exonStart = begins ? equal : exonStart;
+		exactlyMatched = begins ? equal : exactlyMatched & equal;
+		isExon = exonBase;
+		matched = equal;
+	}
+
+	return result;
+}
+
+namespace {
+/**
+ * Decodes all sequences of evaluation with the help of the workers of pool and waits
+ * until they are finished.
+ */
+void runEvaluation(boost::shared_ptr<Evaluation> evaluation, ThreadPool* pool) {
+	int size = evaluation->_sequences.size();
+
+	for (int i = 0; i < size; i++) {
+		evaluation->_order.push_back(i);
+	}
+
+	// the longest sequences are decoded first so that the threads finish at about the
+	// same time
+	std::stable_sort(evaluation->_order.begin(), evaluation->_order.end(),
+			LongerSequence(evaluation->_sequences));
+
+	if (pool != NULL) {
+		int helpers = std::min(pool->size(), size - 1);
+
+		for (int i = 0; i < helpers; i++) {
+			pool->schedule(boost::bind(&evaluateSequences, evaluation));
 		}
+	}
 
-		// Exon Sensitivity
-		if (annotation[i] == "E") {
-			if (!isExon) {
-				isExon = true;
-				exonStart = exactlyMatched = annotation[i] == estimation[i];
-				result._numberExons++;
-			} else if (annotation[i] != estimation[i]) {
-				exactlyMatched = false;
-			}
-		} else {
-			if (isExon) {
-				isExon = false;
-				if (exactlyMatched)
-					result._exonSpecificity++;
-				if (matched && exonStart) {
-					result._exonSensitivity++;
+	evaluateSequences(evaluation);
+
+	boost::unique_lock<boost::mutex> lock(evaluation->_mutex);
+
+	while (evaluation->_active > 0) {
+		evaluation->_finished.wait(lock);
+	}
+
+	if (!evaluation->_error.empty()) {
+		throw std::runtime_error(evaluation->_error);
+	}
+}
+
+/**
+ * Returns hmm if it has state labels, otherwise a copy which is labeled by
+ * Models::veilMapping.
+ */
+boost::shared_ptr<HMMCompiled> labeledModel(boost::shared_ptr<HMMCompiled> hmm) {
+	// the states are labeled once instead of matching the state names for every position
+	if (hmm->hasStateLabels()) {
+		return hmm;
+	}
+
+	boost::shared_ptr<HMMCompiled> labeled(new HMMCompiled());
+	hmm->copy(labeled);
+	labeled->setStateLabels(Models::veilMapping);
+
+	return labeled;
+}
+}
+
+void Analytics::encodeAnnotations(
+		const std::vector<std::vector<std::string> >& annotations,
+		std::vector<std::vector<uint8_t> >& result) {
+	result.reserve(result.size() + annotations.size());
+
+	for (std::vector<std::vector<std::string> >::const_iterator it =
+			annotations.begin(); it != annotations.end(); ++it) {
+		result.push_back(std::vector<uint8_t>(it->size(), HMMTopology::NO_LABEL));
+
+		for (int t = 0; t < (int) it->size(); t++) {
+			for (int k = 0; k < DatabaseEntry::NUMBER_LABELS; k++) {
+				if ((*it)[t] == DatabaseEntry::getLabelName(k)) {
+					result.back()[t] = k;
+					break;
 				}
 			}
 		}
-		// matched stores the matching result of the preceding element
-		matched = annotation[i] == estimation[i];
 	}
+}
 
-	return result;
+Analytics::AnalyticsResult Analytics::analyse(
+		boost::shared_ptr<HMMCompiled> hmm,
+		const std::vector<std::vector<std::string> >& sequences,
+		const std::vector<std::vector<std::string> >& annotations,
+		ThreadPool* pool) {
+	std::vector<std::vector<uint8_t> > codes;
+
+	encodeAnnotations(annotations, codes);
+
+	return analyse(hmm, sequences, codes, pool);
 }
 
 Analytics::AnalyticsResult Analytics::analyse(
 		boost::shared_ptr<HMMCompiled> hmm,
 		const std::vector<std::vector<std::string> >& sequences,
-		const std::vector<std::vector<std::string> >& annotations) {
+		const std::vector<std::vector<uint8_t> >& annotations,
+		ThreadPool* pool) {
+	boost::shared_ptr<Evaluation> evaluation(
+			new Evaluation(labeledModel(hmm), sequences, annotations));
+
+	runEvaluation(evaluation, pool);
 
+	return analyse(evaluation->_sum);
+}
+
+void Analytics::analyse(boost::shared_ptr<HMMCompiled> hmm,
+		const std::vector<std::vector<std::string> >& sequences,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		std::vector<AnalyticsIntermediate>& intermediates, ThreadPool* pool) {
+	boost::shared_ptr<Evaluation> evaluation(
+			new Evaluation(labeledModel(hmm), sequences, annotations));
+
+	intermediates.assign(sequences.size(), AnalyticsIntermediate());
+	evaluation->_intermediates = &intermediates;
+
+	runEvaluation(evaluation, pool);
+}
+
+Analytics::AnalyticsResult Analytics::analyse(
+		const AnalyticsIntermediate& sum) {
 	AnalyticsResult result;
-	AnalyticsIntermediate intermediate;
-	AnalyticsIntermediate sum;
-	int counter = 0;
-
-	for (std::vector<std::vector<std::string> >::const_iterator at =
-			annotations.begin(), it = sequences.begin(); it != sequences.end();
-			++it, ++at) {
-		std::vector<int> states;
-		std::vector<std::string> namedStates;
-		std::vector<std::string> annotation;
-		// calculate the most likely state sequence
-		hmm->viterbi(*it, states);
-		// replace state id numbers by their names
-		hmm->ID2Name(states, namedStates);
-
-		// translate sequence of state name into DNA structure
-		Models::VeilAnnotation(namedStates, annotation);
-
-		// calculate the statistics
-		intermediate = analyse(annotation, *at);
-
-		sum += intermediate;
-
-		counter++;
-	}
 
 	result._exonSensitivity = ((double) sum._exonSensitivity)
 			/ sum._numberExons;
@@ -12,8 +12,10 @@
 #include <vector>
 #include <string>
 #include <ostream>
+#include <stdint.h>
 
 class HMMCompiled;
+class ThreadPool;
 
 /**
  * The functions in this namespace are used to evaluate a HMM given a test set of
@@ -29,15 +31,19 @@ struct AnalyticsResult {
 	AnalyticsResult();
 };
 
+/**
+ * Counts of a part of the test set. The counts of several parts can be summed up, thus
+ * they are 64 bit wide in order to not overflow for genome scale test sets.
+ */
 struct AnalyticsIntermediate {
-	int _nucleotidesSensitivity;
-	int _nucleotidesSpecificity;
-	int _exonSensitivity;
-	int _exonSpecificity;
-	int _numberExons;
-	int _numberNucleotides;
-	int _numberCodingNucleotides;
-	int _numberExonNucleotides;
+	int64_t _nucleotidesSensitivity;
+	int64_t _nucleotidesSpecificity;
+	int64_t _exonSensitivity;
+	int64_t _exonSpecificity;
+	int64_t _numberExons;
+	int64_t _numberNucleotides;
+	int64_t _numberCodingNucleotides;
+	int64_t _numberExonNucleotides;
 
 	AnalyticsIntermediate();
 
@@ -54,25 +60,72 @@ struct AnalyticsIntermediate {
  * Exon sensitivity: #exons for which the start and end is correctly predicted/#exons
  * Exon specificity: #correctly predicted exons/#exons
  *
+ * If pool is not NULL, then the sequences are decoded in parallel by the calling thread and
+ * the workers of pool, starting with the longest ones. The calling thread may be a worker
+ * of pool itself, since it only waits for the workers which have taken a sequence.
  */
 AnalyticsResult analyse(boost::shared_ptr<HMMCompiled> hmm,
 		const std::vector<std::vector<std::string> >& sequences,
-		const std::vector<std::vector<std::string> >& annotations);
+		const std::vector<std::vector<std::string> >& annotations,
+		ThreadPool* pool = NULL);
+
+/**
+ * This function does the same as the previous one, but the annotations are given as codes
+ * of DatabaseEntry::Label (see encodeAnnotations and DatabaseEntry::getAnnotation). Test
+ * sets which are evaluated repeatedly, e.g. in every iteration of the evaluation driven
+ * Baum-Welch algorithm, are thus encoded only once.
+ */
+AnalyticsResult analyse(boost::shared_ptr<HMMCompiled> hmm,
+		const std::vector<std::vector<std::string> >& sequences,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		ThreadPool* pool = NULL);
+
+/**
+ * Decodes every sequence like the previous function, but it stores the counts of every
+ * sequence in intermediates instead of summing them up. This allows to compute the
+ * accuracy of subsets of the sequences afterwards.
+ *
+ * @argument intermediates intermediates[i] = counts of the sequence i
+ */
+void analyse(boost::shared_ptr<HMMCompiled> hmm,
+		const std::vector<std::vector<std::string> >& sequences,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		std::vector<AnalyticsIntermediate>& intermediates, ThreadPool* pool =
+				NULL);
+
+/**
+ * Appends the annotations with the label names "U", "E", "I", "D" as codes of
+ * DatabaseEntry::Label to result. Other labels get the code HMMTopology::NO_LABEL, thus
+ * they never match a predicted label.
+ */
+void encodeAnnotations(
+		const std::vector<std::vector<std::string> >& annotations,
+		std::vector<std::vector<uint8_t> >& result);
+
+/**
+ * Calculates the accuracy values from the counts of intermediate.
+ */
+AnalyticsResult analyse(const AnalyticsIntermediate& intermediate);
 
 /**
  * Helper function used to count the correctly predicted bases and exons for
- * a predicted dna structure.
+ * a predicted dna structure. The structures are given as label codes (see
+ * HMMCompiled::setStateLabels) and they are compared in a single pass without
+ * branches.
  *
  * @argument estimation predicted DNA structure
  * @argument annotation correct DNA structure
+ * @argument exon code of the exon label
+ * @argument intron code of the intron label
  *
  * @return structure which contains the individual counts
  */
-AnalyticsIntermediate analyse(const std::vector<std::string>& estimation,
-		const std::vector<std::string>& annotation);
+AnalyticsIntermediate analyse(const std::vector<uint8_t>& estimation,
+		const std::vector<uint8_t>& annotation, uint8_t exon, uint8_t intron);
 double evaluate(boost::shared_ptr<HMMCompiled> hmm,
 		const std::vector<std::vector<std::string> >& sequences,
-		const std::vector<std::vector<std::string> >& annotations);
+		const std::vector<std::vector<std::string> >& annotations,
+		ThreadPool* pool = NULL);
 
 /**
  * This function calculates the arithmetic average of all 4 accuracy
@@ -0,0 +1,339 @@
+/*
+ * BgzfFile.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "BgzfFile.hpp"
+
+#include <stdexcept>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <zlib.h>
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "ThreadPool.hpp"
+
+namespace {
+// maximum size of the uncompressed data of a block
+const uint32_t MAX_BLOCK_SIZE = 65536;
+// CRC32 and size of the uncompressed data at the end of every block
+const uint32_t TRAILER_SIZE = 8;
+
+uint32_t readUInt16(const uint8_t* data) {
+	return data[0] | (data[1] << 8);
+}
+
+uint32_t readUInt32(const uint8_t* data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16)
+			| ((uint32_t) data[3] << 24);
+}
+
+uint64_t readUInt64(const uint8_t* data) {
+	return readUInt32(data) | ((uint64_t) readUInt32(data + 4) << 32);
+}
+
+std::invalid_argument corrupted(const std::string& message, uint64_t offset) {
+	std::ostringstream ss;
+
+	ss << "BgzfFile: " << message << " at offset " << offset << ".";
+
+	return std::invalid_argument(ss.str());
+}
+}
+
+BgzfFile::BgzfFile() :
+		_compressed(false), _size(0) {
+}
+
+bool BgzfFile::open(const std::string& filename) {
+	_blocks.clear();
+	_compressed = false;
+	_size = 0;
+
+	if (!_file.open(filename)) {
+		return false;
+	}
+
+	const uint8_t* data = (const uint8_t*) _file.data();
+	uint64_t size = _file.size();
+
+	// not compressed
+	if (size < 2 || data[0] != 31 || data[1] != 139) {
+		_size = size;
+		return true;
+	}
+
+	_compressed = true;
+
+	if (!readIndex(filename + ".gzi")) {
+		scanBlocks(0);
+	}
+
+	return true;
+}
+
+uint32_t BgzfFile::readHeader(uint64_t offset, uint32_t& headerSize) const {
+	const uint8_t* header = (const uint8_t*) _file.data() + offset;
+	uint64_t size = _file.size();
+	uint32_t blockSize = 0;
+
+	// gzip header with deflate compression and an extra field
+	if (size - offset < 18 || header[0] != 31 || header[1] != 139
+			|| header[2] != 8 || (header[3] & 4) == 0) {
+		throw corrupted("No BGZF block header", offset);
+	}
+
+	uint32_t extraLength = readUInt16(header + 10);
+
+	if (extraLength > size - offset - 12) {
+		throw corrupted("Truncated block header", offset);
+	}
+
+	// the subfield BC contains the size of the block minus 1
+	for (uint32_t i = 0; i + 4 <= extraLength;
+			i += 4 + readUInt16(header + 12 + i + 2)) {
+		const uint8_t* subfield = header + 12 + i;
+
+		if (subfield[0] == 'B' && subfield[1] == 'C'
+				&& readUInt16(subfield + 2) == 2 && i + 6 <= extraLength) {
+			blockSize = readUInt16(subfield + 4) + 1;
+			break;
+		}
+	}
+
+	headerSize = 12 + extraLength;
+
+	if (blockSize < headerSize + TRAILER_SIZE || blockSize > size - offset) {
+		throw corrupted("Invalid block size", offset);
+	}
+
+	return blockSize;
+}
+
+void BgzfFile::scanBlocks(uint64_t offset) {
+	const uint8_t* data = (const uint8_t*) _file.data();
+	uint64_t size = _file.size();
+
+	while (offset < size) {
+		Block block;
+		uint32_t headerSize;
+
+		block._offset = offset;
+		block._size = readHeader(offset, headerSize);
+		block._uncompressedOffset = _size;
+		block._uncompressedSize = readUInt32(data + offset + block._size - 4);
+
+		if (block._uncompressedSize > MAX_BLOCK_SIZE) {
+			throw corrupted("Invalid uncompressed block size", offset);
+		}
+
+		_blocks.push_back(block);
+		_size += block._uncompressedSize;
+		offset += block._size;
+	}
+}
+
+bool BgzfFile::readIndex(const std::string& filename) {
+	std::ifstream is;
+	uint8_t entry[16];
+	// the first block at offset 0 is not listed
+	std::vector<uint64_t> offsets(1, 0);
+	std::vector<uint64_t> uncompressedOffsets(1, 0);
+
+	is.open(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+
+	if (!is || !is.read((char*) entry, 8)) {
+		return false;
+	}
+
+	uint64_t number = readUInt64(entry);
+
+	// every block has a header of at least 18 bytes
+	if (number > _file.size() / 18) {
+		return false;
+	}
+
+	for (uint64_t k = 0; k < number; k++) {
+		if (!is.read((char*) entry, 16)) {
+			return false;
+		}
+
+		uint64_t offset = readUInt64(entry);
+		uint64_t uncompressedOffset = readUInt64(entry + 8);
+
+		if (offset <= offsets.back() || offset > _file.size()
+				|| offset - offsets.back() > MAX_BLOCK_SIZE
+				|| uncompressedOffset < uncompressedOffsets.back()
+				|| uncompressedOffset - uncompressedOffsets.back()
+						> MAX_BLOCK_SIZE) {
+			return false;
+		}
+
+		offsets.push_back(offset);
+		uncompressedOffsets.push_back(uncompressedOffset);
+	}
+
+	for (int k = 0; k + 1 < (int) offsets.size(); k++) {
+		Block block;
+
+		block._offset = offsets[k];
+		block._size = offsets[k + 1] - offsets[k];
+		block._uncompressedOffset = uncompressedOffsets[k];
+		block._uncompressedSize = uncompressedOffsets[k + 1]
+				- uncompressedOffsets[k];
+
+		_blocks.push_back(block);
+	}
+
+	_size = uncompressedOffsets.back();
+
+	// the last listed block is followed by the end of file marker at most
+	try {
+		scanBlocks(offsets.back());
+	} catch (std::invalid_argument& e) {
+		_blocks.clear();
+		_size = 0;
+
+		return false;
+	}
+
+	return true;
+}
+
+void BgzfFile::inflateBlock(const Block& block, char* output) const {
+	const uint8_t* data = (const uint8_t*) _file.data() + block._offset;
+	uint32_t headerSize;
+	z_stream stream;
+
+	// empty blocks, e.g. the end of file marker, carry no data
+	if (block._uncompressedSize == 0) {
+		return;
+	}
+
+	// the blocks of an index are checked when they are decompressed
+	if (readHeader(block._offset, headerSize) != block._size
+			|| readUInt32(data + block._size - 4) != block._uncompressedSize) {
+		throw corrupted("Block does not match the index", block._offset);
+	}
+
+	memset(&stream, 0, sizeof(stream));
+
+	// raw deflate data without gzip header
+	if (inflateInit2(&stream, -15) != Z_OK) {
+		throw std::invalid_argument("BgzfFile: zlib could not be initialized.");
+	}
+
+	stream.next_in = (Bytef*) (data + headerSize);
+	stream.avail_in = block._size - headerSize - TRAILER_SIZE;
+	stream.next_out = (Bytef*) output;
+	stream.avail_out = block._uncompressedSize;
+
+	int status = inflate(&stream, Z_FINISH);
+	uLong produced = stream.total_out;
+
+	inflateEnd(&stream);
+
+	if (status != Z_STREAM_END || produced != block._uncompressedSize
+			|| crc32(crc32(0, NULL, 0), (const Bytef*) output, produced)
+					!= readUInt32(data + block._size - TRAILER_SIZE)) {
+		throw corrupted("Corrupted block", block._offset);
+	}
+}
+
+void BgzfFile::inflateBlocks(int begin, int end, char* result) const {
+	for (int b = begin; b < end; b++) {
+		inflateBlock(_blocks[b], result + _blocks[b]._uncompressedOffset);
+	}
+}
+
+void BgzfFile::read(uint64_t begin, uint64_t end, std::string& result) const {
+	std::vector<char> buffer(MAX_BLOCK_SIZE);
+
+	result.clear();
+	end = std::min(end, _size);
+
+	if (begin >= end) {
+		return;
+	}
+
+	if (!_compressed) {
+		result.assign(_file.data() + begin, end - begin);
+		return;
+	}
+
+	result.reserve(end - begin);
+
+	// binary search of the last block which starts at or before begin
+	int low = 0;
+	int high = _blocks.size();
+
+	while (high - low > 1) {
+		int middle = (low + high) / 2;
+
+		if (_blocks[middle]._uncompressedOffset <= begin) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	for (int b = low;
+			b < (int) _blocks.size() && _blocks[b]._uncompressedOffset < end;
+			b++) {
+		const Block& block = _blocks[b];
+		uint64_t from = std::max(begin, block._uncompressedOffset);
+		uint64_t to = std::min(end,
+				block._uncompressedOffset + block._uncompressedSize);
+
+		if (from >= to) {
+			continue;
+		}
+
+		inflateBlock(block, &buffer[0]);
+		result.append(&buffer[from - block._uncompressedOffset], to - from);
+	}
+}
+
+void BgzfFile::readAll(std::vector<char>& result, int numberThreads) const {
+	result.resize(_size);
+
+	if (_size == 0) {
+		return;
+	}
+
+	if (!_compressed) {
+		std::copy(_file.data(), _file.data() + _size, result.begin());
+		return;
+	}
+
+	if (numberThreads <= 0) {
+		numberThreads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	// several jobs per thread balance blocks which compress differently
+	int numberJobs = std::min<int>(4 * numberThreads, _blocks.size());
+
+	if (numberJobs <= 1) {
+		inflateBlocks(0, _blocks.size(), &result[0]);
+		return;
+	}
+
+	ThreadPool pool(std::min(numberThreads, numberJobs));
+	ThreadPool::Batch batch;
+
+	for (int j = 0; j < numberJobs; j++) {
+		int begin = (long) _blocks.size() * j / numberJobs;
+		int end = (long) _blocks.size() * (j + 1) / numberJobs;
+
+		pool.schedule(batch,
+				boost::bind(&BgzfFile::inflateBlocks, this, begin, end,
+						&result[0]));
+	}
+
+	batch.wait();
+}
@@ -0,0 +1,130 @@
+/*
+ * BgzfFile.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef BGZFFILE_HPP_
+#define BGZFFILE_HPP_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <boost/utility.hpp>
+
+#include "MappedFile.hpp"
+
+/**
+ * This class reads a file which is compressed by bgzip (BGZF format) or not compressed at
+ * all. A BGZF file is a series of gzip members (blocks) of at most 64 KB uncompressed data
+ * each, whose compressed size is stored in an extra field of their header. Thus the block
+ * boundaries are found without decompressing anything, a range of the uncompressed data
+ * is read by decompressing only the blocks which contain it and the blocks of a full scan
+ * can be decompressed in parallel. Positions always refer to the uncompressed data.
+ * Corrupted blocks cause a std::invalid_argument.
+ */
+class BgzfFile: boost::noncopyable {
+private:
+	struct Block {
+		// position of the block in the file
+		uint64_t _offset;
+		// position of its data in the uncompressed data
+		uint64_t _uncompressedOffset;
+		// size of the block and its uncompressed data in bytes
+		uint32_t _size;
+		uint32_t _uncompressedSize;
+	};
+
+	MappedFile _file;
+	bool _compressed;
+	std::vector<Block> _blocks;
+	uint64_t _size;
+
+	/**
+	 * Reads the gzip header of the block at offset.
+	 *
+	 * @argument headerSize is set to the size of the header
+	 * @return size of the block
+	 */
+	uint32_t readHeader(uint64_t offset, uint32_t& headerSize) const;
+
+	/**
+	 * Appends the blocks from offset up to the end of the file to _blocks by reading
+	 * their headers.
+	 */
+	void scanBlocks(uint64_t offset);
+
+	/**
+	 * Takes the blocks from the bgzip index filename, which lists the compressed and
+	 * uncompressed offset of every block except the first one.
+	 *
+	 * @return false if the index does not exist or does not match the file
+	 */
+	bool readIndex(const std::string& filename);
+
+	/**
+	 * Decompresses block into output, which has room for block._uncompressedSize bytes.
+	 */
+	void inflateBlock(const Block& block, char* output) const;
+
+	/**
+	 * Decompresses the blocks begin,...,end-1 into result at their uncompressed positions.
+	 */
+	void inflateBlocks(int begin, int end, char* result) const;
+
+public:
+	BgzfFile();
+
+	/**
+	 * Opens filename. If it starts with a gzip header, then the block offsets are taken
+	 * from the index filename.gzi written by bgzip -i. Without a (matching) index the
+	 * headers of all blocks are read. A file without gzip header is read as uncompressed
+	 * file.
+	 *
+	 * @return false if the file could not be opened
+	 */
+	bool open(const std::string& filename);
+
+	bool isCompressed() const {
+		return _compressed;
+	}
+
+	/**
+	 * Returns the mapped data of a file which is not compressed, thus it can be read
+	 * without a copy (see readAll). It is NULL if the file is compressed.
+	 */
+	const char* data() const {
+		return _compressed ? NULL : _file.data();
+	}
+
+	/**
+	 * Returns the size of the uncompressed data.
+	 */
+	uint64_t size() const {
+		return _size;
+	}
+
+	/**
+	 * Returns the number of BGZF blocks, 0 if the file is not compressed.
+	 */
+	int getNumberBlocks() const {
+		return _blocks.size();
+	}
+
+	/**
+	 * Stores the uncompressed bytes begin,...,end-1 in result. Only the blocks which
+	 * contain these bytes are decompressed. Several threads can read concurrently.
+	 */
+	void read(uint64_t begin, uint64_t end, std::string& result) const;
+
+	/**
+	 * Stores the complete uncompressed data in result. The blocks are decompressed by
+	 * numberThreads threads, one per hardware thread if numberThreads is not positive.
+	 */
+	void readAll(std::vector<char>& result, int numberThreads = 0) const;
+};
+
+#endif /* BGZFFILE_HPP_ */
@@ -8,220 +8,355 @@
 #include "CrossValidation.hpp"
 
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
 
 #include "HMMCompiled.hpp"
 #include "HMM.hpp"
 #include "Analytics.hpp"
 #include "Models.hpp"
 #include "GeneDatabase.hpp"
+#include "ThreadPool.hpp"
+#include "RestartScheduler.hpp"
+#include "StoppingPolicy.hpp"
+#include "SequenceBatch.hpp"
 
 boost::shared_ptr<HMMCompiled> CrossValidation::crossValidation(
 		boost::shared_ptr<HMMCompiled> compiled,
 		const std::vector<std::vector<std::string> >& trainingSet,
-		double threshold, int tries, int testsetSize) {
+		double threshold, int tries, int testsetSize, int numberThreads,
+		int roundIterations, double keepFraction, unsigned int seed) {
+	SequenceBatch batch(trainingSet);
+
+	return crossValidation(compiled, batch, threshold, tries, testsetSize,
+			numberThreads, roundIterations, keepFraction, seed);
+}
+
+boost::shared_ptr<HMMCompiled> CrossValidation::crossValidation(
+		boost::shared_ptr<HMMCompiled> compiled,
+		const SequenceBatch& trainingSet, double threshold, int tries,
+		int testsetSize, int numberThreads, int roundIterations,
+		double keepFraction, unsigned int seed) {
 	boost::shared_ptr<HMMCompiled> result;
 
 	// if the hmm contains random probabilities
 	if (compiled->isRandom()) {
-		double* match = new double[tries];
-		boost::shared_ptr<HMMCompiled>* hmms =
-				new boost::shared_ptr<HMMCompiled>[tries];
+		std::vector<double> match(tries, 0);
+		std::vector<double> scores;
+		std::vector<boost::shared_ptr<HMMCompiled> > hmms(tries);
+		std::vector<bool> active(tries, true);
+		ThreadPool pool(numberThreads);
+		RestartScheduler scheduler(pool, roundIterations, keepFraction);
 		double max = -std::numeric_limits<double>::infinity();
 		int maxIdx = -1;
 
 		// intialise all tries
 		for (int i = 0; i < tries; i++) {
-			match[i] = 0;
 			hmms[i] = boost::shared_ptr<HMMCompiled>(new HMMCompiled());
 			compiled->copy(hmms[i]);
-			hmms[i]->initProbabilities();
+			// every try has its own reproducible random stream
+			HMMCompiled::RandomGenerator random(
+					(boost::random::mt19937(seed + i)));
+			hmms[i]->initProbabilities(random);
 		}
 
 		for (int n = 0; n < trainingSet.size(); n += testsetSize) {
-			int end = std::min((int) trainingSet.size(), n + testsetSize);
+			int end = std::min(trainingSet.size(), n + testsetSize);
 			std::cout << "Testset:" << n << ":" << end << std::endl;
 
-			// get training and test set from the original set
-			std::vector<std::vector<std::string> > testset(
-					trainingSet.begin() + n, trainingSet.begin() + end);
-			std::vector<std::vector<std::string> > set(trainingSet.begin(),
-					trainingSet.begin() + n);
-			set.insert(set.end(), trainingSet.begin() + end, trainingSet.end());
+			// get training and test set from the original set. The views only select
+			// the sequences by their indices.
+			SequenceBatch::View testset;
+			SequenceBatch::View set;
+			trainingSet.fold(n, end, set, testset);
 
-			for (int i = 0; i < tries; i++) {
-				hmms[i]->baumWelch(set, threshold);
-
-				std::cout << hmms[i]->toString() << std::endl;
+			// evaluate accuracy by the likelihood of the test set
+			scheduler.learn(hmms, active, set, NULL, threshold,
+					boost::bind(&RestartScheduler::likelihoodScore,
+							boost::placeholders::_1, boost::cref(testset)),
+					scores);
 
-				// evaluate accuracy
-				for (std::vector<std::vector<std::string> >::const_iterator tests =
-						testset.begin(); tests != testset.end(); ++tests) {
-					double prob = hmms[i]->forward(*tests);
+			for (int i = 0; i < tries; i++) {
+				if (active[i]) {
+					std::cout << hmms[i]->toString() << std::endl;
 
-					if (prob != -std::numeric_limits<double>::infinity())
-						match[i] += prob;
+					match[i] += scores[i];
 				}
 			}
 		}
 
-		// choose best fitting instance
+		// choose best fitting instance among the tries which have not been culled
 		for (int i = 0; i < tries; i++) {
-			std::cout << "Match[" << i << "]:" << match[i] << std::endl;
-			if (max < match[i]) {
-				max = match[i];
-				maxIdx = i;
+			if (active[i]) {
+				std::cout << "Match[" << i << "]:" << match[i] << std::endl;
+				if (maxIdx == -1 || max < match[i]) {
+					max = match[i];
+					maxIdx = i;
+				}
 			}
 		}
 
 		result = hmms[maxIdx];
 
-		delete[] match;
-		delete[] hmms;
-
 		return result;
 	} else {
 		result = boost::shared_ptr<HMMCompiled>(new HMMCompiled());
 		compiled->copy(result);
 
-		result->baumWelch(trainingSet, threshold);
+		result->baumWelch(SequenceBatch::View(trainingSet), threshold);
 	}
 
 	return result;
 }
 
+void CrossValidation::learnTry(const LearningContext& context,
+		boost::shared_ptr<HMMCompiled> chmm, const Fold& fold,
+		Analytics::AnalyticsResult* analyticsResult, double* matchingScore) {
+	const std::string& errorEvaluation = context._errorEvaluation;
+	const boost::unordered_map<std::string, std::string>& symbolMap =
+			context._symbolMap;
+	bool substituted = context._substituted;
+	bool labelConstrained = context._labelConstrained;
+	double threshold = context._threshold;
+
+	if (errorEvaluation == "Accelerated") {
+		if (labelConstrained) {
+			chmm->acceleratedBaumWelch(fold._sequences,
+					fold._trainingAnnotations, threshold);
+		} else {
+			chmm->acceleratedBaumWelch(fold._sequences, threshold);
+		}
+
+		if (substituted) {
+			// for the analysis it is necessary to have a HMM
+			// which emits the plain bases (A,C,G,T) --> project
+			// the annotated emissions onto the bases.
+			chmm->projectEmissions(symbolMap, chmm);
+		}
+
+		*analyticsResult = Analytics::analyse(chmm, fold._testset,
+				fold._annotations, &context._pool);
+
+	} else if (errorEvaluation == "Evaluation" || errorEvaluation == "Sampled") {
+		// a tenth of the test set is evaluated in most iterations
+		SampledEvaluation sampled(
+				std::max(1, (int) fold._testset.size() / 10));
+
+		*analyticsResult = chmm->baumWelch(symbolMap, fold._sequences,
+				fold._testset, fold._annotations, threshold, substituted,
+				labelConstrained ? &fold._trainingAnnotations : NULL,
+				&context._pool,
+				errorEvaluation == "Sampled" ? &sampled : NULL);
+
+	} else if (errorEvaluation == "Iteration") {
+		*analyticsResult = chmm->baumWelchIterated(symbolMap, fold._sequences,
+				fold._testset, fold._annotations, (int) threshold, substituted,
+				labelConstrained ? &fold._trainingAnnotations : NULL,
+				&context._pool);
+	} else {
+		throw std::invalid_argument(
+				"modelLearning: Unknown error evaluation " + errorEvaluation
+						+ ".");
+	}
+
+	*matchingScore = Analytics::evaluate(*analyticsResult);
+}
+
+void CrossValidation::learnFold(const LearningContext& context, int fold,
+		std::vector<boost::shared_ptr<HMMCompiled> >& tries) {
+	int start = fold * context._testsetSize;
+	int end = std::min((int) context._entries.size(),
+			start + context._testsetSize);
+	std::vector<double> matchingScore(tries.size(),
+			-std::numeric_limits<double>::infinity());
+	std::vector<Analytics::AnalyticsResult> analyticsResult(tries.size());
+	Fold data = { DatabaseSequences(context._substituted) };
+
+	// get the training set, test set and the corresponding structure information
+	if (context._labelConstrained) {
+		GeneDatabase::separateSet(context._entries, data._sequences,
+				data._trainingAnnotations, data._testset, data._annotations,
+				start, end);
+	} else {
+		GeneDatabase::separateSet(context._entries, data._sequences,
+				data._testset, data._annotations, start, end);
+	}
+
+	if (context._errorEvaluation == "Threshold") {
+		// learn the tries in parallel and cull the bad ones after every round
+		std::vector<bool> active(tries.size(), true);
+		std::vector<double> scores;
+
+		context._scheduler.learn(tries, active, data._sequences,
+				context._labelConstrained ? &data._trainingAnnotations : NULL,
+				context._threshold,
+				boost::bind(&RestartScheduler::evaluationScore,
+						boost::placeholders::_1,
+						context._substituted ? &context._symbolMap : NULL,
+						boost::cref(data._testset),
+						boost::cref(data._annotations)), scores);
+
+		for (int j = 0; j < tries.size(); j++) {
+			if (active[j]) {
+				if (context._substituted) {
+					// for the analysis it is necessary to have a HMM
+					// which emits the plain bases (A,C,G,T) --> project
+					// the annotated emissions onto the bases.
+					tries[j]->projectEmissions(context._symbolMap, tries[j]);
+				}
+
+				analyticsResult[j] = Analytics::analyse(tries[j],
+						data._testset, data._annotations, &context._pool);
+				matchingScore[j] = Analytics::evaluate(analyticsResult[j]);
+			}
+		}
+	} else {
+		ThreadPool::Batch batch;
+
+		for (int j = 0; j < tries.size(); j++) {
+			context._pool.schedule(batch,
+					boost::bind(&CrossValidation::learnTry,
+							boost::cref(context), tries[j], boost::cref(data),
+							&analyticsResult[j], &matchingScore[j]));
+		}
+
+		batch.wait();
+	}
+
+	int maxIdx = 0;
+	double maxValue = matchingScore[0];
+
+	for (int j = 1; j < tries.size(); j++) {
+		if (maxValue < matchingScore[j]) {
+			maxIdx = j;
+			maxValue = matchingScore[j];
+		}
+	}
+
+	std::stringstream ss;
+	std::ofstream os;
+
+	ss << context._prefix << "modelTestset" << (fold + 1) << ".hmm";
+
+	// the HMM is shared by all folds
+	boost::lock_guard<boost::mutex> lock(context._mutex);
+
+	std::cout << "Testset:" << (fold + 1) << std::endl;
+	std::cout << analyticsResult[maxIdx] << std::endl << std::endl;
+
+	os.open(ss.str().c_str(), std::ios_base::out);
+
+	if (context._substituted)
+		context._hmm->substituteEmissions(context._inverseSubstitution);
+	context._hmm->update(tries[maxIdx]);
+	// save the best learned HMM for later usages
+	context._hmm->serialize(os);
+
+	if (context._substituted)
+		context._hmm->substituteEmissions(context._substitution);
+
+	os.close();
+}
+
+void CrossValidation::runFolds(const LearningContext& context,
+		std::vector<std::vector<boost::shared_ptr<HMMCompiled> > >& tries,
+		std::vector<std::string>& errors) {
+	while (true) {
+		int fold;
+
+		{
+			boost::lock_guard<boost::mutex> lock(context._mutex);
+			fold = context._nextFold++;
+		}
+
+		if (fold >= (int) tries.size()) {
+			return;
+		}
+
+		try {
+			learnFold(context, fold, tries[fold]);
+		} catch (std::exception& e) {
+			errors[fold] = e.what();
+		}
+	}
+}
+
 void CrossValidation::modelLearning(const std::string& prefix,
 		boost::shared_ptr<HMM> hmm, const std::vector<DatabaseEntry*>& entries,
 		int testsetSize, int tries, const std::string& errorEvaluation,
-		double threshold, bool annotated) {
+		double threshold, bool annotated, bool labelConstrained,
+		int numberThreads, int roundIterations, double keepFraction,
+		unsigned int seed) {
 	int numberTestsets = std::ceil((double) entries.size() / testsetSize);
-	int numberSequences = entries.size();
-
-	double matchingScore[numberTestsets][tries];
-	boost::shared_ptr<HMMCompiled> chmms[numberTestsets][tries];
-	Analytics::AnalyticsResult analyticsResult[numberTestsets][tries];
+	// chmms[i][j] = j-th try of the i-th testset
+	std::vector<std::vector<boost::shared_ptr<HMMCompiled> > > chmms(
+			numberTestsets, std::vector<boost::shared_ptr<HMMCompiled> >(tries));
+	std::vector<std::string> errors(numberTestsets);
 	boost::shared_ptr<HMMCompiled> chmm(new HMMCompiled());
-	boost::unordered_map<std::string,
-			boost::unordered_map<std::string, std::string> > substitution;
-	boost::unordered_map<std::string,
-			boost::unordered_map<std::string, std::string> > inverseSubstitution;
-	std::vector<std::vector<std::string> > sequences;
-	std::vector<std::vector<std::string> > annotations;
-	std::vector<std::vector<std::string> > testset;
-	std::stringstream ss;
-	std::ofstream os;
-
-	Models::createAnnotatedSubstitution(substitution);
-	Models::createInverseAnnotatedSubstitution(inverseSubstitution);
+	ThreadPool pool(numberThreads);
+	RestartScheduler scheduler(pool, roundIterations, keepFraction);
+	boost::thread_group folds;
+	// the label constrained learning uses the plain emissions
+	bool substituted = annotated && !labelConstrained;
+	LearningContext context = { prefix, hmm, entries, testsetSize,
+			errorEvaluation, threshold, substituted, annotated
+					&& labelConstrained, pool, scheduler };
+
+	Models::createAnnotatedSubstitution(context._substitution);
+	Models::createInverseAnnotatedSubstitution(context._inverseSubstitution);
+	Models::createInverseAnnotatedSymbolMap(context._symbolMap);
 
 	// change emissions if the sequences are annotated because the model was intended
 	// to work with not annotated sequences.
-	if (annotated)
-		hmm->substituteEmissions(substitution);
+	if (substituted)
+		hmm->substituteEmissions(context._substitution);
 
 	// Translate the HMM to a version which is more suited for computations
-	hmm->compile(chmm);
+	hmm->compile(chmm, true);
+
+	// the labels are needed for the label constrained learning and the analysis
+	chmm->setStateLabels(Models::veilMapping);
 
 	assert(chmm->isRandom());
 
 	// initialize for every try a HMM
 	for (int j = 0; j < tries; j++) {
-		matchingScore[0][j] = -std::numeric_limits<double>::infinity();
 		chmms[0][j] = boost::shared_ptr<HMMCompiled>(new HMMCompiled());
 		chmm->copy(chmms[0][j]);
-		chmms[0][j]->initProbabilities();
+		// every try has its own reproducible random stream
+		HMMCompiled::RandomGenerator random((boost::random::mt19937(seed + j)));
+		chmms[0][j]->initProbabilities(random);
 	}
 
 	// but for the same try use the same initial HMM for every testset possible
 	for (int i = 1; i < numberTestsets; i++) {
 		for (int j = 0; j < tries; j++) {
-			matchingScore[i][j] = -std::numeric_limits<double>::infinity();
 			chmms[i][j] = boost::shared_ptr<HMMCompiled>(new HMMCompiled());
 
 			chmms[0][j]->copy(chmms[i][j]);
 		}
 	}
 
-	for (int start = 0, i = 0; start < numberSequences;
-			start += testsetSize, i++) {
-		int end = std::min(numberSequences, start + testsetSize);
-
-		sequences.clear();
-		testset.clear();
-		annotations.clear();
-		// get the training set, test set and the corresponding structure information
-		GeneDatabase::separateSet(entries, sequences, testset, annotations,
-				annotated, start, end);
-
-		for (int j = 0; j < tries; j++) {
-			if (errorEvaluation == "Threshold") {
-				chmms[i][j]->baumWelch(sequences, threshold);
+	// the testsets are learned concurrently by at most one driver per worker. Their tries
+	// are learned by the shared pool and every fold writes its best HMM as soon as it has
+	// finished.
+	int numberDrivers = std::min(numberTestsets, pool.size());
 
-				if (annotated) {
-					// for the analysis it is necessary to have a HMM
-					// which emits the plain bases (A,C,G,T) --> apply
-					// the inverse substitution. Unfortunately we sill
-					// have to take the detour using the class HMM because
-					// HMMCompiled supports no substitution.
-					hmm->update(chmms[i][j]);
-					hmm->substituteEmissions(inverseSubstitution);
-					hmm->compile(chmms[i][j]);
-					hmm->substituteEmissions(substitution);
-				}
+	context._nextFold = 0;
 
-				analyticsResult[i][j] = Analytics::analyse(chmms[i][j], testset,
-						annotations);
-				matchingScore[i][j] = Analytics::evaluate(
-						analyticsResult[i][j]);
-
-			} else if (errorEvaluation == "Evaluation") {
-				analyticsResult[i][j] = chmms[i][j]->baumWelch(hmm,
-						substitution, inverseSubstitution, sequences, testset,
-						annotations, threshold, annotated);
-				matchingScore[i][j] = Analytics::evaluate(
-						analyticsResult[i][j]);
-
-			} else if (errorEvaluation == "Iteration") {
-				analyticsResult[i][j] = chmms[i][j]->baumWelchIterated(hmm,
-						substitution, inverseSubstitution, sequences, testset,
-						annotations, (int) threshold, annotated);
-				matchingScore[i][j] = Analytics::evaluate(
-						analyticsResult[i][j]);
-			}
-		}
+	for (int i = 0; i < numberDrivers; i++) {
+		folds.create_thread(
+				boost::bind(&CrossValidation::runFolds, boost::cref(context),
+						boost::ref(chmms), boost::ref(errors)));
+	}
 
-		int maxIdx = 0;
-		int maxValue = matchingScore[i][0];
+	folds.join_all();
 
-		for (int j = 1; j < tries; j++) {
-			if (maxValue < matchingScore[i][j]) {
-				maxIdx = j;
-				maxValue = matchingScore[i][j];
-			}
+	for (int i = 0; i < numberTestsets; i++) {
+		if (!errors[i].empty()) {
+			throw std::runtime_error(errors[i]);
 		}
-
-		chmm = chmms[i][maxIdx];
-
-		Analytics::AnalyticsResult result = analyticsResult[i][maxIdx];
-
-		std::cout << "Testset:" << (i + 1) << std::endl;
-		std::cout << result << std::endl << std::endl;
-
-		ss.str(std::string());
-		ss.clear();
-		ss << prefix << "modelTestset" << (i + 1) << ".hmm";
-
-		os.open(ss.str().c_str(), std::ios_base::out);
-
-		if (annotated)
-			hmm->substituteEmissions(inverseSubstitution);
-		hmm->update(chmm);
-		// save the best learned HMM for later usages
-		hmm->serialize(os);
-
-		if (annotated)
-			hmm->substituteEmissions(substitution);
-
-		os.close();
 	}
 }
-
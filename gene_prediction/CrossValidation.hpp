@@ -9,14 +9,97 @@
 #define CROSSVALIDATION_HPP_
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <vector>
+#include <string>
+
+#include "DatabaseSequences.hpp"
 
 class HMMCompiled;
 class DatabaseEntry;
 class HMM;
+class ThreadPool;
+class RestartScheduler;
+class SequenceBatch;
+
+namespace Analytics {
+struct AnalyticsResult;
+}
 
 class CrossValidation {
+private:
+	/**
+	 * Training and testing data of one turn of the model learning.
+	 */
+	struct Fold {
+		// training sequences, which are encoded from the entries when they are read
+		DatabaseSequences _sequences;
+		// structure labels of the training sequences for the label constrained learning
+		std::vector<std::vector<std::string> > _trainingAnnotations;
+		std::vector<std::vector<std::string> > _testset;
+		// structure labels of the testing set as codes of DatabaseEntry::Label, which are
+		// compared in every evaluation of the fold
+		std::vector<std::vector<uint8_t> > _annotations;
+	};
+
+	/**
+	 * Settings and shared state of the model learning which are used by all folds.
+	 */
+	struct LearningContext {
+		const std::string& _prefix;
+		boost::shared_ptr<HMM> _hmm;
+		const std::vector<DatabaseEntry*>& _entries;
+		int _testsetSize;
+		const std::string& _errorEvaluation;
+		double _threshold;
+		// whether the HMM emits annotated symbols
+		bool _substituted;
+		bool _labelConstrained;
+		ThreadPool& _pool;
+		RestartScheduler& _scheduler;
+		boost::unordered_map<std::string,
+				boost::unordered_map<std::string, std::string> > _substitution;
+		boost::unordered_map<std::string,
+				boost::unordered_map<std::string, std::string> > _inverseSubstitution;
+		boost::unordered_map<std::string, std::string> _symbolMap;
+		// guards _hmm, the output and _nextFold
+		mutable boost::mutex _mutex;
+		// index of the next testset which is learned by a fold driver (see runFolds)
+		mutable int _nextFold;
+	};
+
+	/**
+	 * This function learns the tries of the fold-th testset, selects the best one and
+	 * saves it in the file <prefix>modelTestset<fold+1>.hmm.
+	 */
+	static void learnFold(const LearningContext& context, int fold,
+			std::vector<boost::shared_ptr<HMMCompiled> >& tries);
+
+	/**
+	 * This function is the main loop of a fold driver thread. It runs learnFold for the
+	 * next testset until all testsets are learned, thus the number of folds which are
+	 * held in memory is bounded by the number of drivers. The message of an exception
+	 * of the i-th testset is stored in errors[i].
+	 *
+	 * @argument tries tries[i] = tries of the i-th testset
+	 */
+	static void runFolds(const LearningContext& context,
+			std::vector<std::vector<boost::shared_ptr<HMMCompiled> > >& tries,
+			std::vector<std::string>& errors);
+
+	/**
+	 * This function learns a single try of the model learning with one of the error
+	 * evaluations "Accelerated", "Evaluation", "Sampled" or "Iteration" and stores its analytics
+	 * result and its matching score. If the HMM emits annotated symbols, then chmm is
+	 * projected onto the plain bases afterwards. The test set is evaluated with the help
+	 * of the idle workers of the pool of context.
+	 */
+	static void learnTry(const LearningContext& context,
+			boost::shared_ptr<HMMCompiled> chmm, const Fold& fold,
+			Analytics::AnalyticsResult* analyticsResult, double* matchingScore);
+
 public:
 	/**
 	 * This function learns a HMM from a given training set. Furthermore, it selects the best fitting model,
@@ -38,13 +121,31 @@ public:
 	 * @argument tries if the HMM contains random probabilities, the model is tries times randomly
 	 * 	instantiated. For each instantiation, the model is learned and the best fitting model returned
 	 * @argument testingSize defines the size of testing set which is extracted in each turn from the training set
+	 * @argument numberThreads number of threads which learn the tries in parallel. If it is not positive,
+	 * 	then one thread per hardware thread is used.
+	 * @argument roundIterations number of Baum-Welch iterations after which the tries are compared
+	 * @argument keepFraction fraction of the tries which is kept after every comparison, the others are
+	 * 	not learned any further (see RestartScheduler). 1 keeps all tries.
+	 * @argument seed the random stream of the i-th try is seeded with seed+i
 	 *
 	 * @return learned HMM
 	 */
 	static boost::shared_ptr<HMMCompiled> crossValidation(
 			boost::shared_ptr<HMMCompiled> compiled,
 			const std::vector<std::vector<std::string> >& trainingSet,
-			double threshold, int tries, int testingSize);
+			double threshold, int tries, int testingSize,
+			int numberThreads = 0, int roundIterations = 5,
+			double keepFraction = 0.5, unsigned int seed = 0);
+
+	/**
+	 * This function does the same as the previous one on the sequences of a SequenceBatch.
+	 * The folds are views onto the batch, thus no sequence is copied.
+	 */
+	static boost::shared_ptr<HMMCompiled> crossValidation(
+			boost::shared_ptr<HMMCompiled> compiled,
+			const SequenceBatch& trainingSet, double threshold, int tries,
+			int testingSize, int numberThreads = 0, int roundIterations = 5,
+			double keepFraction = 0.5, unsigned int seed = 0);
 
 	/**
 	 * This function learns the probabilities of a given HMM with respect to the provided training data set
@@ -55,7 +156,8 @@ public:
 	 * each turn, the HMM will be reset to its initial probabilities. If the HMM contains random probabilities,
 	 * they are initialized once in the beginning and reused for every new testing set. Furthermore it is possible
 	 * to learn several randomly initialized HMM and select the best one. The selection criteria is the average
-	 * accuracy of the prediction of the testing set.
+	 * accuracy of the prediction of the testing set. The runs are independent of each other and are executed
+	 * concurrently. The best HMM of every run is saved as soon as the run has finished.
 	 *
 	 * @argument prefix string wich is appended to the file name of the result files containing the learned HMM
 	 * 	for every testing set
@@ -67,18 +169,33 @@ public:
 	 * @argument errorEvalution a string specifying the termination criteria for the learning algorithm.
 	 * 	The current options are:
 	 * 		"Threshold" with threshold used as a threshold for the maximum probability change in order to
-	 * 		stop the learning.
+	 * 		stop the learning. The tries are compared by their average accuracy every roundIterations
+	 * 		iterations and only the best keepFraction of them is learned further.
 	 * 		"Evaluation" with threshold used as the maximum worsening of the average accuracy value
 	 * 		between 2 iterations, otherwise the algorithm stops
+	 * 		"Sampled" like "Evaluation", but most iterations evaluate only a sample of a tenth of
+	 * 		the testing set (see SampledEvaluation)
 	 * 		"Iteration" with threshold used as the maximum number of iterations before stopping
+	 * 		"Accelerated" like "Threshold", but the learning is accelerated by SQUAREM (see
+	 * 		HMMCompiled::acceleratedBaumWelch)
 	 * @argument annotated defines whether sequences annotated by their structure information or the plain
 	 * 	sequences shall be used for the learning algorithm
+	 * @argument labelConstrained if the sequences are annotated, this defines whether the structure
+	 * 	information is used by restricting every base to the states with a matching label (see
+	 * 	Models::veilMapping) instead of substituting the emissions by annotated symbols
+	 * @argument numberThreads number of threads which learn the tries in parallel. If it is not positive,
+	 * 	then one thread per hardware thread is used.
+	 * @argument roundIterations number of Baum-Welch iterations after which the tries are compared
+	 * @argument keepFraction fraction of the tries which is kept after every comparison
+	 * @argument seed the random stream of the j-th try is seeded with seed+j
 	 */
 	static void modelLearning(const std::string& prefix,
 			boost::shared_ptr<HMM> hmm,
 			const std::vector<DatabaseEntry*>& entries, int testsetSize,
 			int tries, const std::string& errorEvaluation, double threshold,
-			bool annotated = true);
+			bool annotated = true, bool labelConstrained = false,
+			int numberThreads = 0, int roundIterations = 5,
+			double keepFraction = 0.5, unsigned int seed = 0);
 };
 
 #endif /* CROSSVALIDATION_HPP_ */
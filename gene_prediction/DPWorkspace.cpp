@@ -0,0 +1,131 @@
+/*
+ * DPWorkspace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "DPWorkspace.hpp"
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+const std::size_t DPWorkspace::ALIGNMENT;
+const std::size_t DPWorkspace::HUGE_PAGE_SIZE;
+
+DPWorkspace::DPWorkspace(bool hugePages) :
+		_used(0), _inUse(0), _highWaterMark(0), _hugePages(hugePages) {
+}
+
+DPWorkspace::~DPWorkspace() {
+	for (std::vector<Block>::const_iterator it = _blocks.begin();
+			it != _blocks.end(); ++it) {
+		freeBlock(*it);
+	}
+}
+
+void DPWorkspace::addBlock(std::size_t size) {
+	Block block;
+	block._memory = NULL;
+	block._size = size;
+	block._mapped = false;
+
+	if (_hugePages && size >= HUGE_PAGE_SIZE) {
+		block._size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE
+				* HUGE_PAGE_SIZE;
+
+		void* memory = mmap(NULL, block._size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (memory != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+			madvise(memory, block._size, MADV_HUGEPAGE);
+#endif
+			block._memory = static_cast<char*>(memory);
+			block._mapped = true;
+		}
+	}
+
+	// fall back to the ordinary allocator
+	if (block._memory == NULL) {
+		void* memory;
+
+		if (posix_memalign(&memory, ALIGNMENT, block._size) != 0) {
+			throw std::bad_alloc();
+		}
+
+		block._memory = static_cast<char*>(memory);
+	}
+
+	_blocks.push_back(block);
+	_used = 0;
+}
+
+void DPWorkspace::freeBlock(const Block& block) {
+	if (block._mapped) {
+		munmap(block._memory, block._size);
+	} else {
+		free(block._memory);
+	}
+}
+
+char* DPWorkspace::allocate(std::size_t bytes) {
+	// keep every buffer aligned
+	bytes = std::max(ALIGNMENT,
+			(bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+
+	if (_blocks.empty() || _used + bytes > _blocks.back()._size) {
+		addBlock(std::max(bytes, getCapacity()));
+	}
+
+	char* result = _blocks.back()._memory + _used;
+
+	_used += bytes;
+	_inUse += bytes;
+	_highWaterMark = std::max(_highWaterMark, _inUse);
+
+	return result;
+}
+
+void DPWorkspace::reset() {
+	// a run which needed several blocks gets a single one next time
+	if (_blocks.size() > 1) {
+		std::size_t capacity = getCapacity();
+
+		for (std::vector<Block>::const_iterator it = _blocks.begin();
+				it != _blocks.end(); ++it) {
+			freeBlock(*it);
+		}
+
+		_blocks.clear();
+		addBlock(capacity);
+	}
+
+	_used = 0;
+	_inUse = 0;
+}
+
+double* DPWorkspace::getDoubles(std::size_t size) {
+	return reinterpret_cast<double*>(allocate(size * sizeof(double)));
+}
+
+int* DPWorkspace::getInts(std::size_t size) {
+	return reinterpret_cast<int*>(allocate(size * sizeof(int)));
+}
+
+std::size_t DPWorkspace::getHighWaterMark() const {
+	return _highWaterMark;
+}
+
+std::size_t DPWorkspace::getCapacity() const {
+	std::size_t result = 0;
+
+	for (std::vector<Block>::const_iterator it = _blocks.begin();
+			it != _blocks.end(); ++it) {
+		result += it->_size;
+	}
+
+	return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * DPWorkspace.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef DPWORKSPACE_HPP_
+#define DPWORKSPACE_HPP_
+
+#include <vector>
+#include <cstddef>
+
+#include <boost/utility.hpp>
+
+/**
+ * This class contains the scratch memory of the dynamic programming algorithms (forward,
+ * backward, viterbi, Baum-Welch) of HMMCompiled. It is an arena: The buffers of one run
+ * are handed out one after another from a single block and are released all together by
+ * reset. The block grows to the largest run seen and is kept between the calls, thus a
+ * thread which processes many sequences allocates memory only a few times. Every buffer
+ * is aligned to ALIGNMENT bytes. Every thread needs its own workspace, whereas the
+ * HMMCompiled itself can be shared.
+ */
+class DPWorkspace: boost::noncopyable {
+public:
+	// alignment of every buffer in bytes (cache line size)
+	static const std::size_t ALIGNMENT = 64;
+	// size of a huge page in bytes
+	static const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+private:
+	struct Block {
+		char* _memory;
+		std::size_t _size;
+		// whether the block was allocated by mmap instead of posix_memalign
+		bool _mapped;
+	};
+
+	// blocks of the current run, the last one is used for new buffers
+	std::vector<Block> _blocks;
+	// used bytes of the last block
+	std::size_t _used;
+	// bytes handed out since the last reset
+	std::size_t _inUse;
+	std::size_t _highWaterMark;
+	bool _hugePages;
+
+	/**
+	 * Returns bytes bytes of memory aligned to ALIGNMENT.
+	 */
+	char* allocate(std::size_t bytes);
+
+	/**
+	 * Allocates a new block of at least size bytes and appends it to _blocks.
+	 */
+	void addBlock(std::size_t size);
+
+	static void freeBlock(const Block& block);
+
+public:
+	/**
+	 * @argument hugePages if true, blocks of at least HUGE_PAGE_SIZE bytes are mapped
+	 * 	separately and advised to be backed by transparent huge pages. This reduces the
+	 * 	TLB misses for long sequences.
+	 */
+	DPWorkspace(bool hugePages = false);
+	~DPWorkspace();
+
+	/**
+	 * Releases all buffers handed out so far. If the last run needed several blocks,
+	 * they are replaced by a single block which is large enough for the whole run.
+	 */
+	void reset();
+
+	/**
+	 * Returns an aligned buffer of size doubles. It is valid until the next reset.
+	 */
+	double* getDoubles(std::size_t size);
+
+	/**
+	 * Returns an aligned buffer of size ints. It is valid until the next reset.
+	 */
+	int* getInts(std::size_t size);
+
+	/**
+	 * Returns the maximum number of bytes which were in use at the same time.
+	 */
+	std::size_t getHighWaterMark() const;
+
+	/**
+	 * Returns the number of bytes currently allocated by this workspace.
+	 */
+	std::size_t getCapacity() const;
+};
+
+#endif /* DPWORKSPACE_HPP_ */
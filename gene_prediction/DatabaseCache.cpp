@@ -0,0 +1,273 @@
+/*
+ * DatabaseCache.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "DatabaseCache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/shared_ptr.hpp>
+
+#include "GeneDatabase.hpp"
+#include "DatabaseEntry.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+const char MAGIC[8] = { 'G', 'P', 'D', 'B', 'C', 'A', 'C', 'H' };
+// is read as another number on a host with another byte order
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct Header {
+	char _magic[8];
+	uint32_t _version;
+	uint32_t _byteOrder;
+	uint64_t _numberSources;
+	uint64_t _numberEntries;
+	uint64_t _index;
+	uint64_t _size;
+};
+
+/**
+ * Index record of an entry. The offsets are relative to the start of the file.
+ */
+struct IndexRecord {
+	uint64_t _id;
+	uint32_t _idLength;
+	int32_t _size;
+	uint64_t _bases;
+	uint64_t _ambiguous;
+	uint64_t _exons;
+	uint32_t _numberExons;
+	uint32_t _padding;
+};
+
+struct SmallerID {
+	bool operator()(const DatabaseEntry* a, const DatabaseEntry* b) const {
+		return a->getID() < b->getID();
+	}
+};
+
+/**
+ * Writes size bytes of data to os and advances offset by size.
+ */
+void writeBytes(std::ostream& os, const void* data, std::size_t size,
+		uint64_t& offset) {
+	if (size > 0) {
+		os.write((const char*) data, size);
+	}
+
+	offset += size;
+}
+
+/**
+ * Writes zeros until offset is a multiple of alignment.
+ */
+void align(std::ostream& os, uint64_t alignment, uint64_t& offset) {
+	const char zeros[8] = { 0 };
+
+	writeBytes(os, zeros, (alignment - offset % alignment) % alignment, offset);
+}
+
+/**
+ * Returns true if the length bytes at offset are contained in a file of size bytes.
+ */
+bool contained(uint64_t offset, uint64_t length, uint64_t size) {
+	return offset <= size && length <= size - offset;
+}
+}
+
+void DatabaseCache::stamp(const std::vector<std::string>& filenames,
+		std::vector<Stamp>& stamps) {
+	stamps.clear();
+
+	for (std::vector<std::string>::const_iterator it = filenames.begin();
+			it != filenames.end(); ++it) {
+		struct stat status;
+		Stamp stamp;
+
+		memset(&stamp, 0, sizeof(stamp));
+
+		if (stat(it->c_str(), &status) == 0) {
+			stamp._size = status.st_size;
+			stamp._modified = status.st_mtim.tv_sec;
+			stamp._modifiedNanoseconds = status.st_mtim.tv_nsec;
+			stamp._device = status.st_dev;
+			stamp._inode = status.st_ino;
+		}
+
+		stamps.push_back(stamp);
+	}
+}
+
+bool DatabaseCache::write(const std::string& filename,
+		const GeneDatabase& database, const std::vector<Stamp>& stamps) {
+	std::vector<const DatabaseEntry*> entries;
+	std::vector<IndexRecord> index;
+	std::ostringstream temporary;
+	std::ofstream os;
+	Header header;
+	uint64_t offset = 0;
+
+	for (boost::unordered_map<std::string, DatabaseEntry>::const_iterator it =
+			database.getEntries().begin(); it != database.getEntries().end();
+			++it) {
+		entries.push_back(&it->second);
+	}
+
+	std::sort(entries.begin(), entries.end(), SmallerID());
+
+	temporary << filename << ".tmp." << getpid();
+
+	os.open(temporary.str().c_str(), std::ios_base::out | std::ios_base::binary);
+
+	if (!os) {
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._byteOrder = BYTE_ORDER_MARK;
+	header._numberSources = stamps.size();
+	header._numberEntries = entries.size();
+
+	// the header is written again when the offset of the index is known
+	writeBytes(os, &header, sizeof(header), offset);
+
+	if (!stamps.empty()) {
+		writeBytes(os, &stamps[0], stamps.size() * sizeof(Stamp), offset);
+	}
+
+	for (std::vector<const DatabaseEntry*>::const_iterator it = entries.begin();
+			it != entries.end(); ++it) {
+		const PackedSequence& data = (*it)->getData();
+		const std::vector<Pair<int> >& exons = (*it)->getExons();
+		IndexRecord record;
+
+		memset(&record, 0, sizeof(record));
+
+		record._id = offset;
+		record._idLength = (*it)->getID().size();
+		writeBytes(os, (*it)->getID().data(), record._idLength, offset);
+
+		record._size = data.size();
+		record._bases = offset;
+		writeBytes(os, data.getPackedBases(), (data.size() + 3) / 4, offset);
+		record._ambiguous = offset;
+		writeBytes(os, data.getPackedAmbiguous(), (data.size() + 7) / 8,
+				offset);
+
+		align(os, 4, offset);
+		record._exons = offset;
+		record._numberExons = exons.size();
+
+		for (std::vector<Pair<int> >::const_iterator exon = exons.begin();
+				exon != exons.end(); ++exon) {
+			int32_t bounds[2] = { exon->_first, exon->_second };
+
+			writeBytes(os, bounds, sizeof(bounds), offset);
+		}
+
+		index.push_back(record);
+	}
+
+	align(os, 8, offset);
+	header._index = offset;
+
+	if (!index.empty()) {
+		writeBytes(os, &index[0], index.size() * sizeof(IndexRecord), offset);
+	}
+
+	header._size = offset;
+
+	os.seekp(0);
+	os.write((const char*) &header, sizeof(header));
+	os.close();
+
+	if (!os || std::rename(temporary.str().c_str(), filename.c_str()) != 0) {
+		std::remove(temporary.str().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool DatabaseCache::read(const std::string& filename, GeneDatabase& database,
+		const std::vector<Stamp>& stamps) {
+	boost::shared_ptr<MappedFile> file(new MappedFile());
+	std::vector<IndexRecord> index;
+	Header header;
+
+	// the entries are accessed in any order
+	if (!file->open(filename, false) || file->size() < sizeof(header)) {
+		return false;
+	}
+
+	const char* data = file->data();
+	uint64_t size = file->size();
+
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header._magic, MAGIC, sizeof(MAGIC)) != 0
+			|| header._version != VERSION
+			|| header._byteOrder != BYTE_ORDER_MARK
+			|| header._numberSources != stamps.size() || header._size != size
+			|| !contained(sizeof(header), stamps.size() * sizeof(Stamp), size)
+			|| (!stamps.empty()
+					&& memcmp(data + sizeof(header), &stamps[0],
+							stamps.size() * sizeof(Stamp)) != 0)
+			|| header._numberEntries > size / sizeof(IndexRecord)
+			|| !contained(header._index,
+					header._numberEntries * sizeof(IndexRecord), size)) {
+		return false;
+	}
+
+	index.resize(header._numberEntries);
+
+	if (!index.empty()) {
+		memcpy(&index[0], data + header._index,
+				index.size() * sizeof(IndexRecord));
+	}
+
+	// check all records before the database is changed
+	for (std::vector<IndexRecord>::const_iterator it = index.begin();
+			it != index.end(); ++it) {
+		if (it->_size < 0 || !contained(it->_id, it->_idLength, size)
+				|| !contained(it->_bases, ((uint64_t) it->_size + 3) / 4, size)
+				|| !contained(it->_ambiguous, ((uint64_t) it->_size + 7) / 8,
+						size)
+				|| !contained(it->_exons,
+						(uint64_t) it->_numberExons * 2 * sizeof(int32_t),
+						size)) {
+			return false;
+		}
+	}
+
+	for (std::vector<IndexRecord>::const_iterator it = index.begin();
+			it != index.end(); ++it) {
+		std::string id(data + it->_id, it->_idLength);
+		PackedSequence sequence(file, (const uint8_t*) data + it->_bases,
+				(const uint8_t*) data + it->_ambiguous, it->_size);
+		DatabaseEntry entry(id, sequence);
+
+		for (uint32_t e = 0; e < it->_numberExons; e++) {
+			int32_t bounds[2];
+
+			memcpy(bounds, data + it->_exons + e * sizeof(bounds),
+					sizeof(bounds));
+			entry.addExon(bounds[0], bounds[1]);
+		}
+
+		database.getEntries().emplace(id, entry);
+	}
+
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * DatabaseCache.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef DATABASECACHE_HPP_
+#define DATABASECACHE_HPP_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class GeneDatabase;
+
+/**
+ * The functions in this namespace store a GeneDatabase in a binary cache file, which is
+ * memory mapped instead of parsing the fasta and CDS files again. The file consists of
+ *
+ * - a header: magic "GPDBCACH", version, byte order mark, number of source files,
+ * 		number of entries, offset of the index and size of the file,
+ * - the stamps of the source files (see Stamp),
+ * - the data of every entry: identifier, packed bases, ambiguity bitmap (see
+ * 		PackedSequence::getPackedBases) and exons as pairs of 32 bit integers,
+ * - the index: one record per entry, sorted by identifier, with the offsets and
+ * 		lengths of its data.
+ *
+ * Numbers are stored in the byte order of the host. A cache with another version, byte
+ * order or other stamps of the source files is ignored.
+ */
+namespace DatabaseCache {
+/**
+ * Version of the file format. It has to be increased whenever the format changes.
+ */
+const uint32_t VERSION = 2;
+
+/**
+ * Identifies the state of a source file by its metadata, thus the cache is validated
+ * without reading the sources. A file which is rewritten or replaced changes its size,
+ * modification time or inode.
+ */
+struct Stamp {
+	uint64_t _size;
+	int64_t _modified;
+	int64_t _modifiedNanoseconds;
+	uint64_t _device;
+	uint64_t _inode;
+};
+
+/**
+ * Stores the stamps of the files filenames in stamps. The stamp of a file which does
+ * not exist is zero.
+ */
+void stamp(const std::vector<std::string>& filenames,
+		std::vector<Stamp>& stamps);
+
+/**
+ * Writes the entries of database to the cache file filename. The file is written under
+ * a temporary name and renamed afterwards, thus other processes never map a partially
+ * written cache.
+ *
+ * @argument stamps stamps of the source files of database (see stamp)
+ * @return false if the file could not be written
+ */
+bool write(const std::string& filename, const GeneDatabase& database,
+		const std::vector<Stamp>& stamps);
+
+/**
+ * Adds the entries of the cache file filename to database. The packed sequences of the
+ * entries reference the mapped file, thus processes which read the same cache share
+ * its pages.
+ *
+ * @argument stamps stamps of the current source files (see stamp)
+ * @return false if the file does not exist, is corrupted or is not up to date. Then
+ * 		database is not changed.
+ */
+bool read(const std::string& filename, GeneDatabase& database,
+		const std::vector<Stamp>& stamps);
+}
+
+#endif /* DATABASECACHE_HPP_ */
@@ -10,12 +10,19 @@
 #include <sstream>
 #include <iostream>
 #include <stdlib.h>
+#include <algorithm>
+
+#include "SequenceBatch.hpp"
 
 boost::random::uniform_01<boost::random::mt19937> DatabaseEntry::_random(boost::random::mt19937(time(NULL)));
 
-DatabaseEntry::DatabaseEntry(const std::string& id, const std::vector<std::string>& data):
-	_id(id),_data(data){
-	instantiateData();
+DatabaseEntry::DatabaseEntry(const std::string& id, const std::string& data):
+	_id(id),_data(data,_random){
+}
+
+DatabaseEntry::DatabaseEntry(const std::string& id, PackedSequence& data):
+	_id(id){
+	_data.swap(data);
 }
 
 DatabaseEntry::DatabaseEntry(){
@@ -28,7 +35,7 @@ std::string DatabaseEntry::toString() const{
 	ss << "ID:" << _id << std::endl;
 
 	for(int i=0; i< _data.size(); i++){
-		ss << _data[i];
+		ss << PackedSequence::getSymbol(_data[i]);
 	}
 
 	ss<< std::endl;
@@ -44,36 +51,6 @@ std::string DatabaseEntry::toString() const{
 	return ss.str();
 }
 
-void DatabaseEntry::instantiateData(){
-	std::string alphabet[] = {"A","C","G","T"};
-	for(int i=0; i< _data.size(); i++){
-		if(_data[i] == "N"){
-			// N = {A,C,G,T}
-			_data[i] = alphabet[(int)(4*_random())];
-		}
-		if(_data[i] == "R"){
-			// R = {A,G}
-			_data[i] = alphabet[2*(int)(2*_random())];
-		}
-		if(_data[i] == "B"){
-			// B = {C,G,T}
-			_data[i] = alphabet[(int)(3*_random())+1];
-		}
-		if(_data[i] == "Y"){
-			// Y = {C,T}
-			_data[i] = alphabet[(int)(2*_random())*2+1];
-		}
-		if(_data[i] == "S"){
-			// S = {C,G}
-			_data[i] = alphabet[(int)(2*_random())+1];
-		}
-		if(_data[i] == "K"){
-			// K = {G,T}
-			_data[i] = alphabet[(int)(2*_random())+2];
-		}
-	}
-}
-
 void DatabaseEntry::addExon(int start,int end){
 	_exons.push_back(Pair<int>(start,end));
 }
@@ -83,9 +60,9 @@ void DatabaseEntry::addExon(int start,int end){
  */
 void DatabaseEntry::extractExons(std::vector<std::vector<std::string> >& result) const{
 	for(int i =0; i< _exons.size(); i++){
-		std::vector<std::string>::const_iterator it = _data.begin();
+		std::vector<std::string> exon;
 
-		std::vector<std::string> exon(it+_exons[i]._first-1,it+_exons[i]._second);
+		_data.decode(_exons[i]._first-1,_exons[i]._second,exon);
 		result.push_back(exon);
 	}
 }
@@ -97,7 +74,9 @@ void DatabaseEntry::extractIntrons(std::vector<std::vector<std::string> >& resul
 	if(_exons.size() > 0){
 		int start = _exons[0]._second;
 		for(int i=1; i< _exons.size();i++){
-			std::vector<std::string> exon(_data.begin()+start,_data.begin()+_exons[i]._first-1);
+			std::vector<std::string> exon;
+
+			_data.decode(start,_exons[i]._first-1,exon);
 			result.push_back(exon);
 			start = _exons[i]._second;
 		}
@@ -109,7 +88,9 @@ void DatabaseEntry::extractIntrons(std::vector<std::vector<std::string> >& resul
  */
 void DatabaseEntry::extractDownstream(std::vector<std::vector<std::string> > & result) const{
 	if(_exons.size() >0){
-		std::vector<std::string> exon(_data.begin()+_exons[_exons.size()-1]._second,_data.end());
+		std::vector<std::string> exon;
+
+		_data.decode(_exons[_exons.size()-1]._second,_data.size(),exon);
 		result.push_back(exon);
 	}
 }
@@ -119,37 +100,106 @@ void DatabaseEntry::extractDownstream(std::vector<std::vector<std::string> > & r
  */
 void DatabaseEntry::extractUpstream(std::vector<std::vector<std::string> >& result) const{
 	if(_exons.size() >0){
-		std::vector<std::string> exon(_data.begin(),_data.begin()+_exons[0]._first-1);
+		std::vector<std::string> exon;
+
+		_data.decode(0,_exons[0]._first-1,exon);
 		result.push_back(exon);
 	}else{
-		std::vector<std::string> exon(_data.begin(),_data.end());
+		std::vector<std::string> exon;
+
+		_data.decode(0,_data.size(),exon);
 		result.push_back(exon);
 	}
 }
 
 void DatabaseEntry::extractSequence(std::vector<std::vector<std::string> >& result) const{
-	std::vector<std::string> sequence(_data);
+	std::vector<std::string> sequence;
 
+	_data.decode(0,_data.size(),sequence);
 	result.push_back(sequence);
 }
 
+void DatabaseEntry::extractSequence(SequenceBatch& result) const{
+	result.add(_data,0,_data.size());
+}
+
 void DatabaseEntry::extractAnnotatedSequence(std::vector<std::vector<std::string> >& result) const{
-	std::vector<std::string> annotation;
-	getAnnotation(annotation);
-	std::stringstream ss;
+	std::vector<int> codes(_data.size());
+	std::string symbols[NUMBER_LABELS*4];
+	int identity[NUMBER_LABELS*4];
 
-	std::vector<std::string> sequence;
+	for(int c=0; c<NUMBER_LABELS*4; c++){
+		symbols[c] = getLabelName(c/4) + PackedSequence::getSymbol(c%4);
+		identity[c] = c;
+	}
+
+	if(!codes.empty()){
+		encodeAnnotatedSequence(identity,&codes[0]);
+	}
 
-	for(int i=0; i<_data.size();i++){
-		ss.str("");
-		ss.clear();
-		ss << annotation[i];
-		ss << _data[i];
+	result.push_back(std::vector<std::string>());
+	result.back().reserve(codes.size());
 
-		sequence.push_back(ss.str());
+	for(int i=0; i<codes.size(); i++){
+		result.back().push_back(symbols[codes[i]]);
 	}
+}
 
-	result.push_back(sequence);
+void DatabaseEntry::extractAnnotatedSequence(SequenceBatch& result) const{
+	std::vector<int> codes(_data.size());
+	std::vector<std::string> symbols;
+	int identity[NUMBER_LABELS*4];
+
+	for(int c=0; c<NUMBER_LABELS*4; c++){
+		symbols.push_back(getLabelName(c/4) + PackedSequence::getSymbol(c%4));
+		identity[c] = c;
+	}
+
+	if(!codes.empty()){
+		encodeAnnotatedSequence(identity,&codes[0]);
+	}
+
+	result.add(codes.empty() ? NULL : &codes[0],codes.size(),symbols);
+}
+
+int DatabaseEntry::encodeRun(int label, int begin, int end, const int* table, int* symbols) const{
+	end = std::min(end,_data.size());
+
+	if(begin >= end){
+		return begin;
+	}
+
+	// table+label*4 are the symbol ids of the bases with this label
+	_data.encode(table+label*4,begin,end,symbols+begin);
+
+	return end;
+}
+
+void DatabaseEntry::encodeAnnotatedSequence(const int* table, int* symbols) const{
+	int position = 0;
+
+	// DNA structure: Upstream, Exon, {Intron,Exon}*, Downstream
+	if(_exons.size() > 0){
+		position = encodeRun(UPSTREAM,position,_exons[0]._first-1,table,symbols);
+
+		for(int i=0; i<_exons.size(); i++){
+			position = encodeRun(EXON,position,_exons[i]._second,table,symbols);
+
+			if(i < _exons.size()-1){
+				position = encodeRun(INTRON,position,_exons[i+1]._first-1,table,symbols);
+			}
+		}
+
+		encodeRun(DOWNSTREAM,position,_data.size(),table,symbols);
+	}else{
+		encodeRun(UPSTREAM,position,_data.size(),table,symbols);
+	}
+}
+
+const std::string& DatabaseEntry::getLabelName(int label){
+	static const std::string names[NUMBER_LABELS] = {"U","E","I","D"};
+
+	return names[label];
 }
 
 void DatabaseEntry::getAnnotation(std::vector<std::string>& result) const{
@@ -181,10 +231,35 @@ void DatabaseEntry::getAnnotation(std::vector<std::string>& result) const{
 	}
 }
 
+void DatabaseEntry::getAnnotation(std::vector<uint8_t>& result) const{
+	result.reserve(result.size()+_data.size());
+
+	if(_exons.size() >0){
+		result.insert(result.end(),std::max(_exons[0]._first-1,0),UPSTREAM);
+
+		for(int i=0; i<_exons.size();i++){
+			result.insert(result.end(),std::max(_exons[i]._second-_exons[i]._first+1,0),EXON);
+
+			if(i < _exons.size()-1){
+				result.insert(result.end(),std::max(_exons[i+1]._first-_exons[i]._second-1,0),INTRON);
+			}
+		}
+
+		result.insert(result.end(),std::max(_data.size()-_exons[_exons.size()-1]._second,0),DOWNSTREAM);
+	}else{
+		result.insert(result.end(),_data.size(),UPSTREAM);
+	}
+}
+
 void DatabaseEntry::extractAnnotation(std::vector<std::vector<std::string> >& result) const{
 	std::vector<std::string> annotation;
 	getAnnotation(annotation);
 	result.push_back(annotation);
 }
 
+void DatabaseEntry::extractAnnotation(std::vector<std::vector<uint8_t> >& result) const{
+	result.push_back(std::vector<uint8_t>());
+	getAnnotation(result.back());
+}
+
 
@@ -13,6 +13,9 @@
 #include <boost/random.hpp>
 
 #include "Pair.hpp"
+#include "PackedSequence.hpp"
+
+class SequenceBatch;
 
 /**
  * This class represents a DNA sequence and its structure by defining the
@@ -23,15 +26,48 @@ private:
 	static boost::random::uniform_01<boost::random::mt19937> _random;
 
 	std::string _id;
-	std::vector<std::string> _data;
+	// DNA sequence with 2 bits per base
+	PackedSequence _data;
 	/*
 	 * Each pair characterizes an exon. The first number is the starting
 	 * index and the second number is the ending index. The element at
 	 * the ending index belongs also to the exon.
 	 */
 	std::vector<Pair<int> > _exons;
+
+	/**
+	 * Stores table[label*4+b] for the bases b of the positions begin,...,min(end,size)-1
+	 * in symbols.
+	 *
+	 * @return position after the run
+	 */
+	int encodeRun(int label, int begin, int end, const int* table, int* symbols) const;
 public:
-	DatabaseEntry(const std::string& id, const std::vector<std::string>& data);
+	/**
+	 * Codes of the structure labels of the annotation (see getAnnotation).
+	 */
+	enum Label{
+		UPSTREAM = 0, EXON = 1, INTRON = 2, DOWNSTREAM = 3
+	};
+
+	static const int NUMBER_LABELS = 4;
+
+	/**
+	 * Returns the name ("U", "E", "I", "D") of the label with the code label.
+	 */
+	static const std::string& getLabelName(int label);
+
+	/**
+	 * Creates an entry for the DNA sequence data which is given by IUPAC nucleotide codes.
+	 * Ambiguity codes (placeholders for a subset of bases) are randomly instantiated with
+	 * one of their bases.
+	 */
+	DatabaseEntry(const std::string& id, const std::string& data);
+
+	/**
+	 * Creates an entry which takes over the bases of data. data is empty afterwards.
+	 */
+	DatabaseEntry(const std::string& id, PackedSequence& data);
 	DatabaseEntry();
 
 	std::string toString() const;
@@ -63,11 +99,35 @@ public:
 	 */
 	void extractSequence(std::vector<std::vector<std::string> >& result) const;
 
+	/**
+	 * Append the complete sequence to the batch result. The bases are copied without
+	 * creating strings.
+	 */
+	void extractSequence(SequenceBatch& result) const;
+
 	/**
 	 * Fill the result with the complete structure annotated sequence
 	 */
 	void extractAnnotatedSequence(std::vector<std::vector<std::string> >& result) const;
 
+	/**
+	 * Append the complete structure annotated sequence to the batch result. The composite
+	 * codes (see encodeAnnotatedSequence) are added without creating strings per base.
+	 */
+	void extractAnnotatedSequence(SequenceBatch& result) const;
+
+	/**
+	 * Stores for every base of the sequence the symbol id table[label*4+base] in symbols,
+	 * where label is the code of its structure label and base the code of the base (see
+	 * PackedSequence). The composite code of a base is thus computed when it is read and
+	 * the annotated symbol ("EA", "IC", ...) is never created. The symbols of the composite
+	 * codes are getLabelName(label) followed by PackedSequence::getSymbol(base).
+	 *
+	 * @argument table symbol ids of the 16 composite codes
+	 * @argument symbols array of size getData().size()
+	 */
+	void encodeAnnotatedSequence(const int* table, int* symbols) const;
+
 	/**
 	 * Fill annotation with structure information of this DNA sequence. For every
 	 * base there is one element in annotation. "E" denoting an exon, "I" denoting
@@ -76,15 +136,28 @@ public:
 	void getAnnotation(std::vector<std::string>& annotation) const;
 
 	/**
-	 * Fill result with the structure annotation
+	 * Fill annotation with the codes (see Label) of the structure labels of this DNA
+	 * sequence. They are computed from the exon intervals without creating strings.
 	 */
-	void extractAnnotation(std::vector<std::vector<std::string> >& result) const;
+	void getAnnotation(std::vector<uint8_t>& annotation) const;
 
 	/**
-	 * If the initial sequence contains placeholders for a subset of bases (A,C,G,T) those are
-	 * randomly instantiated with a base.
+	 * Fill result with the structure annotation
 	 */
-	void instantiateData();
+	void extractAnnotation(std::vector<std::vector<std::string> >& result) const;
+	void extractAnnotation(std::vector<std::vector<uint8_t> >& result) const;
+
+	const PackedSequence& getData() const {
+		return _data;
+	}
+
+	const std::string& getID() const {
+		return _id;
+	}
+
+	const std::vector<Pair<int> >& getExons() const {
+		return _exons;
+	}
 };
 
 
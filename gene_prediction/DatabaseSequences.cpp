@@ -0,0 +1,67 @@
+/*
+ * DatabaseSequences.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "DatabaseSequences.hpp"
+
+#include "DatabaseEntry.hpp"
+#include "PackedSequence.hpp"
+
+namespace {
+/**
+ * Symbols of the codes of the plain and of the annotated bases.
+ */
+struct Alphabets {
+	std::vector<std::string> _plain;
+	std::vector<std::string> _annotated;
+
+	Alphabets() {
+		for (int b = 0; b < 4; b++) {
+			_plain.push_back(PackedSequence::getSymbol(b));
+		}
+
+		for (int label = 0; label < DatabaseEntry::NUMBER_LABELS; label++) {
+			for (int b = 0; b < 4; b++) {
+				_annotated.push_back(
+						DatabaseEntry::getLabelName(label)
+								+ PackedSequence::getSymbol(b));
+			}
+		}
+	}
+};
+
+const Alphabets& getAlphabets() {
+	static const Alphabets alphabets;
+
+	return alphabets;
+}
+}
+
+DatabaseSequences::DatabaseSequences(bool annotated) :
+		_annotated(annotated) {
+}
+
+void DatabaseSequences::add(const DatabaseEntry* entry) {
+	_entries.push_back(entry);
+}
+
+int DatabaseSequences::getLength(int k) const {
+	return _entries[k]->getData().size();
+}
+
+const std::vector<std::string>& DatabaseSequences::getAlphabet() const {
+	return _annotated ? getAlphabets()._annotated : getAlphabets()._plain;
+}
+
+void DatabaseSequences::encode(int k, const int* table, int* symbols) const {
+	const PackedSequence& data = _entries[k]->getData();
+
+	if (_annotated) {
+		_entries[k]->encodeAnnotatedSequence(table, symbols);
+	} else {
+		data.encode(table, 0, data.size(), symbols);
+	}
+}
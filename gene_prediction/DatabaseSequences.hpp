@@ -0,0 +1,58 @@
+/*
+ * DatabaseSequences.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef DATABASESEQUENCES_HPP_
+#define DATABASESEQUENCES_HPP_
+
+#include <vector>
+#include <string>
+
+#include "EncodedSequences.hpp"
+
+class DatabaseEntry;
+
+/**
+ * This class presents the DNA sequences of database entries to the training of
+ * HMMCompiled without copying them. The symbol codes are computed from the packed bases
+ * when a sequence is read. If the sequences are annotated, then the code of a base is
+ * label*4+base, where label is the code of its structure label (see
+ * DatabaseEntry::encodeAnnotatedSequence). Its symbol is the same as the one of
+ * DatabaseEntry::extractAnnotatedSequence, e.g. "EA" for an adenine of an exon. The
+ * entries have to live as long as this object.
+ */
+class DatabaseSequences: public EncodedSequences {
+private:
+	std::vector<const DatabaseEntry*> _entries;
+	bool _annotated;
+
+public:
+	/**
+	 * @argument annotated whether the bases are combined with their structure labels
+	 */
+	DatabaseSequences(bool annotated = false);
+
+	void add(const DatabaseEntry* entry);
+
+	bool isAnnotated() const {
+		return _annotated;
+	}
+
+	int size() const {
+		return _entries.size();
+	}
+
+	int getLength(int k) const;
+
+	/**
+	 * Returns the plain bases "A", "C", "G", "T" or the 16 annotated symbols.
+	 */
+	const std::vector<std::string>& getAlphabet() const;
+
+	void encode(int k, const int* table, int* symbols) const;
+};
+
+#endif /* DATABASESEQUENCES_HPP_ */
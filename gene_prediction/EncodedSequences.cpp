@@ -0,0 +1,11 @@
+/*
+ * EncodedSequences.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "EncodedSequences.hpp"
+
+EncodedSequences::~EncodedSequences() {
+}
@@ -0,0 +1,47 @@
+/*
+ * EncodedSequences.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef ENCODEDSEQUENCES_HPP_
+#define ENCODEDSEQUENCES_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * This class represents a set of sequences whose symbols are given by integer codes of a
+ * small alphabet: the code c stands for the symbol getAlphabet()[c]. The training of
+ * HMMCompiled reads the sequences only through encode, thus an implementation may store
+ * the codes (see SequenceBatch) or compute them when a sequence is read (see
+ * DatabaseSequences).
+ */
+class EncodedSequences {
+public:
+	virtual ~EncodedSequences();
+
+	virtual int size() const = 0;
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	/**
+	 * Returns the number of symbols of the k-th sequence.
+	 */
+	virtual int getLength(int k) const = 0;
+
+	/**
+	 * Returns the symbols which the codes stand for.
+	 */
+	virtual const std::vector<std::string>& getAlphabet() const = 0;
+
+	/**
+	 * Stores table[c] for the code c of every symbol of the k-th sequence in symbols.
+	 */
+	virtual void encode(int k, const int* table, int* symbols) const = 0;
+};
+
+#endif /* ENCODEDSEQUENCES_HPP_ */
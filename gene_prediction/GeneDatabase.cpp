@@ -12,54 +12,305 @@
 #include <iostream>
 #include <stdlib.h>
 #include <sstream>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "SequenceBatch.hpp"
+#include "DatabaseSequences.hpp"
+#include "DatabaseCache.hpp"
+#include "BgzfFile.hpp"
+#include "PackedSequence.hpp"
+#include "ThreadPool.hpp"
 
 GeneDatabase::GeneDatabase() {
 }
 
-void GeneDatabase::importFile(const std::string& filename) {
-	std::ifstream is;
-	std::string line;
-	std::string id = "";
-	std::vector<std::string> buffer;
-	std::stringstream ss;
-	std::string token;
+namespace {
+/**
+ * Result of parsing a piece of a fasta file. A piece starts at the beginning of a line and
+ * it is split into segments at the identifier lines. The first segment continues the
+ * record of the previous piece if the piece does not start with an identifier line.
+ */
+struct FastaPiece {
+	const char* _begin;
+	const char* _end;
+	bool _continued;
+	std::vector<std::string> _ids;
+	std::vector<PackedSequence> _sequences;
+};
 
-	is.open(filename.c_str(), std::ios_base::in);
+// pieces which are smaller are not worth a job of their own
+const std::size_t MIN_PIECE_SIZE = 1 << 20;
+// the random generator for the ambiguity codes is seeded again at the first line after
+// every multiple of SEED_INTERVAL, at which the pieces start as well
+const std::size_t SEED_INTERVAL = 1 << 16;
 
-	if (!is) {
-		std::cerr << "Could not open file:" << filename << std::endl;
+/**
+ * Returns the position of the first identifier line in position,...,end-1 or end if
+ * there is none. data is the start of the file.
+ */
+const char* findRecord(const char* data, const char* position,
+		const char* end) {
+	while (position < end) {
+		const char* marker = (const char*) memchr(position, '>', end - position);
+
+		if (marker == NULL) {
+			return end;
+		}
+
+		if (marker == data || marker[-1] == '\n') {
+			return marker;
+		}
+
+		position = marker + 1;
+	}
+
+	return end;
+}
+
+/**
+ * Returns the start of the line after position or end.
+ */
+const char* nextLine(const char* position, const char* end) {
+	const char* newline = (const char*) memchr(position, '\n', end - position);
+
+	return newline != NULL ? newline + 1 : end;
+}
+
+/**
+ * Returns the start of the first line at or after position, which is the start of the
+ * file data or follows a line break.
+ */
+const char* lineStart(const char* data, const char* position,
+		const char* end) {
+	if (position == data || position[-1] == '\n') {
+		return position;
+	}
+
+	return nextLine(position, end);
+}
+
+/**
+ * Appends the bases begin,...,end-1 of a record to sequence. The ambiguity codes are
+ * instantiated by a generator which is seeded by seed and the position in the file at
+ * begin and at the first line after every multiple of SEED_INTERVAL. Thus the bases
+ * depend neither on the number of pieces nor on the thread which parses them.
+ */
+void appendBases(const char* data, const char* begin, const char* end,
+		unsigned int seed, PackedSequence& sequence) {
+	sequence.reserve(sequence.size() + (end - begin));
+
+	while (begin < end) {
+		uint64_t offset = begin - data;
+		const char* next = lineStart(data,
+				data + std::min<uint64_t>(
+						(offset / SEED_INTERVAL + 1) * SEED_INTERVAL,
+						end - data), end);
+		PackedSequence::RandomGenerator random(
+				(boost::random::mt19937(
+						seed + (unsigned int) (offset ^ (offset >> 32)))));
+
+		next = std::min(next, end);
+
+		try {
+			sequence.append(begin, next, random);
+		} catch (std::invalid_argument& e) {
+			// report the position of the first invalid code
+			const char* invalid = begin;
+
+			while (invalid < next
+					&& (std::isspace((unsigned char) *invalid)
+							|| PackedSequence::getBaseSet(*invalid) != 0)) {
+				invalid++;
+			}
+
+			std::ostringstream message;
+			message << "Invalid nucleotide code " << *invalid << " at byte "
+					<< invalid - data << ".";
+
+			throw std::invalid_argument(message.str());
+		}
+
+		begin = next;
+	}
+}
+
+void parsePiece(const char* data, unsigned int seed, FastaPiece* piece) {
+	const char* position = piece->_begin;
+	const char* end = piece->_end;
+
+	piece->_continued = position < end && *position != '>';
+
+	while (position < end) {
+		const char* sequence = position;
+
+		if (*position == '>') {
+			const char* idEnd;
+
+			sequence = nextLine(position, end);
+			idEnd = sequence;
+
+			// strip the line break (\n or \r\n)
+			while (idEnd > position + 1
+					&& (idEnd[-1] == '\n' || idEnd[-1] == '\r')) {
+				idEnd--;
+			}
+
+			piece->_ids.push_back(std::string(position + 1, idEnd));
+		} else {
+			piece->_ids.push_back("");
+		}
+
+		// the bases of the record reach up to the next identifier line. Line breaks,
+		// carriage returns and blank lines are skipped by PackedSequence::append.
+		position = findRecord(data, sequence, end);
+
+		piece->_sequences.push_back(PackedSequence());
+		appendBases(data, sequence, position, seed, piece->_sequences.back());
+	}
+}
+}
+
+void GeneDatabase::importFile(const std::string& filename, int numberThreads,
+		unsigned int seed) {
+	BgzfFile compressed;
+	std::vector<char> buffer;
+	const char* data;
+	std::size_t size;
+
+	if (numberThreads <= 0) {
+		numberThreads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	try {
+		if (!compressed.open(filename)) {
+			std::cerr << "Could not open file:" << filename << std::endl;
+			exit(1);
+		}
+	} catch (std::invalid_argument& e) {
+		// gzip files without BGZF blocks cannot be decompressed in parallel
+		std::cerr << "File is not compressed by bgzip:" << filename << std::endl;
+		std::cerr << e.what() << std::endl;
 		exit(1);
 	}
 
-	while (!is.eof()) {
-		std::getline(is, line);
+	if (compressed.isCompressed()) {
+		// the blocks are decompressed in parallel, then the text is parsed like a plain file
+		try {
+			compressed.readAll(buffer, numberThreads);
+		} catch (std::exception& e) {
+			std::cerr << "Could not decompress file:" << filename << std::endl;
+			std::cerr << e.what() << std::endl;
+			exit(1);
+		}
+
+		data = buffer.empty() ? NULL : &buffer[0];
+		size = buffer.size();
+	} else {
+		// the file is parsed in place of the mapping of compressed
+		data = compressed.data();
+		size = compressed.size();
+	}
 
-		// read identifier of sequence
-		if (line[0] == '>') {
-			if (id != "") {
-				_entries.emplace(id, DatabaseEntry(id, buffer));
-				buffer.clear();
+	const char* end = data + size;
+
+	// several pieces per thread balance records of different lengths
+	int numberPieces = std::min<std::size_t>(4 * numberThreads,
+			size / MIN_PIECE_SIZE + 1);
+	std::vector<FastaPiece> pieces(numberPieces);
+
+	for (int i = 0; i < numberPieces; i++) {
+		// pieces start at the beginning of the first line after a multiple of
+		// SEED_INTERVAL, where the bases of a record are seeded again anyway
+		const char* begin = lineStart(data,
+				data + size / numberPieces * i / SEED_INTERVAL * SEED_INTERVAL,
+				end);
+
+		pieces[i]._begin = begin;
+
+		if (i > 0) {
+			pieces[i - 1]._end = std::max(pieces[i - 1]._begin, begin);
+		}
+	}
+
+	pieces.back()._end = end;
+
+	try {
+		if (numberPieces == 1) {
+			parsePiece(data, seed, &pieces[0]);
+		} else {
+			ThreadPool pool(std::min(numberThreads, numberPieces));
+			ThreadPool::Batch batch;
+
+			for (int i = 0; i < numberPieces; i++) {
+				pool.schedule(batch,
+						boost::bind(&parsePiece, data, seed, &pieces[i]));
 			}
 
-			id = line.substr(1);
+			batch.wait();
 		}
-		// read sequence information
-		else {
-			for (int i = 0; i < line.size(); i++) {
-				ss.clear();
-				ss << line[i];
-				ss >> token;
-				buffer.push_back(token);
+	} catch (std::exception& e) {
+		std::cerr << "Could not parse file:" << filename << std::endl;
+		std::cerr << e.what() << std::endl;
+		exit(1);
+	}
+
+	// join the records which span several pieces. Bases before the first identifier
+	// and records without identifier are dropped.
+	std::vector<std::string> ids;
+	std::vector<PackedSequence> sequences;
+
+	for (std::vector<FastaPiece>::iterator piece = pieces.begin();
+			piece != pieces.end(); ++piece) {
+		for (int k = 0; k < (int) piece->_sequences.size(); k++) {
+			if (k == 0 && piece->_continued) {
+				if (!sequences.empty()) {
+					sequences.back().append(piece->_sequences[k]);
+				}
+			} else {
+				ids.push_back(piece->_ids[k]);
+				sequences.push_back(PackedSequence());
+				sequences.back().swap(piece->_sequences[k]);
 			}
 		}
+
+		// the pieces are no longer needed
+		std::vector<PackedSequence>().swap(piece->_sequences);
+	}
+
+	for (int k = 0; k < (int) ids.size(); k++) {
+		if (ids[k] != "" && _entries.find(ids[k]) == _entries.end()) {
+			_entries.emplace(ids[k], DatabaseEntry(ids[k], sequences[k]));
+		}
 	}
+}
+
+void GeneDatabase::importFiles(const std::string& filename,
+		const std::string& cdsFilename, const std::string& cacheFilename) {
+	std::string cache = cacheFilename.empty() ? filename + ".cache" : cacheFilename;
+	std::vector<std::string> sources;
+
+	sources.push_back(filename);
+	sources.push_back(cdsFilename);
+
+	std::vector<DatabaseCache::Stamp> stamps;
 
-	if (id != "") {
-		_entries.emplace(id, DatabaseEntry(id, buffer));
-		buffer.clear();
+	DatabaseCache::stamp(sources, stamps);
+
+	if (DatabaseCache::read(cache, *this, stamps)) {
+		return;
 	}
 
-	is.close();
+	importFile(filename);
+	importCDS(cdsFilename);
+
+	if (!DatabaseCache::write(cache, *this, stamps)) {
+		std::cerr << "Could not write database cache:" << cache << std::endl;
+	}
 }
 
 void GeneDatabase::importCDS(const std::string& filename) {
@@ -143,6 +394,30 @@ void GeneDatabase::extractAnnotatedSequences(
 	}
 }
 
+void GeneDatabase::extractSequences(SequenceBatch& result) const {
+	std::size_t numberSymbols = 0;
+
+	for (boost::unordered_map<std::string, DatabaseEntry>::const_iterator it =
+			_entries.begin(); it != _entries.end(); ++it) {
+		numberSymbols += it->second.getData().size();
+	}
+
+	result.reserve(result.size() + _entries.size(),
+			result.getNumberSymbols() + numberSymbols);
+
+	for (boost::unordered_map<std::string, DatabaseEntry>::const_iterator it =
+			_entries.begin(); it != _entries.end(); ++it) {
+		it->second.extractSequence(result);
+	}
+}
+
+void GeneDatabase::extractAnnotatedSequences(SequenceBatch& result) const {
+	for (boost::unordered_map<std::string, DatabaseEntry>::const_iterator it =
+			_entries.begin(); it != _entries.end(); ++it) {
+		it->second.extractAnnotatedSequence(result);
+	}
+}
+
 void GeneDatabase::extractAnnotations(
 		std::vector<std::vector<std::string> >& result) const {
 	for (boost::unordered_map<std::string, DatabaseEntry>::const_iterator it =
@@ -189,3 +464,54 @@ void GeneDatabase::separateSet(const std::vector<DatabaseEntry*>& entries,
 	}
 }
 
+void GeneDatabase::separateSet(const std::vector<DatabaseEntry*>& entries,
+		std::vector<std::vector<std::string> >& sequences,
+		std::vector<std::vector<std::string> >& trainingAnnotations,
+		std::vector<std::vector<std::string> >& testset,
+		std::vector<std::vector<std::string> >& annotations, int start,
+		int end) {
+
+	for (int i = 0; i < entries.size(); i++) {
+		if (i < start || i >= end) {
+			entries[i]->extractSequence(sequences);
+			entries[i]->extractAnnotation(trainingAnnotations);
+		} else {
+			entries[i]->extractSequence(testset);
+			entries[i]->extractAnnotation(annotations);
+		}
+	}
+}
+
+void GeneDatabase::separateSet(const std::vector<DatabaseEntry*>& entries,
+		DatabaseSequences& sequences,
+		std::vector<std::vector<std::string> >& testset,
+		std::vector<std::vector<uint8_t> >& annotations, int start,
+		int end) {
+
+	for (int i = 0; i < entries.size(); i++) {
+		if (i < start || i >= end) {
+			sequences.add(entries[i]);
+		} else {
+			entries[i]->extractSequence(testset);
+			entries[i]->extractAnnotation(annotations);
+		}
+	}
+}
+
+void GeneDatabase::separateSet(const std::vector<DatabaseEntry*>& entries,
+		DatabaseSequences& sequences,
+		std::vector<std::vector<std::string> >& trainingAnnotations,
+		std::vector<std::vector<std::string> >& testset,
+		std::vector<std::vector<uint8_t> >& annotations, int start,
+		int end) {
+
+	for (int i = 0; i < entries.size(); i++) {
+		if (i < start || i >= end) {
+			sequences.add(entries[i]);
+			entries[i]->extractAnnotation(trainingAnnotations);
+		} else {
+			entries[i]->extractSequence(testset);
+			entries[i]->extractAnnotation(annotations);
+		}
+	}
+}
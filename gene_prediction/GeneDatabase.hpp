@@ -12,6 +12,8 @@
 #include <string>
 #include "DatabaseEntry.hpp"
 
+class DatabaseSequences;
+
 /**
  * Container class for DatabasesEntries/DNASequences
  */
@@ -29,9 +31,21 @@ public:
 	}
 
 	/**
-	 * Read a fasta file and import the contained DNA sequences
+	 * Read a fasta file and import the contained DNA sequences. The file is memory
+	 * mapped and split into pieces at line boundaries, which are parsed in parallel
+	 * directly into packed sequences. Windows line breaks, blank lines and lower case
+	 * (soft-masked) bases are accepted. Files which are compressed by bgzip are
+	 * decompressed in parallel first (see BgzfFile), other gzip files are rejected. An
+	 * invalid nucleotide code is reported with its byte offset in the (uncompressed) file.
+	 *
+	 * @argument filename name of the fasta file
+	 * @argument numberThreads number of parsing threads. If it is not positive, then
+	 * 		one thread per hardware thread is used.
+	 * @argument seed seed of the instantiation of the ambiguity codes. The imported bases
+	 * 		only depend on the file and on seed, not on the number of threads.
 	 */
-	void importFile(const std::string& filename);
+	void importFile(const std::string& filename, int numberThreads = 0,
+			unsigned int seed = 0);
 
 	/**
 	 * Read a CDS file and assign the contained exon information to the respective
@@ -39,6 +53,22 @@ public:
 	 */
 	void importCDS(const std::string& filename);
 
+	/**
+	 * Imports the fasta file filename and the CDS file cdsFilename like importFile and
+	 * importCDS. The result is stored in the binary cache cacheFilename, which later
+	 * calls memory map instead of parsing the files again as long as both files are
+	 * unchanged (see DatabaseCache). Ambiguity codes are thus instantiated only once,
+	 * when the cache is written.
+	 *
+	 * @argument filename name of the fasta file
+	 * @argument cdsFilename name of the CDS file
+	 * @argument cacheFilename name of the cache file. If it is empty, then filename
+	 * 		followed by ".cache" is used.
+	 */
+	void importFiles(const std::string& filename,
+			const std::string& cdsFilename,
+			const std::string& cacheFilename = "");
+
 	int size() const {
 		return _entries.size();
 	}
@@ -52,6 +82,13 @@ public:
 	void extractSequences(std::vector<std::vector<std::string> >& result) const;
 	void extractAnnotatedSequences(
 			std::vector<std::vector<std::string> >& result) const;
+
+	/**
+	 * These functions append the sequences to a SequenceBatch instead, whose folds can
+	 * be selected without copying the sequences (see SequenceBatch::fold).
+	 */
+	void extractSequences(SequenceBatch& result) const;
+	void extractAnnotatedSequences(SequenceBatch& result) const;
 	void extractAnnotations(
 			std::vector<std::vector<std::string> >& result) const;
 
@@ -80,6 +117,46 @@ public:
 			std::vector<std::vector<std::string> >& testset,
 			std::vector<std::vector<std::string> >& annotations, bool annotated,
 			int start, int end);
+
+	/**
+	 * This function does the same as the previous one, but it extracts the plain DNA
+	 * sequences for the training set together with their structure annotations. This
+	 * is used for the label constrained learning.
+	 *
+	 * @argument entries vector of DatabaseEntries which are used to get the data
+	 * @argument sequences vector in which the training set is stored
+	 * @argument trainingAnnotations vector in which the structure annotations of the training set are stored
+	 * @argument testset vector in which the testing set is stored
+	 * @argument annotations vector in which the structure annotations of the testing set are stored
+	 * @argument start starting index for the testing set
+	 * @argument end ending index for the testing set (exclusive)
+	 */
+	static void separateSet(const std::vector<DatabaseEntry*>& entries,
+			std::vector<std::vector<std::string> >& sequences,
+			std::vector<std::vector<std::string> >& trainingAnnotations,
+			std::vector<std::vector<std::string> >& testset,
+			std::vector<std::vector<std::string> >& annotations, int start,
+			int end);
+
+	/**
+	 * These functions do the same as the previous ones, but the training set only
+	 * references the entries. Their symbols are computed when the training reads them,
+	 * thus the (annotated) training sequences are never stored as strings. Whether they
+	 * are annotated is defined by sequences (see DatabaseSequences). The annotations of
+	 * the testing set are stored as codes of DatabaseEntry::Label, which is what the
+	 * repeated evaluations of the testing set compare (see Analytics::analyse).
+	 */
+	static void separateSet(const std::vector<DatabaseEntry*>& entries,
+			DatabaseSequences& sequences,
+			std::vector<std::vector<std::string> >& testset,
+			std::vector<std::vector<uint8_t> >& annotations, int start,
+			int end);
+	static void separateSet(const std::vector<DatabaseEntry*>& entries,
+			DatabaseSequences& sequences,
+			std::vector<std::vector<std::string> >& trainingAnnotations,
+			std::vector<std::vector<std::string> >& testset,
+			std::vector<std::vector<uint8_t> >& annotations, int start,
+			int end);
 };
 
 #endif /* GENEDATABASE_HPP_ */
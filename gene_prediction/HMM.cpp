@@ -8,6 +8,8 @@
 #include "HMM.hpp"
 #include <stdexcept>
 #include <sstream>
+#include <deque>
+#include <algorithm>
 
 #include <boost/regex.hpp>
 
@@ -120,6 +122,26 @@ void HMM::setConstantEmissionSet(int src, bool constant) {
 	}
 }
 
+void HMM::setEmissionTie(int src, const std::string& group) {
+	ptrHMMNode node = getNode(src);
+
+	if (node) {
+		node->emissionTie() = group;
+	} else {
+		throw std::invalid_argument("Could not find node with ID:" + src);
+	}
+}
+
+void HMM::setTransitionTie(int src, const std::string& group) {
+	ptrHMMNode node = getNode(src);
+
+	if (node) {
+		node->transitionTie() = group;
+	} else {
+		throw std::invalid_argument("Could not find node with ID:" + src);
+	}
+}
+
 void HMM::addTransitions(int src,
 		const std::vector<HMMTransition> & transitions) {
 	ptrHMMNode node = getNode(src);
@@ -332,13 +354,24 @@ int HMM::shallowSize() const {
 	return result;
 }
 
-void HMM::compile(boost::shared_ptr<HMMCompiled> compiled) {
+void HMM::compile(boost::shared_ptr<HMMCompiled> compiled, bool renumber) {
 	compiled->initialize(size());
 
 	// Build mapping int -> node and node -> int
-	for (boost::unordered_map<int, boost::shared_ptr<HMMNode> >::const_iterator it =
-			_nodes.begin(); it != _nodes.end(); ++it) {
-		it->second->buildMapping(*compiled);
+	if (renumber) {
+		std::vector<ptrHMMNode> order;
+
+		localityOrder(order);
+
+		for (std::vector<ptrHMMNode>::const_iterator it = order.begin();
+				it != order.end(); ++it) {
+			(*it)->buildMapping(*compiled);
+		}
+	} else {
+		for (boost::unordered_map<int, boost::shared_ptr<HMMNode> >::const_iterator it =
+				_nodes.begin(); it != _nodes.end(); ++it) {
+			it->second->buildMapping(*compiled);
+		}
 	}
 
 	// Incorporate transitions and emissions
@@ -357,6 +390,246 @@ void HMM::compile(boost::shared_ptr<HMMCompiled> compiled) {
 	compiled->finishCompilation();
 }
 
+void HMM::localityOrder(std::vector<ptrHMMNode>& order) const {
+	std::vector<int> ids;
+	std::vector<int> visited;
+	boost::unordered_set<int> seen;
+	std::deque<int> queue;
+
+	// ids are sorted to make the order independent of the hashing
+	for (boost::unordered_map<int, double>::const_iterator it =
+			_startNodes.begin(); it != _startNodes.end(); ++it) {
+		ids.push_back(it->first);
+	}
+
+	std::sort(ids.begin(), ids.end());
+
+	for (std::vector<int>::const_iterator it = ids.begin(); it != ids.end();
+			++it) {
+		if (seen.insert(*it).second) {
+			queue.push_back(*it);
+		}
+	}
+
+	while (!queue.empty()) {
+		int id = queue.front();
+		queue.pop_front();
+		visited.push_back(id);
+
+		const Transition& transitions = _nodes.at(id)->getTransition();
+		std::vector<int> children;
+
+		for (Transition::const_iterator it = transitions.begin();
+				it != transitions.end(); ++it) {
+			children.push_back(it->second._destination);
+		}
+
+		std::sort(children.begin(), children.end());
+
+		for (std::vector<int>::const_iterator it = children.begin();
+				it != children.end(); ++it) {
+			if (_nodes.count(*it) > 0 && seen.insert(*it).second) {
+				queue.push_back(*it);
+			}
+		}
+	}
+
+	// unreachable nodes
+	ids.clear();
+
+	for (boost::unordered_map<int, ptrHMMNode>::const_iterator it =
+			_nodes.begin(); it != _nodes.end(); ++it) {
+		if (seen.count(it->first) == 0) {
+			ids.push_back(it->first);
+		}
+	}
+
+	std::sort(ids.begin(), ids.end());
+	visited.insert(visited.end(), ids.begin(), ids.end());
+
+	order.clear();
+
+	for (std::vector<int>::const_iterator it = visited.begin();
+			it != visited.end(); ++it) {
+		if (!_nodes.at(*it)->getSilent()) {
+			order.push_back(_nodes.at(*it));
+		}
+	}
+
+	for (std::vector<int>::const_iterator it = visited.begin();
+			it != visited.end(); ++it) {
+		if (_nodes.at(*it)->getSilent()) {
+			order.push_back(_nodes.at(*it));
+		}
+	}
+}
+
+void HMM::prune(double threshold) {
+	boost::unordered_set<int> changed;
+	boost::unordered_map<int, std::vector<int> > predecessors;
+	boost::unordered_set<int> reachable;
+	boost::unordered_set<int> live;
+	std::deque<int> queue;
+
+	// remove the negligible transitions
+	for (boost::unordered_map<int, ptrHMMNode>::iterator it = _nodes.begin();
+			it != _nodes.end(); ++it) {
+		Transition& transitions = it->second->getTransition();
+		Transition::iterator max = transitions.end();
+
+		if (it->second->constantTransitions()) {
+			continue;
+		}
+
+		for (Transition::iterator jt = transitions.begin();
+				jt != transitions.end(); ++jt) {
+			if (max == transitions.end()
+					|| max->second._probability < jt->second._probability) {
+				max = jt;
+			}
+		}
+
+		for (Transition::iterator jt = transitions.begin();
+				jt != transitions.end();) {
+			if (jt != max && jt->second._probability >= 0
+					&& jt->second._probability < threshold) {
+				jt = transitions.erase(jt);
+				changed.insert(it->first);
+			} else {
+				++jt;
+			}
+		}
+	}
+
+	// nodes which can be reached from a start node
+	for (boost::unordered_map<int, double>::const_iterator it =
+			_startNodes.begin(); it != _startNodes.end(); ++it) {
+		if (reachable.insert(it->first).second) {
+			queue.push_back(it->first);
+		}
+	}
+
+	while (!queue.empty()) {
+		int id = queue.front();
+		queue.pop_front();
+
+		const Transition& transitions = _nodes.at(id)->getTransition();
+
+		for (Transition::const_iterator it = transitions.begin();
+				it != transitions.end(); ++it) {
+			int dest = it->second._destination;
+
+			predecessors[dest].push_back(id);
+
+			if (_nodes.count(dest) > 0 && reachable.insert(dest).second) {
+				queue.push_back(dest);
+			}
+		}
+	}
+
+	// reachable nodes from which an end node can be reached. Transitions of unreachable
+	// nodes are not contained in predecessors, but they are removed anyway.
+	if (!_endNodes.empty()) {
+		for (boost::unordered_set<int>::const_iterator it = _endNodes.begin();
+				it != _endNodes.end(); ++it) {
+			if (reachable.count(*it) > 0 && live.insert(*it).second) {
+				queue.push_back(*it);
+			}
+		}
+
+		while (!queue.empty()) {
+			int id = queue.front();
+			queue.pop_front();
+
+			const std::vector<int>& sources = predecessors[id];
+
+			for (std::vector<int>::const_iterator it = sources.begin();
+					it != sources.end(); ++it) {
+				if (live.insert(*it).second) {
+					queue.push_back(*it);
+				}
+			}
+		}
+	} else {
+		live = reachable;
+	}
+
+	// remove the unreachable and dead nodes
+	for (boost::unordered_map<int, ptrHMMNode>::iterator it = _nodes.begin();
+			it != _nodes.end();) {
+		if (live.count(it->first) == 0) {
+			_startNodes.erase(it->first);
+			_endNodes.erase(it->first);
+			it = _nodes.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// remove the transitions to removed nodes
+	for (boost::unordered_map<int, ptrHMMNode>::iterator it = _nodes.begin();
+			it != _nodes.end(); ++it) {
+		Transition& transitions = it->second->getTransition();
+
+		for (Transition::iterator jt = transitions.begin();
+				jt != transitions.end();) {
+			if (_nodes.count(jt->second._destination) == 0) {
+				jt = transitions.erase(jt);
+				changed.insert(it->first);
+			} else {
+				++jt;
+			}
+		}
+	}
+
+	// normalize the changed nodes
+	for (boost::unordered_set<int>::const_iterator it = changed.begin();
+			it != changed.end(); ++it) {
+		if (_nodes.count(*it) == 0) {
+			continue;
+		}
+
+		Transition& transitions = _nodes.at(*it)->getTransition();
+		double sum = 0;
+		bool random = false;
+
+		for (Transition::const_iterator jt = transitions.begin();
+				jt != transitions.end(); ++jt) {
+			if (jt->second._probability < 0) {
+				random = true;
+			} else {
+				sum += jt->second._probability;
+			}
+		}
+
+		if (!random && sum > 0) {
+			for (Transition::iterator jt = transitions.begin();
+					jt != transitions.end(); ++jt) {
+				jt->second._probability /= sum;
+			}
+		}
+	}
+
+	double sum = 0;
+	bool random = false;
+
+	for (boost::unordered_map<int, double>::const_iterator it =
+			_startNodes.begin(); it != _startNodes.end(); ++it) {
+		if (it->second < 0) {
+			random = true;
+		} else {
+			sum += it->second;
+		}
+	}
+
+	if (!random && sum > 0) {
+		for (boost::unordered_map<int, double>::iterator it =
+				_startNodes.begin(); it != _startNodes.end(); ++it) {
+			it->second /= sum;
+		}
+	}
+}
+
 void HMM::update(boost::shared_ptr<HMMCompiled> compiled) {
 	for (boost::unordered_map<int, boost::shared_ptr<HMMNode> >::const_iterator it =
 			_nodes.begin(); it != _nodes.end(); ++it) {
@@ -421,6 +694,8 @@ void HMM::integrateHMM(boost::shared_ptr<HMM> hmm,
 				it->second->constantEmissionSet());
 
 		translation.emplace(it->first, id);
+		setEmissionTie(id, it->second->emissionTie());
+		setTransitionTie(id, it->second->transitionTie());
 		boost::unordered_map<std::string, HMMEmission>::const_iterator jt =
 				it->second->getEmission().begin();
 
@@ -97,6 +97,21 @@ public:
 	 */
 	void setConstantEmissionSet(int src, bool constant = true);
 
+	/**
+	 * Adds the emissions of the node with ID src to the tie group group. All nodes of a
+	 * tie group share the same emission probabilities, their expected counts are pooled
+	 * by the Baum-Welch algorithm. The nodes of a group need the same emission set and
+	 * the same constant flags. An empty name removes the node from its group.
+	 */
+	void setEmissionTie(int src, const std::string& group);
+
+	/**
+	 * Adds the transitions of the node with ID src to the tie group group. The nodes of a
+	 * group need transitions to the same destinations. The probability of the transition
+	 * to a destination is shared by all nodes of the group.
+	 */
+	void setTransitionTie(int src, const std::string& group);
+
 	void addStartNode(int nodeID, double probability);
 	void addStartNode(const std::string& nodeName, double probability);
 	void addEndNode(int nodeID);
@@ -120,8 +135,38 @@ public:
 	 * This function converts the HMM (graph like representation) into a more
 	 * computability-friendly version (matrix based representation) which is then
 	 * used for the HMM algorithms.
+	 *
+	 * @argument compiled instance which receives the compiled HMM
+	 * @argument renumber if true, the internal ids of the states are assigned in the
+	 * 	order of localityOrder instead of the iteration order of the node map. Then the
+	 * 	predecessors of a state mostly have neighbouring ids and the silent states
+	 * 	have the highest ids.
+	 */
+	void compile(boost::shared_ptr<HMMCompiled> compiled, bool renumber = false);
+
+	/**
+	 * This function computes an order of the nodes which follows the structure of the
+	 * model. The nodes are visited by a breadth first search starting at the start nodes,
+	 * nodes which cannot be reached are appended. Within this order the emitting nodes are
+	 * put before the silent nodes.
+	 *
+	 * @argument order nodes in the computed order
+	 */
+	void localityOrder(std::vector<ptrHMMNode>& order) const;
+
+	/**
+	 * This function removes the parts of a learned HMM which contribute (almost) nothing
+	 * to the likelihood of a sequence. First the transitions of nodes without constant
+	 * transitions whose probability is smaller than threshold are removed. The most
+	 * probable transition of a node is always kept. Then the nodes which cannot be
+	 * reached from a start node and, if there are end nodes, the nodes from which no end
+	 * node can be reached are removed together with their transitions. Afterwards the
+	 * remaining transitions of every changed node and the start distribution are
+	 * normalized again. Random probabilities are neither removed nor normalized.
+	 *
+	 * @argument threshold transitions with a smaller probability are removed
 	 */
-	void compile(boost::shared_ptr<HMMCompiled> compiled);
+	void prune(double threshold);
 
 	/**
 	 * This function writes back the transition and emission probabilities from a
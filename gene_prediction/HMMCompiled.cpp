@@ -9,67 +9,71 @@
 
 #include <stdlib.h>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <ctime>
 #include <limits>
+#include <algorithm>
 
 #include <boost/heap/fibonacci_heap.hpp>
+#include <boost/regex.hpp>
 
 #include "nullPtr.hpp"
 #include "Pair.hpp"
 #include "HMMNode.hpp"
 #include "HMM.hpp"
+#include "SequenceSource.hpp"
+#include "DPWorkspace.hpp"
+#include "StoppingPolicy.hpp"
+#include "PackedSequence.hpp"
+#include "SequenceBatch.hpp"
 
 HMMCompiled::HMMCompiled() :
-		_numberNodes(0), _mapTransitions(NULL), _imapTransitions(NULL), _constantTransitionNodes(
-				NULL), _constantEmissionNodes(NULL), _constantEmissionSetNodes(
-				NULL), _emissions(NULL), _initialDistribution(NULL), _counter(
-				0), _random(boost::random::mt19937(time(NULL))) {
+		_numberNodes(0), _topology(new HMMTopology()) {
 }
 
 HMMCompiled::~HMMCompiled() {
-	clear();
 }
 
 void HMMCompiled::clear() {
 	_numberNodes = 0;
 
-	delete[] _mapTransitions;
-	delete[] _imapTransitions;
-	delete[] _emissions;
-	delete[] _initialDistribution;
-	delete[] _constantTransitionNodes;
-	delete[] _constantEmissionNodes;
-	delete[] _constantEmissionSetNodes;
+	_topology.reset(new HMMTopology());
+	_transitions.clear();
+	_emissions.clear();
+	_initialDistribution.clear();
+	_compiledTransitions.clear();
+	_compiledEmissions.clear();
+}
+
+HMMTopology& HMMCompiled::mutableTopology() {
+	if (!_topology.unique()) {
+		_topology.reset(new HMMTopology(*_topology));
+	}
 
-	_silentStates.clear();
-	_int2Node.clear();
-	_node2Int.clear();
+	// the modified topology is no projection anymore
+	_topology->_projectedFrom.reset();
 
-	_counter = 0;
+	return *_topology;
 }
 
 bool HMMCompiled::isRandom() const {
-	for (int i = 0; i < _numberNodes; i++) {
-		for (boost::unordered_map<int, double>::const_iterator jt =
-				_mapTransitions[i].begin(); jt != _mapTransitions[i].end();
-				++jt) {
-			if (jt->second < 0)
-				return true;
-		}
+	for (std::vector<double>::const_iterator it = _transitions.begin();
+			it != _transitions.end(); ++it) {
+		if (*it < 0)
+			return true;
 	}
 
-	for (int i = 0; i < _numberNodes; i++) {
-		if (_initialDistribution[i] < 0) {
+	for (std::vector<double>::const_iterator it = _initialDistribution.begin();
+			it != _initialDistribution.end(); ++it) {
+		if (*it < 0)
 			return true;
-		}
+	}
 
-		for (boost::unordered_map<std::string, double>::const_iterator it =
-				_emissions[i].begin(); it != _emissions[i].end(); ++it) {
-			if (it->second < 0) {
-				return true;
-			}
-		}
+	for (std::vector<double>::const_iterator it = _emissions.begin();
+			it != _emissions.end(); ++it) {
+		if (*it < 0)
+			return true;
 	}
 
 	return false;
@@ -79,33 +83,38 @@ void HMMCompiled::initialize(int numberNodes) {
 	clear();
 	_numberNodes = numberNodes;
 
-	_mapTransitions = new boost::unordered_map<int, double>[numberNodes];
-	_imapTransitions = new boost::unordered_map<int, double>[numberNodes];
-	_initialDistribution = new double[numberNodes];
-	_emissions = new boost::unordered_map<std::string, double>[numberNodes];
-	_constantEmissionNodes = new bool[numberNodes];
-	_constantTransitionNodes = new bool[numberNodes];
-	_constantEmissionSetNodes = new bool[numberNodes];
+	HMMTopology& topology = mutableTopology();
 
-	for (int i = 0; i < numberNodes; i++) {
-		_initialDistribution[i] = 0;
-		_constantEmissionNodes[i] = false;
-		_constantTransitionNodes[i] = false;
-		_constantEmissionSetNodes[i] = false;
-	}
+	topology._numberNodes = numberNodes;
+	topology._nodes.resize(numberNodes);
+	topology._silent.assign(numberNodes, false);
+	topology._constantTransitions.assign(numberNodes, false);
+	topology._constantEmissions.assign(numberNodes, false);
+	topology._constantEmissionSet.assign(numberNodes, false);
+
+	_initialDistribution.assign(numberNodes, 0);
+	_compiledTransitions.resize(numberNodes);
+	_compiledEmissions.resize(numberNodes);
+}
+
+std::size_t HMMCompiled::getTrainingHighWaterMark() const {
+	return _trainingWorkspace ? _trainingWorkspace->getHighWaterMark() : 0;
 }
 
 boost::shared_ptr<HMMNode> HMMCompiled::getNode(int index) const {
-	if (_int2Node.count(index) > 0) {
-		return _int2Node.at(index);
+	if (index >= 0 && index < _topology->_nodes.size()) {
+		return _topology->_nodes[index];
 	} else {
 		return nullPtr;
 	}
 }
 
 int HMMCompiled::getIndex(boost::shared_ptr<HMMNode> node) const {
-	if (_node2Int.count(node) > 0) {
-		return _node2Int.at(node);
+	boost::unordered_map<boost::shared_ptr<HMMNode>, int>::const_iterator it =
+			_topology->_node2Int.find(node);
+
+	if (it != _topology->_node2Int.end()) {
+		return it->second;
 	} else {
 		return -1;
 	}
@@ -116,7 +125,7 @@ bool HMMCompiled::hasConstantTransitions(int node) const {
 		throw std::invalid_argument("Node index out of range");
 	}
 
-	return _constantTransitionNodes[node];
+	return _topology->_constantTransitions[node];
 }
 
 bool HMMCompiled::hasConstantEmissions(int node) const {
@@ -124,7 +133,7 @@ bool HMMCompiled::hasConstantEmissions(int node) const {
 		throw std::invalid_argument("Node index out of range");
 	}
 
-	return _constantEmissionNodes[node];
+	return _topology->_constantEmissions[node];
 }
 
 bool HMMCompiled::hasConstantEmissionSet(int node) const {
@@ -132,7 +141,103 @@ bool HMMCompiled::hasConstantEmissionSet(int node) const {
 		throw std::invalid_argument("Node index out of range");
 	}
 
-	return _constantEmissionSetNodes[node];
+	return _topology->_constantEmissionSet[node];
+}
+
+void HMMCompiled::setStateLabels(
+		const boost::unordered_map<std::string, std::string>& mapping) {
+	HMMTopology& topology = mutableTopology();
+	std::vector<uint8_t>& stateLabels = topology._stateLabels;
+	std::vector<std::string>& labelNames = topology._labelNames;
+
+	stateLabels.assign(_numberNodes, HMMTopology::NO_LABEL);
+	labelNames.clear();
+
+	for (int i = 0; i < _numberNodes; i++) {
+		std::string name = topology._nodes[i]->getName();
+
+		for (boost::unordered_map<std::string, std::string>::const_iterator it =
+				mapping.begin(); it != mapping.end(); ++it) {
+			if (boost::regex_match(name, boost::regex(it->first))) {
+				std::vector<std::string>::const_iterator label = std::find(
+						labelNames.begin(), labelNames.end(), it->second);
+
+				if (label == labelNames.end()) {
+					if (labelNames.size() == HMMTopology::NO_LABEL) {
+						throw std::invalid_argument(
+								"setStateLabels: Too many structure labels.");
+					}
+
+					labelNames.push_back(it->second);
+					label = labelNames.end() - 1;
+				}
+
+				stateLabels[i] = label - labelNames.begin();
+				break;
+			}
+		}
+	}
+
+	buildLabelStates();
+}
+
+void HMMCompiled::buildLabelStates() {
+	HMMTopology& topology = mutableTopology();
+	const std::vector<uint8_t>& stateLabels = topology._stateLabels;
+	std::vector<std::vector<int> >& labelStates = topology._labelStates;
+
+	labelStates.assign(topology._labelNames.size(), std::vector<int>());
+
+	// unlabeled states may emit symbols of any label
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!isSilent(i)) {
+			if (stateLabels[i] != HMMTopology::NO_LABEL) {
+				labelStates[stateLabels[i]].push_back(i);
+			} else {
+				for (int l = 0; l < labelStates.size(); l++) {
+					labelStates[l].push_back(i);
+				}
+			}
+		}
+	}
+}
+
+void HMMCompiled::encodeLabels(
+		const std::vector<std::vector<std::string> >& labels,
+		std::vector<std::vector<uint8_t> >& codes) const {
+	codes.reserve(codes.size() + labels.size());
+
+	for (std::vector<std::vector<std::string> >::const_iterator it =
+			labels.begin(); it != labels.end(); ++it) {
+		// the labels of a run mostly repeat, thus the last one is checked first
+		const std::string* last = NULL;
+		uint8_t code = 0;
+
+		codes.push_back(std::vector<uint8_t>());
+		codes.back().reserve(it->size());
+
+		for (std::vector<std::string>::const_iterator label = it->begin();
+				label != it->end(); ++label) {
+			if (last == NULL || *label != *last) {
+				code = getLabelCode(*label);
+				last = &*label;
+			}
+
+			codes.back().push_back(code);
+		}
+	}
+}
+
+int HMMCompiled::getLabelCode(const std::string& label) const {
+	const std::vector<std::string>& labelNames = _topology->_labelNames;
+
+	for (int l = 0; l < labelNames.size(); l++) {
+		if (labelNames[l] == label) {
+			return l;
+		}
+	}
+
+	throw std::invalid_argument("Unknown structure label:" + label);
 }
 
 /**
@@ -140,13 +245,17 @@ bool HMMCompiled::hasConstantEmissionSet(int node) const {
  * thus creates a new entry in the mapping.
  */
 void HMMCompiled::addMapping(boost::shared_ptr<HMMNode> node) {
-	if (_node2Int.count(node) == 0) {
-		_constantTransitionNodes[_counter] = node->constantTransitions();
-		_constantEmissionNodes[_counter] = node->constantEmissions();
-		_constantEmissionSetNodes[_counter] = node->constantEmissionSet();
+	HMMTopology& topology = mutableTopology();
+
+	if (topology._node2Int.count(node) == 0) {
+		int index = topology._node2Int.size();
 
-		_node2Int[node] = _counter;
-		_int2Node[_counter++] = node;
+		topology._constantTransitions[index] = node->constantTransitions();
+		topology._constantEmissions[index] = node->constantEmissions();
+		topology._constantEmissionSet[index] = node->constantEmissionSet();
+
+		topology._node2Int[node] = index;
+		topology._nodes[index] = node;
 	}
 }
 
@@ -163,7 +272,7 @@ void HMMCompiled::addSilentNode(boost::shared_ptr<HMMNode> node) {
 	if (index < 0) {
 		throw std::invalid_argument("Node could not be found in the mapping.");
 	}
-	_silentStates.emplace(index);
+	mutableTopology()._silent[index] = true;
 }
 
 void HMMCompiled::addTransition(boost::shared_ptr<HMMNode> src,
@@ -181,7 +290,18 @@ void HMMCompiled::addTransition(boost::shared_ptr<HMMNode> src,
 				"addTransition: Dest could not be found in the mapping.");
 	}
 
-	setTransition(srcIndex, destIndex, probability);
+	_compiledTransitions[srcIndex][destIndex] = probability;
+}
+
+void HMMCompiled::setTransition(int x, int y, double value) {
+	int edge = _topology->getTransitionIndex(x, y);
+
+	if (edge < 0) {
+		throw std::invalid_argument(
+				"setTransition: The topology contains no such transition.");
+	}
+
+	_transitions[edge] = value;
 }
 
 void HMMCompiled::addEmission(boost::shared_ptr<HMMNode> src,
@@ -193,7 +313,7 @@ void HMMCompiled::addEmission(boost::shared_ptr<HMMNode> src,
 				"addEmission: Src could not be found in the mapping.");
 	}
 
-	_emissions[index].emplace(token, probability);
+	_compiledEmissions[index].emplace(token, probability);
 }
 
 double HMMCompiled::getInitialDistribution(
@@ -235,12 +355,19 @@ double HMMCompiled::getEmission(boost::shared_ptr<HMMNode> src,
 				"getEmission: Src could not be found in the mapping.");
 	}
 
-	return _emissions[srcIndex].at(token);
+	if (_topology->getSymbolId(token) < 0) {
+		throw std::invalid_argument(
+				"getEmission: Unknown emission symbol:" + token);
+	}
+
+	return getEmission(srcIndex, token);
 }
 
 double HMMCompiled::getEmission(int id, const std::string &token) const {
-	if (_emissions[id].count(token) > 0) {
-		return _emissions[id].at(token);
+	int symbol = _topology->getSymbolId(token);
+
+	if (symbol >= 0) {
+		return _emissions[symbol * _numberNodes + id];
 	} else {
 		return 0;
 	}
@@ -251,18 +378,18 @@ double HMMCompiled::getLogEmission(int id, const std::string &token) const {
 }
 
 std::string HMMCompiled::toString() const {
+	const HMMTopology& topology = *_topology;
 	std::stringstream ss;
 
 	ss << "Transitions:" << std::endl;
 
 	for (int i = 0; i < _numberNodes; i++) {
-		ss << _int2Node.at(i)->getName() << "=> ";
+		ss << topology._nodes[i]->getName() << "=> ";
 
-		for (boost::unordered_map<int, double>::const_iterator jt =
-				_mapTransitions[i].begin(); jt != _mapTransitions[i].end();
-				++jt) {
-			ss << _int2Node.at(jt->first)->getName() << ":" << jt->second
-					<< " ";
+		for (int e = topology._transitionOffsets[i];
+				e < topology._transitionOffsets[i + 1]; e++) {
+			ss << topology._nodes[topology._transitionTargets[e]]->getName()
+					<< ":" << _transitions[e] << " ";
 		}
 		ss << std::endl;
 	}
@@ -272,10 +399,12 @@ std::string HMMCompiled::toString() const {
 	ss << "Emissions:" << std::endl;
 
 	for (int i = 0; i < _numberNodes; i++) {
-		ss << _int2Node.at(i)->getName() << ":";
-		for (boost::unordered_map<std::string, double>::const_iterator it =
-				_emissions[i].begin(); it != _emissions[i].end(); ++it) {
-			ss << it->first << "=" << it->second << " ";
+		ss << topology._nodes[i]->getName() << ":";
+		for (int a = 0; a < topology.getNumberSymbols(); a++) {
+			if (_emissions[a * _numberNodes + i] != 0) {
+				ss << topology._symbols[a] << "="
+						<< _emissions[a * _numberNodes + i] << " ";
+			}
 		}
 		ss << std::endl;
 	}
@@ -285,7 +414,7 @@ std::string HMMCompiled::toString() const {
 	ss << "Initial distribution:" << std::endl;
 
 	for (int i = 0; i < _numberNodes; i++) {
-		ss << _int2Node.at(i)->getName() << ":" << _initialDistribution[i]
+		ss << topology._nodes[i]->getName() << ":" << _initialDistribution[i]
 				<< std::endl;
 	}
 
@@ -293,10 +422,18 @@ std::string HMMCompiled::toString() const {
 }
 
 /**
- * This function calculates the traversal order of silent states for the HMM algorithm.
- * If no such order can be found, it throws an exception.
+ * This function builds the topology from the added transitions and emissions and
+ * calculates the traversal order of silent states for the HMM algorithm. If no such order
+ * can be found, it throws an exception.
  */
 void HMMCompiled::finishCompilation() {
+	buildTopology();
+	buildTies();
+}
+
+void HMMCompiled::buildTopology() {
+	HMMTopology& topology = mutableTopology();
+	std::vector<int> silentStates;
 	boost::unordered_map<int, std::vector<int> > deps;
 	boost::unordered_map<int,
 			boost::heap::fibonacci_heap<Pair<int>,
@@ -307,18 +444,106 @@ void HMMCompiled::finishCompilation() {
 	boost::heap::fibonacci_heap<Pair<int>,
 			boost::heap::compare<std::greater<Pair<int> > > > heap;
 
-	for (boost::unordered_set<int>::const_iterator it = _silentStates.begin();
-			it != _silentStates.end(); ++it) {
+	// outgoing transitions as compressed sparse rows, the targets are sorted by the map
+	topology._transitionOffsets.assign(1, 0);
+	topology._transitionTargets.clear();
+	_transitions.clear();
+
+	for (int i = 0; i < _numberNodes; i++) {
+		for (std::map<int, double>::const_iterator it =
+				_compiledTransitions[i].begin();
+				it != _compiledTransitions[i].end(); ++it) {
+			topology._transitionTargets.push_back(it->first);
+			_transitions.push_back(it->second);
+		}
+
+		topology._transitionOffsets.push_back(
+				topology._transitionTargets.size());
+	}
+
+	// incoming transitions
+	topology._inverseOffsets.assign(_numberNodes + 1, 0);
+	topology._inverseSources.resize(_transitions.size());
+	topology._inverseEdges.resize(_transitions.size());
+
+	for (int e = 0; e < _transitions.size(); e++) {
+		topology._inverseOffsets[topology._transitionTargets[e] + 1]++;
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		topology._inverseOffsets[i + 1] += topology._inverseOffsets[i];
+	}
+
+	std::vector<int> position(topology._inverseOffsets.begin(),
+			topology._inverseOffsets.end() - 1);
+
+	for (int i = 0; i < _numberNodes; i++) {
+		for (int e = topology._transitionOffsets[i];
+				e < topology._transitionOffsets[i + 1]; e++) {
+			int k = position[topology._transitionTargets[e]]++;
+
+			topology._inverseSources[k] = i;
+			topology._inverseEdges[k] = e;
+		}
+	}
+
+	// emission alphabet and emission sets
+	topology._symbols.clear();
+	topology._symbolIds.clear();
+	topology._emissionOffsets.assign(1, 0);
+	topology._emissionSymbols.clear();
+
+	for (int i = 0; i < _numberNodes; i++) {
+		for (std::map<std::string, double>::const_iterator it =
+				_compiledEmissions[i].begin();
+				it != _compiledEmissions[i].end(); ++it) {
+			topology._emissionSymbols.push_back(topology.addSymbol(it->first));
+		}
+
+		topology._emissionOffsets.push_back(topology._emissionSymbols.size());
+	}
+
+	_emissions.assign(topology.getNumberSymbols() * _numberNodes, 0);
+
+	for (int i = 0; i < _numberNodes; i++) {
+		for (std::map<std::string, double>::const_iterator it =
+				_compiledEmissions[i].begin();
+				it != _compiledEmissions[i].end(); ++it) {
+			_emissions[topology.getSymbolId(it->first) * _numberNodes + i] =
+					it->second;
+		}
+	}
+
+	_compiledTransitions.clear();
+	_compiledEmissions.clear();
+
+	topology._emittingStates.clear();
+	topology._silentLast = false;
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (isSilent(i)) {
+			silentStates.push_back(i);
+		} else {
+			topology._emittingStates.push_back(i);
+		}
+	}
+
+	// silent states with the highest indices allow isSilent to be a range check
+	topology._silentLast = silentStates.empty()
+			|| silentStates.front() == topology._emittingStates.size();
+
+	for (std::vector<int>::const_iterator it = silentStates.begin();
+			it != silentStates.end(); ++it) {
 		incomingEdges[*it] = 0;
 	}
 
 	//calculate number incoming edges for every node
-	for (boost::unordered_set<int>::const_iterator it = _silentStates.begin();
-			it != _silentStates.end(); ++it) {
+	for (std::vector<int>::const_iterator it = silentStates.begin();
+			it != silentStates.end(); ++it) {
 		std::vector<int> children;
 
-		for (boost::unordered_set<int>::const_iterator jt =
-				_silentStates.begin(); jt != _silentStates.end(); ++jt) {
+		for (std::vector<int>::const_iterator jt = silentStates.begin();
+				jt != silentStates.end(); ++jt) {
 			if (getTransition(*it, *jt) != 0) {
 				if (*it == *jt) {
 					throw std::invalid_argument(
@@ -334,8 +559,8 @@ void HMMCompiled::finishCompilation() {
 	}
 
 	// order states according to their incoming degree in increasing order
-	for (boost::unordered_set<int>::const_iterator it = _silentStates.begin();
-			it != _silentStates.end(); ++it) {
+	for (std::vector<int>::const_iterator it = silentStates.begin();
+			it != silentStates.end(); ++it) {
 		handle = heap.push(Pair<int>(incomingEdges[*it], *it));
 		mapping.emplace(*it, handle);
 	}
@@ -344,6 +569,8 @@ void HMMCompiled::finishCompilation() {
 	// of a silent state can be calculated if all the probabilities of the incoming edges have
 	// been calculated. To make a long story short, we have to find a ordering of a DAG such that
 	// all nodes which have a transition into this node are ordered before the respective node.
+	topology._silentStateOrder.clear();
+
 	while (!heap.empty()) {
 		Pair<int> pair = heap.top();
 		heap.pop();
@@ -353,7 +580,7 @@ void HMMCompiled::finishCompilation() {
 			throw std::invalid_argument("HMM contains silent states cycle.");
 		}
 
-		_silentStateOrder.push_back(pair._second);
+		topology._silentStateOrder.push_back(pair._second);
 		std::vector<int>& children = deps.at(pair._second);
 		for (std::vector<int>::const_iterator it = children.begin();
 				it != children.end(); ++it) {
@@ -364,12 +591,168 @@ void HMMCompiled::finishCompilation() {
 		}
 	}
 
+	// only the parameters of these nodes are counted by the Baum-Welch algorithm
+	topology._learnableTransitionNodes.clear();
+	topology._learnableEmissionNodes.clear();
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantTransitions(i)
+				&& topology._transitionOffsets[i]
+						!= topology._transitionOffsets[i + 1]) {
+			topology._learnableTransitionNodes.push_back(i);
+		}
+
+		if (!isSilent(i) && !hasConstantEmissions(i)) {
+			topology._learnableEmissionNodes.push_back(i);
+		}
+	}
+
+	// no node is tied
+	topology._emissionTies.resize(_numberNodes);
+	topology._transitionTies.resize(_numberNodes);
+
+	for (int i = 0; i < _numberNodes; i++) {
+		topology._emissionTies[i] = i;
+		topology._transitionTies[i] = i;
+	}
+}
+
+void HMMCompiled::buildTies() {
+	HMMTopology& topology = mutableTopology();
+	boost::unordered_map<std::string, int> emissionGroups;
+	boost::unordered_map<std::string, int> transitionGroups;
+
+	// the nodes are visited in increasing order, thus the first node of a group is its
+	// smallest one
 	for (int i = 0; i < _numberNodes; i++) {
-		for (boost::unordered_map<std::string, double>::const_iterator it =
-				_emissions[i].begin(); it != _emissions[i].end(); ++it) {
-			_supersetEmissions.insert(it->first);
+		const std::string& emissionTie = topology._nodes[i]->emissionTie();
+		const std::string& transitionTie = topology._nodes[i]->transitionTie();
+
+		if (!emissionTie.empty()) {
+			int first = emissionGroups.emplace(emissionTie, i).first->second;
+
+			if (isSilent(i)
+					|| hasConstantEmissions(i) != hasConstantEmissions(first)
+					|| hasConstantEmissionSet(i)
+							!= hasConstantEmissionSet(first)
+					|| topology._emissionOffsets[i + 1]
+							- topology._emissionOffsets[i]
+							!= topology._emissionOffsets[first + 1]
+									- topology._emissionOffsets[first]
+					|| !std::equal(
+							topology._emissionSymbols.begin()
+									+ topology._emissionOffsets[i],
+							topology._emissionSymbols.begin()
+									+ topology._emissionOffsets[i + 1],
+							topology._emissionSymbols.begin()
+									+ topology._emissionOffsets[first])) {
+				throw std::invalid_argument(
+						"HMM contains incompatible nodes with tied emissions:"
+								+ emissionTie);
+			}
+
+			topology._emissionTies[i] = first;
+		}
+
+		if (!transitionTie.empty()) {
+			int first = transitionGroups.emplace(transitionTie, i).first->second;
+			int degree = topology._transitionOffsets[i + 1]
+					- topology._transitionOffsets[i];
+
+			// the targets are sorted, thus the k-th transitions of the nodes are tied
+			if (hasConstantTransitions(i) != hasConstantTransitions(first)
+					|| degree
+							!= topology._transitionOffsets[first + 1]
+									- topology._transitionOffsets[first]
+					|| !std::equal(
+							topology._transitionTargets.begin()
+									+ topology._transitionOffsets[i],
+							topology._transitionTargets.begin()
+									+ topology._transitionOffsets[i + 1],
+							topology._transitionTargets.begin()
+									+ topology._transitionOffsets[first])) {
+				throw std::invalid_argument(
+						"HMM contains incompatible nodes with tied transitions:"
+								+ transitionTie);
+			}
+
+			topology._transitionTies[i] = first;
+		}
+	}
+}
+
+void HMMCompiled::extendAlphabet(const EncodedSequences& sequences) {
+	const std::vector<std::string>& alphabet = sequences.getAlphabet();
+	std::vector<int> identity(alphabet.size());
+	std::vector<bool> seen(alphabet.size(), false);
+	std::vector<int> codes;
+
+	for (int c = 0; c < alphabet.size(); c++) {
+		identity[c] = c;
+	}
+
+	// the symbols are added in the order of their first occurrence
+	for (int k = 0; k < sequences.size(); k++) {
+		codes.resize(sequences.getLength(k));
+
+		if (codes.empty()) {
+			continue;
+		}
+
+		sequences.encode(k, &identity[0], &codes[0]);
+
+		for (int t = 0; t < codes.size(); t++) {
+			if (!seen[codes[t]]) {
+				seen[codes[t]] = true;
+
+				if (_topology->getSymbolId(alphabet[codes[t]]) < 0) {
+					mutableTopology().addSymbol(alphabet[codes[t]]);
+				}
+			}
 		}
 	}
+
+	// the emissions are stored symbol by symbol, thus new symbols are appended
+	_emissions.resize(_topology->getNumberSymbols() * _numberNodes, 0);
+}
+
+void HMMCompiled::symbolTable(const std::vector<std::string>& alphabet,
+		std::vector<int>& table) const {
+	table.resize(alphabet.size());
+
+	for (int c = 0; c < alphabet.size(); c++) {
+		table[c] = _topology->getSymbolId(alphabet[c]);
+	}
+}
+
+void HMMCompiled::encode(const std::vector<std::string>& sequence,
+		int* symbols) const {
+	for (int t = 0; t < sequence.size(); t++) {
+		symbols[t] = _topology->getSymbolId(sequence[t]);
+	}
+}
+
+void HMMCompiled::encode(const PackedSequence& sequence, int* symbols) const {
+	int table[4];
+
+	for (int b = 0; b < 4; b++) {
+		table[b] = _topology->getSymbolId(PackedSequence::getSymbol(b));
+	}
+
+	sequence.encode(table, 0, sequence.size(), symbols);
+}
+
+void HMMCompiled::encode(const SequenceBatch::Span& sequence,
+		int* symbols) const {
+	const std::vector<std::string>& alphabet =
+			sequence.getBatch().getAlphabet();
+	int table[SequenceBatch::MAX_SYMBOLS];
+
+	for (int c = 0; c < alphabet.size(); c++) {
+		table[c] = _topology->getSymbolId(alphabet[c]);
+	}
+
+	sequence.encode(table, symbols);
 }
 
 /**
@@ -387,21 +770,55 @@ double HMMCompiled::elnsum(double x, double y) {
 	}
 }
 
-double HMMCompiled::forward(const std::vector<std::string>& sequence) {
-	double* prev = new double[_numberNodes];
-	double* cur = new double[_numberNodes];
+double HMMCompiled::forward(const std::vector<std::string>& sequence) const {
+	DPWorkspace workspace;
+
+	return forward(sequence, workspace);
+}
+
+double HMMCompiled::forward(const std::vector<std::string>& sequence,
+		DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+
+	return forward(symbols, sequence.size(), workspace);
+}
+
+double HMMCompiled::forward(const PackedSequence& sequence,
+		DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+
+	return forward(symbols, sequence.size(), workspace);
+}
+
+double HMMCompiled::forward(const SequenceBatch::Span& sequence,
+		DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+
+	return forward(symbols, sequence.size(), workspace);
+}
+
+double HMMCompiled::forward(const int* symbols, int length,
+		DPWorkspace& workspace) const {
+	const HMMTopology& topology = *_topology;
+	double* prev = workspace.getDoubles(_numberNodes);
+	double* cur = workspace.getDoubles(_numberNodes);
 	double *temp;
 	double result = -std::numeric_limits<double>::infinity();
 
-	std::vector<std::string>::const_iterator it = sequence.begin();
-
 	for (int i = 0; i < _numberNodes; i++) {
-		cur[i] = getLogInitialDistribution(i) + getLogEmission(i, *it);
+		cur[i] = getLogInitialDistribution(i) + logEmission(i, symbols[0]);
 	}
 
-	++it;
-
-	for (; it != sequence.end(); ++it) {
+	for (int t = 1; t < length; t++) {
 		temp = prev;
 		prev = cur;
 		cur = temp;
@@ -411,28 +828,29 @@ double HMMCompiled::forward(const std::vector<std::string>& sequence) {
 			cur[i] = -std::numeric_limits<double>::infinity();
 			if (!isSilent(i)) {
 				// forward(i,t) = sum_{j=1}^{N} forward(j,t-1)*transition(j,i)*emission(i,sequence(i))
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						_imapTransitions[i].begin();
-						jt != _imapTransitions[i].end(); ++jt) {
+				for (int k = topology._inverseOffsets[i];
+						k < topology._inverseOffsets[i + 1]; k++) {
 					cur[i] = elnsum(cur[i],
-							prev[jt->first] + std::log(jt->second));
+							prev[topology._inverseSources[k]]
+									+ logTransition(topology._inverseEdges[k]));
 				}
 
-				cur[i] = cur[i] + getLogEmission(i, *it);
+				cur[i] = cur[i] + logEmission(i, symbols[t]);
 			}
 		}
 
 		// silent states
-		for (std::vector<int>::const_iterator order = _silentStateOrder.begin();
-				order != _silentStateOrder.end(); ++order) {
+		for (std::vector<int>::const_iterator order =
+				topology._silentStateOrder.begin();
+				order != topology._silentStateOrder.end(); ++order) {
 			int node = *order;
 
 			// forward(i,t) = sum_{j=1}^{N} forward(j,t)*transition(j,i)
-			for (boost::unordered_map<int, double>::const_iterator jt =
-					_imapTransitions[node].begin();
-					jt != _imapTransitions[node].end(); ++jt) {
+			for (int k = topology._inverseOffsets[node];
+					k < topology._inverseOffsets[node + 1]; k++) {
 				cur[node] = elnsum(cur[node],
-						cur[jt->first] + std::log(jt->second));
+						cur[topology._inverseSources[k]]
+								+ logTransition(topology._inverseEdges[k]));
 			}
 		}
 	}
@@ -442,19 +860,28 @@ double HMMCompiled::forward(const std::vector<std::string>& sequence) {
 		result = elnsum(result, cur[i]);
 	}
 
-	delete[] prev;
-	delete[] cur;
-
 	// log-space
 	return result;
 }
 
-double HMMCompiled::backward(const std::vector<std::string>& sequence) {
-	double* prev = new double[_numberNodes];
-	double* cur = new double[_numberNodes];
+double HMMCompiled::backward(const std::vector<std::string>& sequence) const {
+	DPWorkspace workspace;
+
+	return backward(sequence, workspace);
+}
+
+double HMMCompiled::backward(const std::vector<std::string>& sequence,
+		DPWorkspace& workspace) const {
+	const HMMTopology& topology = *_topology;
+	workspace.reset();
+	double* prev = workspace.getDoubles(_numberNodes);
+	double* cur = workspace.getDoubles(_numberNodes);
+	int* symbols = workspace.getInts(sequence.size());
 	double *temp;
 	double result = -std::numeric_limits<double>::infinity();
 
+	encode(sequence, symbols);
+
 	for (int i = 0; i < _numberNodes; i++) {
 		cur[i] = 0;
 	}
@@ -468,26 +895,25 @@ double HMMCompiled::backward(const std::vector<std::string>& sequence) {
 			cur[i] = -std::numeric_limits<double>::infinity();
 			if (!isSilent(i)) {
 				// backward(i,t-1) = sum_{j=1}^{N} backward(j,t)*emission(j,sequence(t))*transition(i,j)
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						_mapTransitions[i].begin();
-						jt != _mapTransitions[i].end(); ++jt) {
+				for (int e = topology._transitionOffsets[i];
+						e < topology._transitionOffsets[i + 1]; e++) {
+					int j = topology._transitionTargets[e];
+
 					cur[i] = elnsum(cur[i],
-							prev[jt->first]
-									+ getLogEmission(jt->first, sequence[k])
-									+ std::log(jt->second));
+							prev[j] + logEmission(j, symbols[k])
+									+ logTransition(e));
 				}
 			}
 		}
 
 		// silent states
-		for (int i = _silentStateOrder.size() - 1; i >= 0; i--) {
-			int node = _silentStateOrder[i];
+		for (int i = topology._silentStateOrder.size() - 1; i >= 0; i--) {
+			int node = topology._silentStateOrder[i];
 			// backward(i,t) = sum_{j=1}^{N} backward(j,t)*transition(i,j)
-			for (boost::unordered_map<int, double>::const_iterator jt =
-					_mapTransitions[node].begin();
-					jt != _mapTransitions[node].end(); ++jt) {
+			for (int e = topology._transitionOffsets[node];
+					e < topology._transitionOffsets[node + 1]; e++) {
 				cur[node] = elnsum(cur[node],
-						cur[jt->first] + std::log(jt->second));
+						cur[topology._transitionTargets[e]] + logTransition(e));
 			}
 		}
 	}
@@ -500,16 +926,16 @@ double HMMCompiled::backward(const std::vector<std::string>& sequence) {
 	for (int i = 0; i < _numberNodes; i++) {
 		cur[i] = -std::numeric_limits<double>::infinity();
 		if (!isSilent(i)) {
-			cur[i] = getLogEmission(i, sequence[0]) + prev[i];
+			cur[i] = logEmission(i, symbols[0]) + prev[i];
 		}
 	}
 
-	for (int i = _silentStateOrder.size() - 1; i >= 0; i--) {
-		int node = _silentStateOrder[i];
-		for (boost::unordered_map<int, double>::const_iterator jt =
-				_mapTransitions[node].begin();
-				jt != _mapTransitions[node].end(); ++jt) {
-			cur[node] = elnsum(cur[node], jt->second + cur[jt->first]);
+	for (int i = topology._silentStateOrder.size() - 1; i >= 0; i--) {
+		int node = topology._silentStateOrder[i];
+		for (int e = topology._transitionOffsets[node];
+				e < topology._transitionOffsets[node + 1]; e++) {
+			cur[node] = elnsum(cur[node],
+					_transitions[e] + cur[topology._transitionTargets[e]]);
 		}
 	}
 
@@ -518,29 +944,33 @@ double HMMCompiled::backward(const std::vector<std::string>& sequence) {
 		result = elnsum(result, cur[i] + getLogInitialDistribution(i));
 	}
 
-	delete[] prev;
-	delete[] cur;
-
 	return result;
 }
 
 void HMMCompiled::viterbi(const std::vector<std::string>& sequence,
-		std::vector<int>& stateSequence) {
-	double* prev = new double[_numberNodes];
-	double* cur = new double[_numberNodes];
-	int* backtrack = new int[_numberNodes * (sequence.size() - 1)];
+		std::vector<int>& stateSequence) const {
+	DPWorkspace workspace;
+
+	viterbi(sequence, stateSequence, workspace);
+}
+
+int HMMCompiled::viterbiMatrix(const int* symbols, int length,
+		DPWorkspace& workspace, const int*& backtrackMatrix) const {
+	const HMMTopology& topology = *_topology;
+	double* prev = workspace.getDoubles(_numberNodes);
+	double* cur = workspace.getDoubles(_numberNodes);
+	int* backtrack = workspace.getInts(
+			length == 0 ? 0 : _numberNodes * (length - 1));
 	double *temp;
 	double maxProb;
 	int maxPred;
 	int counter = 0;
 
-	std::vector<std::string>::const_iterator it = sequence.begin();
-
 	for (int i = 0; i < _numberNodes; i++) {
-		cur[i] = getLogInitialDistribution(i) + getLogEmission(i, *it);
+		cur[i] = getLogInitialDistribution(i) + logEmission(i, symbols[0]);
 	}
 
-	for (++it; it != sequence.end(); ++it, counter++) {
+	for (int t = 1; t < length; t++, counter++) {
 		temp = prev;
 		prev = cur;
 		cur = temp;
@@ -551,32 +981,38 @@ void HMMCompiled::viterbi(const std::vector<std::string>& sequence,
 				maxProb = -std::numeric_limits<double>::infinity();
 				maxPred = -1;
 
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						_imapTransitions[i].begin();
-						jt != _imapTransitions[i].end(); ++jt) {
-					if (maxProb < prev[jt->first] + std::log(jt->second)) {
-						maxProb = prev[jt->first] + std::log(jt->second);
-						maxPred = jt->first;
+				for (int k = topology._inverseOffsets[i];
+						k < topology._inverseOffsets[i + 1]; k++) {
+					int j = topology._inverseSources[k];
+					double prob = prev[j]
+							+ logTransition(topology._inverseEdges[k]);
+
+					if (maxProb < prob) {
+						maxProb = prob;
+						maxPred = j;
 					}
 				}
 
-				cur[i] = maxProb + getLogEmission(i, *it);
+				cur[i] = maxProb + logEmission(i, symbols[t]);
 				// store best predecessor for i
 				backtrack[counter * _numberNodes + i] = maxPred;
 			}
 		}
 
-		for (std::vector<int>::const_iterator jt = _silentStateOrder.begin();
-				jt != _silentStateOrder.end(); ++jt) {
+		for (std::vector<int>::const_iterator jt =
+				topology._silentStateOrder.begin();
+				jt != topology._silentStateOrder.end(); ++jt) {
 			maxProb = -std::numeric_limits<double>::infinity();
 			maxPred = -1;
 
-			for (boost::unordered_map<int, double>::const_iterator kt =
-					_imapTransitions[*jt].begin();
-					kt != _imapTransitions[*jt].end(); ++kt) {
-				if (maxProb < cur[kt->first] + std::log(kt->second)) {
-					maxProb = cur[kt->first] + std::log(kt->second);
-					maxPred = kt->first;
+			for (int k = topology._inverseOffsets[*jt];
+					k < topology._inverseOffsets[*jt + 1]; k++) {
+				int j = topology._inverseSources[k];
+				double prob = cur[j] + logTransition(topology._inverseEdges[k]);
+
+				if (maxProb < prob) {
+					maxProb = prob;
+					maxPred = j;
 				}
 			}
 
@@ -595,10 +1031,47 @@ void HMMCompiled::viterbi(const std::vector<std::string>& sequence,
 		}
 	}
 
+	backtrackMatrix = backtrack;
+
+	return maxPred;
+}
+
+void HMMCompiled::viterbi(const std::vector<std::string>& sequence,
+		std::vector<int>& stateSequence, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+	viterbi(symbols, sequence.size(), stateSequence, workspace);
+}
+
+void HMMCompiled::viterbi(const PackedSequence& sequence,
+		std::vector<int>& stateSequence, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+	viterbi(symbols, sequence.size(), stateSequence, workspace);
+}
+
+void HMMCompiled::viterbi(const SequenceBatch::Span& sequence,
+		std::vector<int>& stateSequence, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+	viterbi(symbols, sequence.size(), stateSequence, workspace);
+}
+
+void HMMCompiled::viterbi(const int* symbols, int length,
+		std::vector<int>& stateSequence, DPWorkspace& workspace) const {
+	const int* backtrack;
+	int maxPred = viterbiMatrix(symbols, length, workspace, backtrack);
+
 	stateSequence.push_back(maxPred);
 
 	// backtrack sequence
-	for (int i = counter - 1; i >= 0; i--) {
+	for (int i = length - 2; i >= 0; i--) {
 		do {
 			stateSequence.push_back(backtrack[i * _numberNodes + maxPred]);
 			maxPred = backtrack[i * _numberNodes + maxPred];
@@ -607,369 +1080,583 @@ void HMMCompiled::viterbi(const std::vector<std::string>& sequence,
 
 	// reverse found backtracked sequence
 	std::reverse(stateSequence.begin(), stateSequence.end());
-
-	delete[] prev;
-	delete[] cur;
-	delete[] backtrack;
 }
 
-void HMMCompiled::internalBaumWelch(
-		const std::vector<std::vector<std::string> >& trainingset,
-		boost::unordered_map<int, double>* cTransitions,
-		boost::unordered_map<std::string, double>* cEmissions, double* cInitial,
-		bool initialRun) {
+void HMMCompiled::clearCounts(std::vector<double>& cTransitions,
+		std::vector<double>& cEmissions, std::vector<double>& cInitial) const {
+	cTransitions.assign(_transitions.size(), 0);
+	cEmissions.assign(_emissions.size(), 0);
+	cInitial.assign(_numberNodes, 0);
+}
 
-	for (std::vector<std::vector<std::string> >::const_iterator it =
-			trainingset.begin(); it != trainingset.end(); ++it) {
-		double * forward = new double[_numberNodes * (it->size())];
-		double * backward = new double[_numberNodes * (it->size())];
-		double probWord = -std::numeric_limits<double>::infinity();
-		boost::unordered_map<std::string, double> temp;
+void HMMCompiled::poolTiedCounts(std::vector<double>& cTransitions,
+		std::vector<double>& cEmissions) const {
+	const HMMTopology& topology = *_topology;
+	const int numberSymbols = topology.getNumberSymbols();
 
-		if (initialRun)
-			_supersetEmissions.insert(it->at(0));
+	// sum up the counts of every group in its first node
+	for (int i = 0; i < _numberNodes; i++) {
+		int first = topology._emissionTies[i];
 
-		//calculate forward function
-		for (int i = 0; i < _numberNodes; i++) {
-			forward[i] = getLogInitialDistribution(i)
-					+ getLogEmission(i, it->at(0));
+		if (first != i) {
+			for (int a = 0; a < numberSymbols; a++) {
+				cEmissions[a * _numberNodes + first] += cEmissions[a
+						* _numberNodes + i];
+			}
 		}
 
-		for (int c = 1; c < it->size(); c++) {
-			// collect all possible outputs in _supersetEmissions for the later smoothing
-			if (initialRun)
-				_supersetEmissions.insert(it->at(c));
-
-			for (int i = 0; i < _numberNodes; i++) {
-				forward[_numberNodes * c + i] =
-						-std::numeric_limits<double>::infinity();
-				if (!isSilent(i)) {
-					// forward(i,t) = sum_{j=1}^{N} forward(j,t-1)*transition(j,i)*emission(i,sequence(t))
-					for (boost::unordered_map<int, double>::const_iterator jt =
-							_imapTransitions[i].begin();
-							jt != _imapTransitions[i].end(); ++jt) {
-						forward[_numberNodes * c + i] = elnsum(
-								forward[_numberNodes * c + i],
-								forward[_numberNodes * (c - 1) + jt->first]
-										+ std::log(jt->second));
-					}
+		first = topology._transitionTies[i];
 
-					forward[_numberNodes * c + i] =
-							forward[_numberNodes * c + i]
-									+ getLogEmission(i, it->at(c));
-				}
+		if (first != i) {
+			for (int k = 0;
+					k < topology._transitionOffsets[i + 1]
+							- topology._transitionOffsets[i]; k++) {
+				cTransitions[topology._transitionOffsets[first] + k] +=
+						cTransitions[topology._transitionOffsets[i] + k];
 			}
+		}
+	}
 
-			for (int i = 0; i < _silentStateOrder.size(); i++) {
-				int node = _silentStateOrder[i];
+	// the first nodes precede the other nodes of their group
+	for (int i = 0; i < _numberNodes; i++) {
+		int first = topology._emissionTies[i];
 
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						_imapTransitions[node].begin();
-						jt != _imapTransitions[node].end(); ++jt) {
-					forward[_numberNodes * c + node] = elnsum(
-							forward[_numberNodes * c + node],
-							forward[_numberNodes * c + jt->first]
-									+ std::log(jt->second));
-				}
+		if (first != i) {
+			for (int a = 0; a < numberSymbols; a++) {
+				cEmissions[a * _numberNodes + i] = cEmissions[a * _numberNodes
+						+ first];
 			}
 		}
 
-		// probability of this sequence being emitted by this model
-		for (int i = 0; i < _numberNodes; i++) {
-			probWord = elnsum(probWord,
-					forward[i + _numberNodes * (it->size() - 1)]);
-		}
-
-		if (probWord == -std::numeric_limits<double>::infinity()) {
-			if (initialRun) {
-				std::cerr << "Data not representable by model" << std::endl;
+		first = topology._transitionTies[i];
 
-				for (int i = 0; i < it->size(); i++) {
-					std::cerr << it->at(i);
-				}
-				std::cerr << std::endl;
+		if (first != i) {
+			std::copy(
+					cTransitions.begin() + topology._transitionOffsets[first],
+					cTransitions.begin()
+							+ topology._transitionOffsets[first + 1],
+					cTransitions.begin() + topology._transitionOffsets[i]);
+		}
+	}
+}
 
-				for (int t = 0; t < it->size(); t++) {
-					double s = -std::numeric_limits<double>::infinity();
-					for (int i = 0; i < _numberNodes; i++) {
-						s = elnsum(s, forward[i + t * _numberNodes]);
-					}
+void HMMCompiled::applyTies() {
+	const HMMTopology& topology = *_topology;
 
-					if (s == -std::numeric_limits<double>::infinity()) {
-						std::cerr << "Break:" << t << std::endl;
-						for (int i = std::max(0, t - 5); i <= t; i++) {
-							std::cerr << it->at(i);
-						}
+	for (int i = 0; i < _numberNodes; i++) {
+		int first = topology._emissionTies[i];
 
-						std::cerr << std::endl;
-						break;
-					}
-				}
+		if (first != i) {
+			for (int a = 0; a < topology.getNumberSymbols(); a++) {
+				_emissions[a * _numberNodes + i] = _emissions[a * _numberNodes
+						+ first];
 			}
-
-			delete[] forward;
-			delete[] backward;
-			continue;
 		}
 
-		//calculate backward function
-		for (int i = 0; i < _numberNodes; i++) {
-			backward[i + _numberNodes * (it->size() - 1)] = 0;
+		first = topology._transitionTies[i];
+
+		if (first != i) {
+			std::copy(_transitions.begin() + topology._transitionOffsets[first],
+					_transitions.begin() + topology._transitionOffsets[first + 1],
+					_transitions.begin() + topology._transitionOffsets[i]);
 		}
+	}
+}
 
-		for (int c = it->size() - 2; c >= 0; c--) {
-			for (int i = 0; i < _numberNodes; i++) {
-				backward[i + _numberNodes * c] =
-						-std::numeric_limits<double>::infinity();
-				if (!isSilent(i)) {
-					// backward(i,t-1) = sum_{j=1}^{N} backward(j,t)*transition(i,j)*emission(j,sequence(t))
-					for (boost::unordered_map<int, double>::const_iterator jt =
-							_mapTransitions[i].begin();
-							jt != _mapTransitions[i].end(); ++jt) {
-						backward[i + _numberNodes * c] = elnsum(
-								backward[i + _numberNodes * c],
-								backward[jt->first + _numberNodes * (c + 1)]
-										+ std::log(jt->second)
-										+ getLogEmission(jt->first,
-												it->at(c + 1)));
-					}
-				}
-			}
+double HMMCompiled::internalBaumWelch(const EncodedSequences& trainingset,
+		const std::vector<std::vector<uint8_t> >* labels,
+		std::vector<double>& cTransitions, std::vector<double>& cEmissions,
+		std::vector<double>& cInitial, bool initialRun) {
+	double logLikelihood = 0;
 
-			for (int i = _silentStateOrder.size() - 1; i >= 0; i--) {
-				int node = _silentStateOrder[i];
+	if (!_trainingWorkspace) {
+		_trainingWorkspace.reset(new DPWorkspace());
+	}
 
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						_mapTransitions[i].begin();
-						jt != _mapTransitions[i].end(); ++jt) {
-					backward[node + _numberNodes * c] = elnsum(
-							backward[node + _numberNodes * c],
-							backward[jt->first + _numberNodes * c]
-									+ std::log(jt->second));
-				}
-			}
-		}
+	// collect all possible outputs in the alphabet for the later smoothing
+	if (initialRun) {
+		extendAlphabet(trainingset);
+		cEmissions.resize(_emissions.size(), 0);
+	}
 
-		// calculate contributions
-		// transitions
-		for (int i = 0; i < _numberNodes; i++) {
-			for (boost::unordered_map<int, double>::const_iterator jt =
-					_mapTransitions[i].begin(); jt != _mapTransitions[i].end();
-					++jt) {
-				double numerator = -std::numeric_limits<double>::infinity();
-
-				if (isSilent(jt->first)) {
-					for (int t = 0; t < it->size() - 1; t++) {
-						numerator =
-								elnsum(numerator,
-										forward[t * _numberNodes + i]
-												+ backward[t * _numberNodes
-														+ jt->first]);
-					}
-				} else {
-					//cTransitions[i][j] = sum_{t=1}^{L} forward(i,t)*backward(j,t+1)*transition(i,j)*
-					// emission(j,sequence(t+1))/Pr(sequence)
-					for (int t = 0; t < it->size() - 1; t++) {
-						numerator = elnsum(numerator,
-								forward[t * _numberNodes + i]
-										+ backward[(t + 1) * _numberNodes
-												+ jt->first]
-										+ getLogEmission(jt->first,
-												it->at(t + 1)));
-					}
-				}
-				cTransitions[i][jt->first] += std::exp(
-						numerator + std::log(jt->second) - probWord);
-			}
+	// symbol ids of the codes of the training set
+	std::vector<int> table;
+	symbolTable(trainingset.getAlphabet(), table);
+
+	for (int k = 0; k < trainingset.size(); k++) {
+		int length = trainingset.getLength(k);
+
+		_trainingWorkspace->reset();
+		int* symbols = _trainingWorkspace->getInts(length);
+
+		if (length > 0) {
+			trainingset.encode(k, &table[0], symbols);
 		}
 
-		// emissions
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!isSilent(i)) {
-				for (boost::unordered_set<std::string>::const_iterator jt =
-						_supersetEmissions.begin();
-						jt != _supersetEmissions.end(); ++jt) {
-					temp[*jt] = -std::numeric_limits<double>::infinity();
-				}
+		logLikelihood += expectationStep(symbols, length,
+				labels != NULL ? &labels->at(k) : NULL, cTransitions,
+				cEmissions, cInitial, initialRun);
+	}
 
-				// cEmission[i][symbol] = sum_{t=1}^{L} forward(i,t)*backward(i,t)/Pr(sequence)*
-				//	1(sequence(t)==symbol)
-				for (int t = 0; t < it->size(); t++) {
-					temp[it->at(t)] = elnsum(temp[it->at(t)],
-							forward[t * _numberNodes + i]
-									+ backward[t * _numberNodes + i]);
-				}
+	return logLikelihood;
+}
 
-				for (boost::unordered_map<std::string, double>::const_iterator jt =
-						temp.begin(); jt != temp.end(); ++jt) {
-					double prob = std::exp(jt->second - probWord);
+double HMMCompiled::expectationStep(const int* symbols, int length,
+		const std::vector<uint8_t>* label,
+		std::vector<double>& cTransitions, std::vector<double>& cEmissions,
+		std::vector<double>& cInitial, bool initialRun) {
+	const HMMTopology& topology = *_topology;
+	const int numberSymbols = topology.getNumberSymbols();
+	double * forward = _trainingWorkspace->getDoubles(_numberNodes * length);
+	double * backward = _trainingWorkspace->getDoubles(_numberNodes * length);
+	double* temp = _trainingWorkspace->getDoubles(numberSymbols);
+	double probWord = -std::numeric_limits<double>::infinity();
+	// positions[columnBegin[i]],...,positions[columnEnd[i]-1] are the positions at which
+	// state i is allowed to emit a symbol. The first length entries are all positions, the
+	// following ones are the positions grouped by their label.
+	int* positions = _trainingWorkspace->getInts(
+			label == NULL ? length : 2 * length);
+	int* columnBegin = _trainingWorkspace->getInts(_numberNodes);
+	int* columnEnd = _trainingWorkspace->getInts(_numberNodes);
+
+	for (int t = 0; t < length; t++) {
+		positions[t] = t;
+	}
 
-					if (prob > 0)
-						cEmissions[i][jt->first] += prob;
-				}
+	for (int i = 0; i < _numberNodes; i++) {
+		columnBegin[i] = 0;
+		columnEnd[i] = length;
+	}
+
+	// restrict every position to the states whose structure label matches
+	if (label != NULL) {
+		if (label->size() != length) {
+			throw std::invalid_argument(
+					"internalBaumWelch: Sequence and labels differ in length.");
+		}
+
+		const int numberLabels = topology._labelNames.size();
+		// positions of the label l start at labelOffsets[l]
+		int* labelOffsets = _trainingWorkspace->getInts(numberLabels + 1);
+		int* labelEnds = _trainingWorkspace->getInts(numberLabels);
+
+		for (int l = 0; l <= numberLabels; l++) {
+			labelOffsets[l] = 0;
+		}
+
+		for (int t = 0; t < length; t++) {
+			labelOffsets[(*label)[t] + 1]++;
+		}
+
+		for (int l = 0; l < numberLabels; l++) {
+			labelOffsets[l + 1] += labelOffsets[l];
+			labelEnds[l] = length + labelOffsets[l];
+		}
+
+		// the positions of every label stay in ascending order
+		for (int t = 0; t < length; t++) {
+			positions[labelEnds[(*label)[t]]++] = t;
+		}
+
+		for (int i = 0; i < _numberNodes; i++) {
+			if (!isSilent(i)
+					&& topology._stateLabels[i] != HMMTopology::NO_LABEL) {
+				int l = topology._stateLabels[i];
+				columnBegin[i] = length + labelOffsets[l];
+				columnEnd[i] = length + labelOffsets[l + 1];
 			}
 		}
+	}
 
-		// initial distribution
+	//calculate forward function
+	for (int i = 0; i < _numberNodes; i++) {
+		forward[i] = -std::numeric_limits<double>::infinity();
+	}
+
+	const std::vector<int>& initialStates = getAllowedStates(label, 0);
+
+	for (std::vector<int>::const_iterator st = initialStates.begin();
+			st != initialStates.end(); ++st) {
+		forward[*st] = getLogInitialDistribution(*st)
+				+ logEmission(*st, symbols[0]);
+	}
+
+	for (int c = 1; c < length; c++) {
 		for (int i = 0; i < _numberNodes; i++) {
-			cInitial[i] += std::exp(forward[i] + backward[i] - probWord);
+			forward[_numberNodes * c + i] =
+					-std::numeric_limits<double>::infinity();
+		}
+
+		const std::vector<int>& allowedStates = getAllowedStates(label, c);
+
+		for (std::vector<int>::const_iterator st = allowedStates.begin();
+				st != allowedStates.end(); ++st) {
+			int i = *st;
+			// forward(i,t) = sum_{j=1}^{N} forward(j,t-1)*transition(j,i)*emission(i,sequence(t))
+			for (int k = topology._inverseOffsets[i];
+					k < topology._inverseOffsets[i + 1]; k++) {
+				forward[_numberNodes * c + i] = elnsum(
+						forward[_numberNodes * c + i],
+						forward[_numberNodes * (c - 1)
+								+ topology._inverseSources[k]]
+								+ logTransition(topology._inverseEdges[k]));
+			}
+
+			forward[_numberNodes * c + i] = forward[_numberNodes * c + i]
+					+ logEmission(i, symbols[c]);
 		}
 
-		delete[] forward;
-		delete[] backward;
+		for (int i = 0; i < topology._silentStateOrder.size(); i++) {
+			int node = topology._silentStateOrder[i];
+
+			for (int k = topology._inverseOffsets[node];
+					k < topology._inverseOffsets[node + 1]; k++) {
+				forward[_numberNodes * c + node] = elnsum(
+						forward[_numberNodes * c + node],
+						forward[_numberNodes * c
+								+ topology._inverseSources[k]]
+								+ logTransition(topology._inverseEdges[k]));
+			}
+		}
 	}
 
-}
+	// probability of this sequence being emitted by this model
+	for (int i = 0; i < _numberNodes; i++) {
+		probWord = elnsum(probWord,
+				forward[i + _numberNodes * (length - 1)]);
+	}
 
-void HMMCompiled::baumWelch(
-		const std::vector<std::vector<std::string> >& trainingset,
-		double threshold) {
-	boost::unordered_map<int, double>* cTransitions = new boost::unordered_map<
-			int, double>[_numberNodes];
-	boost::unordered_map<std::string, double>* cEmissions =
-			new boost::unordered_map<std::string, double>[_numberNodes];
-	double* cInitial = new double[_numberNodes];
-	double maxDiff, maxDiffTransition, maxDiffEmission, maxDiffInitial;
-	double prob;
-	bool initialRun = true;
+	if (probWord == -std::numeric_limits<double>::infinity()) {
+		if (initialRun) {
+			std::cerr << "Data not representable by model" << std::endl;
 
-	if (trainingset.size() == 0) {
-		std::cerr << "Training set is empty." << std::endl;
-		return;
+			for (int i = 0; i < length; i++) {
+				std::cerr << topology.getSymbol(symbols[i]);
+			}
+			std::cerr << std::endl;
+
+			for (int t = 0; t < length; t++) {
+				double s = -std::numeric_limits<double>::infinity();
+				for (int i = 0; i < _numberNodes; i++) {
+					s = elnsum(s, forward[i + t * _numberNodes]);
+				}
+
+				if (s == -std::numeric_limits<double>::infinity()) {
+					std::cerr << "Break:" << t << std::endl;
+					for (int i = std::max(0, t - 5); i <= t; i++) {
+						std::cerr << topology.getSymbol(symbols[i]);
+					}
+
+					std::cerr << std::endl;
+					break;
+				}
+			}
+		}
+
+		return 0;
 	}
 
-	do {
-		maxDiff = 0;
-		maxDiffTransition = 0;
-		maxDiffEmission = 0;
-		maxDiffInitial = 0;
+	//calculate backward function
+	for (int i = 0; i < _numberNodes; i++) {
+		backward[i + _numberNodes * (length - 1)] =
+				isSilent(i) ? 0 : -std::numeric_limits<double>::infinity();
+	}
+
+	const std::vector<int>& finalStates = getAllowedStates(label,
+			length - 1);
+
+	for (std::vector<int>::const_iterator st = finalStates.begin();
+			st != finalStates.end(); ++st) {
+		backward[*st + _numberNodes * (length - 1)] = 0;
+	}
+
+	for (int c = length - 2; c >= 0; c--) {
 		for (int i = 0; i < _numberNodes; i++) {
-			cTransitions[i].clear();
-			cEmissions[i].clear();
+			backward[i + _numberNodes * c] =
+					-std::numeric_limits<double>::infinity();
 		}
 
-		for (int i = 0; i < _numberNodes; i++) {
-			cInitial[i] = 0;
+		const std::vector<int>& allowedStates = getAllowedStates(label, c);
+
+		for (std::vector<int>::const_iterator st = allowedStates.begin();
+				st != allowedStates.end(); ++st) {
+			int i = *st;
+			// backward(i,t-1) = sum_{j=1}^{N} backward(j,t)*transition(i,j)*emission(j,sequence(t))
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				int j = topology._transitionTargets[e];
+
+				backward[i + _numberNodes * c] = elnsum(
+						backward[i + _numberNodes * c],
+						backward[j + _numberNodes * (c + 1)]
+								+ logTransition(e)
+								+ logEmission(j, symbols[c + 1]));
+			}
 		}
 
-		internalBaumWelch(trainingset, cTransitions, cEmissions, cInitial,
-				initialRun);
+		for (int i = topology._silentStateOrder.size() - 1; i >= 0; i--) {
+			int node = topology._silentStateOrder[i];
 
-		//smoothing of transitions by pseudo counts
-		for (int i = 0; i < _numberNodes; i++) {
-			for (boost::unordered_map<int, double>::iterator jt =
-					cTransitions[i].begin(); jt != cTransitions[i].end();
-					++jt) {
-				jt->second += 1;
+			for (int e = topology._transitionOffsets[node];
+					e < topology._transitionOffsets[node + 1]; e++) {
+				backward[node + _numberNodes * c] = elnsum(
+						backward[node + _numberNodes * c],
+						backward[topology._transitionTargets[e]
+								+ _numberNodes * c] + logTransition(e));
 			}
 		}
+	}
 
-		// smoothing of emissions by pseudo counts
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissionSet(i)) {
-				for (boost::unordered_set<std::string>::const_iterator it =
-						_supersetEmissions.begin();
-						it != _supersetEmissions.end(); ++it) {
-					cEmissions[i][*it] += 1;
+	// calculate contributions. Constant parameters are not updated by the
+	// maximization step, thus only the learnable ones are counted.
+	// transitions
+	for (std::vector<int>::const_iterator node =
+			topology._learnableTransitionNodes.begin();
+			node != topology._learnableTransitionNodes.end(); ++node) {
+		int i = *node;
+		const int* colsBegin = positions + columnBegin[i];
+		const int* colsEnd = positions + columnEnd[i];
+
+		for (int e = topology._transitionOffsets[i];
+				e < topology._transitionOffsets[i + 1]; e++) {
+			int j = topology._transitionTargets[e];
+			double numerator = -std::numeric_limits<double>::infinity();
+
+			if (isSilent(j)) {
+				for (const int* t = colsBegin; t != colsEnd && *t < length - 1;
+						++t) {
+					numerator = elnsum(numerator,
+							forward[*t * _numberNodes + i]
+									+ backward[*t * _numberNodes + j]);
 				}
 			} else {
-				for (boost::unordered_map<std::string, double>::iterator it =
-						_emissions[i].begin(); it != _emissions[i].end();
-						++it) {
-					cEmissions[i][it->first] += 1;
+				//cTransitions[i][j] = sum_{t=1}^{L} forward(i,t)*backward(j,t+1)*transition(i,j)*
+				// emission(j,sequence(t+1))/Pr(sequence)
+				for (const int* t = colsBegin; t != colsEnd && *t < length - 1;
+						++t) {
+					numerator = elnsum(numerator,
+							forward[*t * _numberNodes + i]
+									+ backward[(*t + 1) * _numberNodes + j]
+									+ logEmission(j, symbols[*t + 1]));
 				}
 			}
+			cTransitions[e] += std::exp(
+					numerator + logTransition(e) - probWord);
 		}
+	}
 
-		// new emission probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissions(i)) {
-				double sum = 0;
-
-				if (!hasConstantEmissionSet(i)) {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						sum += it->second;
-					}
+	// emissions
+	for (std::vector<int>::const_iterator node =
+			topology._learnableEmissionNodes.begin();
+			node != topology._learnableEmissionNodes.end(); ++node) {
+		int i = *node;
+		const int* colsBegin = positions + columnBegin[i];
+		const int* colsEnd = positions + columnEnd[i];
 
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						prob = it->second / sum;
-						double eProb = getEmission(i, it->first);
-						if (maxDiffEmission < std::abs(eProb - prob)) {
-							maxDiffEmission = std::abs(eProb - prob);
-						}
+		for (int a = 0; a < numberSymbols; a++) {
+			temp[a] = -std::numeric_limits<double>::infinity();
+		}
 
-						_emissions[i][it->first] = prob;
-					}
-				} else {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						sum += cEmissions[i].at(it->first);
-					}
+		// cEmission[i][symbol] = sum_{t=1}^{L} forward(i,t)*backward(i,t)/Pr(sequence)*
+		//	1(sequence(t)==symbol)
+		for (const int* t = colsBegin; t != colsEnd; ++t) {
+			if (symbols[*t] >= 0) {
+				temp[symbols[*t]] = elnsum(temp[symbols[*t]],
+						forward[*t * _numberNodes + i]
+								+ backward[*t * _numberNodes + i]);
+			}
+		}
 
-					for (boost::unordered_map<std::string, double>::iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						prob = cEmissions[i].at(it->first) / sum;
-						double eProb = it->second;
-						if (maxDiffEmission < std::abs(eProb - prob)) {
-							maxDiffEmission = std::abs(eProb - prob);
-						}
+		for (int a = 0; a < numberSymbols; a++) {
+			cEmissions[a * _numberNodes + i] += std::exp(
+					temp[a] - probWord);
+		}
+	}
 
-						it->second = prob;
-					}
+	// initial distribution
+	for (int i = 0; i < _numberNodes; i++) {
+		cInitial[i] += std::exp(forward[i] + backward[i] - probWord);
+	}
 
-				}
-			}
+	return probWord;
+}
+
+void HMMCompiled::maximizationStep(std::vector<double>& cTransitions,
+		std::vector<double>& cEmissions, std::vector<double>& cInitial,
+		double& maxDiffInitial, double& maxDiffTransition,
+		double& maxDiffEmission) {
+	const HMMTopology& topology = *_topology;
+	const int numberSymbols = topology.getNumberSymbols();
+	double prob;
+	double sum;
+
+	maxDiffInitial = 0;
+	maxDiffTransition = 0;
+	maxDiffEmission = 0;
+
+	// the nodes of a tie group are learned from the counts of the whole group, thus they
+	// get the same probabilities
+	poolTiedCounts(cTransitions, cEmissions);
+
+	//smoothing of transitions by pseudo counts
+	for (std::vector<int>::const_iterator node =
+			topology._learnableTransitionNodes.begin();
+			node != topology._learnableTransitionNodes.end(); ++node) {
+		for (int e = topology._transitionOffsets[*node];
+				e < topology._transitionOffsets[*node + 1]; e++) {
+			cTransitions[e] += 1;
 		}
+	}
 
-		// new transition probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantTransitions(i)) {
-				double sum = 0;
+	// smoothing of emissions by pseudo counts and new emission probabilities. Nodes without
+	// constant emission set may emit every symbol of the alphabet.
+	for (std::vector<int>::const_iterator node =
+			topology._learnableEmissionNodes.begin();
+			node != topology._learnableEmissionNodes.end(); ++node) {
+		int i = *node;
+		double sum = 0;
+
+		if (!hasConstantEmissionSet(i)) {
+			for (int a = 0; a < numberSymbols; a++) {
+				cEmissions[a * _numberNodes + i] += 1;
+				sum += cEmissions[a * _numberNodes + i];
+			}
 
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						cTransitions[i].begin(); jt != cTransitions[i].end();
-						++jt) {
-					sum += jt->second;
+			for (int a = 0; a < numberSymbols; a++) {
+				prob = cEmissions[a * _numberNodes + i] / sum;
+				double eProb = _emissions[a * _numberNodes + i];
+				if (maxDiffEmission < std::abs(eProb - prob)) {
+					maxDiffEmission = std::abs(eProb - prob);
 				}
 
-				for (boost::unordered_map<int, double>::iterator jt =
-						_mapTransitions[i].begin();
-						jt != _mapTransitions[i].end(); ++jt) {
-					double prob = 0;
+				_emissions[a * _numberNodes + i] = prob;
+			}
+		} else {
+			for (int k = topology._emissionOffsets[i];
+					k < topology._emissionOffsets[i + 1]; k++) {
+				int a = topology._emissionSymbols[k];
 
-					if (sum != 0) {
-						prob = cTransitions[i][jt->first] / sum;
-					}
+				cEmissions[a * _numberNodes + i] += 1;
+				sum += cEmissions[a * _numberNodes + i];
+			}
 
-					if (maxDiffTransition < std::abs(jt->second - prob)) {
-						maxDiffTransition = std::abs(jt->second - prob);
-					}
-					jt->second = prob;
-					_imapTransitions[jt->first][i] = prob;
+			for (int k = topology._emissionOffsets[i];
+					k < topology._emissionOffsets[i + 1]; k++) {
+				int a = topology._emissionSymbols[k];
 
+				prob = cEmissions[a * _numberNodes + i] / sum;
+				double eProb = _emissions[a * _numberNodes + i];
+				if (maxDiffEmission < std::abs(eProb - prob)) {
+					maxDiffEmission = std::abs(eProb - prob);
 				}
+
+				_emissions[a * _numberNodes + i] = prob;
 			}
 		}
+	}
 
-		// new initial distribution
-		double sum = 0;
-		for (int i = 0; i < _numberNodes; i++) {
-			sum += cInitial[i];
-		}
+	// new transition probabilities
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantTransitions(i)) {
+			double sum = 0;
 
-		for (int i = 0; i < _numberNodes; i++) {
-			prob = cInitial[i] / sum;
-			if (maxDiffInitial < std::abs(_initialDistribution[i] - prob)) {
-				maxDiffInitial = std::abs(_initialDistribution[i] - prob);
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				sum += cTransitions[e];
+			}
+
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				double prob = 0;
+
+				if (sum != 0) {
+					prob = cTransitions[e] / sum;
+				}
+
+				if (maxDiffTransition < std::abs(_transitions[e] - prob)) {
+					maxDiffTransition = std::abs(_transitions[e] - prob);
+				}
+				_transitions[e] = prob;
 			}
-			_initialDistribution[i] = prob;
 		}
+	}
+
+	// new initial distribution
+	sum = 0;
+	for (int i = 0; i < _numberNodes; i++) {
+		sum += cInitial[i];
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		prob = cInitial[i] / sum;
+		if (maxDiffInitial < std::abs(_initialDistribution[i] - prob)) {
+			maxDiffInitial = std::abs(_initialDistribution[i] - prob);
+		}
+		_initialDistribution[i] = prob;
+	}
+}
+
+void HMMCompiled::baumWelch(
+		const std::vector<std::vector<std::string> >& trainingset,
+		double threshold) {
+	SequenceBatch batch(trainingset);
+
+	thresholdBaumWelch(SequenceBatch::View(batch), NULL, threshold);
+}
+
+void HMMCompiled::baumWelch(const EncodedSequences& trainingset,
+		double threshold) {
+	thresholdBaumWelch(trainingset, NULL, threshold);
+}
+
+void HMMCompiled::baumWelch(
+		const std::vector<std::vector<std::string> >& trainingset,
+		const std::vector<std::vector<std::string> >& labels,
+		double threshold) {
+	SequenceBatch batch(trainingset);
+
+	baumWelch(SequenceBatch::View(batch), labels, threshold);
+}
+
+void HMMCompiled::baumWelch(const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >& labels,
+		double threshold) {
+	if (!hasStateLabels()) {
+		throw std::invalid_argument(
+				"baumWelch: The HMM has no state labels assigned.");
+	}
+
+	if (labels.size() != trainingset.size()) {
+		throw std::invalid_argument(
+				"baumWelch: Every sequence of the training set needs its labels.");
+	}
+
+	std::vector<std::vector<uint8_t> > labelCodes;
+
+	encodeLabels(labels, labelCodes);
+	thresholdBaumWelch(trainingset, &labelCodes, threshold);
+}
+
+void HMMCompiled::thresholdBaumWelch(const EncodedSequences& trainingset,
+		const std::vector<std::vector<uint8_t> >* labels,
+		double threshold) {
+	std::vector<double> cTransitions, cEmissions, cInitial;
+	double maxDiff, maxDiffTransition, maxDiffEmission, maxDiffInitial;
+	bool initialRun = true;
+
+	if (trainingset.size() == 0) {
+		std::cerr << "Training set is empty." << std::endl;
+		return;
+	}
+
+	do {
+		clearCounts(cTransitions, cEmissions, cInitial);
+
+		internalBaumWelch(trainingset, labels, cTransitions, cEmissions,
+				cInitial, initialRun);
+
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
 
 		initialRun = false;
 
@@ -981,209 +1668,438 @@ void HMMCompiled::baumWelch(
 				<< maxDiffEmission << std::endl;
 
 	} while (maxDiff > threshold);
+}
+
+double HMMCompiled::baumWelchStep(
+		const std::vector<std::vector<std::string> >& trainingset,
+		const std::vector<std::vector<std::string> >* labels, bool initialRun) {
+	SequenceBatch batch(trainingset);
+
+	return baumWelchStep(SequenceBatch::View(batch), labels, initialRun);
+}
+
+double HMMCompiled::baumWelchStep(const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >* labels, bool initialRun) {
+	std::vector<std::vector<uint8_t> > labelCodes;
+
+	if (labels != NULL) {
+		if (!hasStateLabels()) {
+			throw std::invalid_argument(
+					"baumWelchStep: The HMM has no state labels assigned.");
+		}
+
+		encodeLabels(*labels, labelCodes);
+	}
+
+	return baumWelchStep(trainingset, labels != NULL ? &labelCodes : NULL,
+			initialRun);
+}
+
+double HMMCompiled::baumWelchStep(const EncodedSequences& trainingset,
+		const std::vector<std::vector<uint8_t> >* labelCodes,
+		bool initialRun) {
+	std::vector<double> cTransitions, cEmissions, cInitial;
+	double maxDiffTransition, maxDiffEmission, maxDiffInitial;
+
+	if (labelCodes != NULL && !hasStateLabels()) {
+		throw std::invalid_argument(
+				"baumWelchStep: The HMM has no state labels assigned.");
+	}
+
+	clearCounts(cTransitions, cEmissions, cInitial);
+
+	internalBaumWelch(trainingset, labelCodes, cTransitions, cEmissions,
+			cInitial, initialRun);
+
+	maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+			maxDiffTransition, maxDiffEmission);
+
+	return std::max(maxDiffInitial,
+			std::max(maxDiffTransition, maxDiffEmission));
+}
+
+void HMMCompiled::getParameters(std::vector<double>& parameters) const {
+	const HMMTopology& topology = *_topology;
+
+	parameters.assign(_initialDistribution.begin(),
+			_initialDistribution.end());
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantTransitions(i) && topology._transitionTies[i] == i) {
+			parameters.insert(parameters.end(),
+					_transitions.begin() + topology._transitionOffsets[i],
+					_transitions.begin() + topology._transitionOffsets[i + 1]);
+		}
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantEmissions(i) && topology._emissionTies[i] == i) {
+			for (int a = 0; a < topology.getNumberSymbols(); a++) {
+				parameters.push_back(_emissions[a * _numberNodes + i]);
+			}
+		}
+	}
+}
+
+void HMMCompiled::setParameters(const std::vector<double>& parameters) {
+	const HMMTopology& topology = *_topology;
+	std::vector<double>::const_iterator parameter = parameters.begin();
+
+	for (int i = 0; i < _numberNodes; i++) {
+		_initialDistribution[i] = *parameter++;
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantTransitions(i) && topology._transitionTies[i] == i) {
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				_transitions[e] = *parameter++;
+			}
+		}
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantEmissions(i) && topology._emissionTies[i] == i) {
+			for (int a = 0; a < topology.getNumberSymbols(); a++) {
+				_emissions[a * _numberNodes + i] = *parameter++;
+			}
+		}
+	}
+
+	applyTies();
+}
+
+void HMMCompiled::projectParameters() {
+	const HMMTopology& topology = *_topology;
+	// smallest probability an extrapolated parameter may take
+	const double minimum = 1e-10;
+	double sum = 0;
+
+	for (int i = 0; i < _numberNodes; i++) {
+		_initialDistribution[i] = std::max(0.0, _initialDistribution[i]);
+		sum += _initialDistribution[i];
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		_initialDistribution[i] /= sum;
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantTransitions(i)) {
+			sum = 0;
+
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				if (_transitions[e] < 0) {
+					_transitions[e] = minimum;
+				}
+				sum += _transitions[e];
+			}
+
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				_transitions[e] /= sum;
+			}
+		}
+	}
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (!hasConstantEmissions(i)) {
+			sum = 0;
+
+			for (int a = 0; a < topology.getNumberSymbols(); a++) {
+				if (_emissions[a * _numberNodes + i] < 0) {
+					_emissions[a * _numberNodes + i] = minimum;
+				}
+				sum += _emissions[a * _numberNodes + i];
+			}
 
-	delete[] cTransitions;
-	delete[] cEmissions;
-	delete[] cInitial;
+			if (sum > 0) {
+				for (int a = 0; a < topology.getNumberSymbols(); a++) {
+					_emissions[a * _numberNodes + i] /= sum;
+				}
+			}
+		}
+	}
 }
 
-Analytics::AnalyticsResult HMMCompiled::baumWelch(boost::shared_ptr<HMM> hmm,
-		const boost::unordered_map<std::string,
-				boost::unordered_map<std::string, std::string> >& substitution,
-		const boost::unordered_map<std::string,
-				boost::unordered_map<std::string, std::string> >& inverseSubstitution,
+void HMMCompiled::acceleratedBaumWelch(
 		const std::vector<std::vector<std::string> >& trainingset,
-		const std::vector<std::vector<std::string> >& testset,
-		const std::vector<std::vector<std::string> >& annotations,
-		double threshold, bool annotated) {
-
-	boost::unordered_map<int, double>* cTransitions = new boost::unordered_map<
-			int, double>[_numberNodes];
-	boost::unordered_map<std::string, double>* cEmissions =
-			new boost::unordered_map<std::string, double>[_numberNodes];
-	double* cInitial = new double[_numberNodes];
+		double threshold) {
+	SequenceBatch batch(trainingset);
+
+	squaremBaumWelch(SequenceBatch::View(batch), NULL, threshold);
+}
+
+void HMMCompiled::acceleratedBaumWelch(const EncodedSequences& trainingset,
+		double threshold) {
+	squaremBaumWelch(trainingset, NULL, threshold);
+}
+
+void HMMCompiled::acceleratedBaumWelch(
+		const std::vector<std::vector<std::string> >& trainingset,
+		const std::vector<std::vector<std::string> >& labels,
+		double threshold) {
+	SequenceBatch batch(trainingset);
+
+	acceleratedBaumWelch(SequenceBatch::View(batch), labels, threshold);
+}
+
+void HMMCompiled::acceleratedBaumWelch(const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >& labels,
+		double threshold) {
+	if (!hasStateLabels()) {
+		throw std::invalid_argument(
+				"acceleratedBaumWelch: The HMM has no state labels assigned.");
+	}
+
+	if (labels.size() != trainingset.size()) {
+		throw std::invalid_argument(
+				"acceleratedBaumWelch: Every sequence of the training set needs its labels.");
+	}
+
+	std::vector<std::vector<uint8_t> > labelCodes;
+
+	encodeLabels(labels, labelCodes);
+	squaremBaumWelch(trainingset, &labelCodes, threshold);
+}
+
+void HMMCompiled::squaremBaumWelch(const EncodedSequences& trainingset,
+		const std::vector<std::vector<uint8_t> >* labels,
+		double threshold) {
+	std::vector<double> cTransitions, cEmissions, cInitial;
+	double maxDiff, maxDiffTransition, maxDiffEmission, maxDiffInitial;
+	double logLikelihood1, logLikelihood;
+	std::vector<double> p0, p1, p2, r, v;
+	int numberSteps = 0;
 	bool initialRun = true;
-	double prob;
-	double diff;
-	double oldValue = -std::numeric_limits<double>::infinity();
-	double currentValue = 0;
-	Analytics::AnalyticsResult oldAnalytics;
-	Analytics::AnalyticsResult currentAnalytics;
-	boost::shared_ptr<HMMCompiled> oldHMM(new HMMCompiled());
-	boost::shared_ptr<HMMCompiled> chmm(new HMMCompiled);
 
 	if (trainingset.size() == 0) {
 		std::cerr << "Training set is empty." << std::endl;
-		return Analytics::AnalyticsResult();
+		return;
 	}
 
 	do {
-		// keep the best HMM (with respect to the analytics result/accuracy) found so far
-		chmm->copy(oldHMM);
-		oldValue = currentValue;
-		oldAnalytics = currentAnalytics;
+		// p1 = F(p0), the first step also completes the emission sets
+		clearCounts(cTransitions, cEmissions, cInitial);
 
-		for (int i = 0; i < _numberNodes; i++) {
-			cTransitions[i].clear();
-			cEmissions[i].clear();
+		getParameters(p0);
+		internalBaumWelch(trainingset, labels, cTransitions, cEmissions,
+				cInitial, initialRun);
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
+		numberSteps++;
+
+		maxDiff = std::max(maxDiffInitial,
+				std::max(maxDiffTransition, maxDiffEmission));
+
+		if (initialRun) {
+			initialRun = false;
+			continue;
+		}
+
+		if (maxDiff <= threshold) {
+			break;
 		}
 
-		for (int i = 0; i < _numberNodes; i++) {
-			cInitial[i] = 0;
-		}
+		// p2 = F(p1)
+		clearCounts(cTransitions, cEmissions, cInitial);
+
+		getParameters(p1);
+		logLikelihood1 = internalBaumWelch(trainingset, labels, cTransitions,
+				cEmissions, cInitial, false);
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
+		numberSteps++;
+
+		maxDiff = std::max(maxDiffInitial,
+				std::max(maxDiffTransition, maxDiffEmission));
+
+		if (maxDiff <= threshold) {
+			break;
+		}
+
+		getParameters(p2);
+
+		if (p0.size() != p1.size() || p1.size() != p2.size()) {
+			// the emission sets have changed, thus the steps cannot be combined
+			continue;
+		}
+
+		// extrapolation: r = p1-p0, v = p2-p1-r, alpha = -|r|/|v|
+		double normR = 0;
+		double normV = 0;
+		r.resize(p0.size());
+		v.resize(p0.size());
+
+		for (int k = 0; k < p0.size(); k++) {
+			r[k] = p1[k] - p0[k];
+			v[k] = p2[k] - p1[k] - r[k];
+			normR += r[k] * r[k];
+			normV += v[k] * v[k];
+		}
+
+		double alpha = normV > 0 ? -std::sqrt(normR / normV) : -1;
+
+		// alpha = -1 corresponds to p2, thus smaller steps are never taken
+		alpha = std::min(alpha, -1.0);
+
+		while (true) {
+			std::vector<double> extrapolation(p0.size());
+
+			for (int k = 0; k < p0.size(); k++) {
+				extrapolation[k] = p0[k] - 2 * alpha * r[k]
+						+ alpha * alpha * v[k];
+			}
+
+			setParameters(extrapolation);
+			projectParameters();
+
+			clearCounts(cTransitions, cEmissions, cInitial);
 
-		internalBaumWelch(trainingset, cTransitions, cEmissions, cInitial,
-				initialRun);
+			logLikelihood = internalBaumWelch(trainingset, labels,
+					cTransitions, cEmissions, cInitial, false);
 
-		//smoothing of transitions
-		for (int i = 0; i < _numberNodes; i++) {
-			for (boost::unordered_map<int, double>::iterator jt =
-					cTransitions[i].begin(); jt != cTransitions[i].end();
-					++jt) {
-				jt->second += 1;
+			// safeguard: the extrapolation must not be worse than the Baum-Welch steps
+			if (alpha == -1 || logLikelihood >= logLikelihood1) {
+				break;
 			}
-		}
 
-		// smoothing by pseudo counts
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissionSet(i)) {
-				for (boost::unordered_set<std::string>::const_iterator it =
-						_supersetEmissions.begin();
-						it != _supersetEmissions.end(); ++it) {
-					cEmissions[i][*it] += 1;
-				}
-			} else {
-				for (boost::unordered_map<std::string, double>::iterator it =
-						_emissions[i].begin(); it != _emissions[i].end();
-						++it) {
-					cEmissions[i][it->first] += 1;
-				}
+			alpha = (alpha - 1) / 2;
+
+			if (alpha > -1.01) {
+				alpha = -1;
 			}
 		}
 
-		// new emission probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissions(i)) {
-				double sum = 0;
-
-				if (!hasConstantEmissionSet(i)) {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						sum += it->second;
-					}
+		// stabilizing Baum-Welch step from the extrapolated parameters
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
+		numberSteps++;
 
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						prob = it->second / sum;
-						double eProb = getEmission(i, it->first);
-						_emissions[i][it->first] = prob;
-					}
-				} else {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						sum += cEmissions[i].at(it->first);
-					}
+		maxDiff = std::max(maxDiffInitial,
+				std::max(maxDiffTransition, maxDiffEmission));
 
-					for (boost::unordered_map<std::string, double>::iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						prob = cEmissions[i].at(it->first) / sum;
-						double eProb = it->second;
-						it->second = prob;
-					}
+		std::cout << "MaxDiff:" << maxDiff << " Alpha:" << alpha
+				<< " Log-likelihood:" << logLikelihood << " Steps:"
+				<< numberSteps << std::endl;
 
-				}
-			}
-		}
+	} while (maxDiff > threshold);
 
-		// new transition probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantTransitions(i)) {
-				double sum = 0;
+	std::cout << "Number of Baum-Welch steps:" << numberSteps << std::endl;
+}
 
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						cTransitions[i].begin(); jt != cTransitions[i].end();
-						++jt) {
-					sum += jt->second;
-				}
+Analytics::AnalyticsResult HMMCompiled::baumWelch(
+		const boost::unordered_map<std::string, std::string>& symbolMap,
+		const std::vector<std::vector<std::string> >& trainingset,
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		double threshold, bool annotated,
+		const std::vector<std::vector<std::string> >* trainingLabels,
+		ThreadPool* pool, StoppingPolicy* stopping) {
+	SequenceBatch batch(trainingset);
+
+	return baumWelch(symbolMap, SequenceBatch::View(batch), testset,
+			annotations, threshold, annotated, trainingLabels, pool, stopping);
+}
 
-				for (boost::unordered_map<int, double>::iterator jt =
-						_mapTransitions[i].begin();
-						jt != _mapTransitions[i].end(); ++jt) {
-					double prob = 0;
+Analytics::AnalyticsResult HMMCompiled::baumWelch(
+		const boost::unordered_map<std::string, std::string>& symbolMap,
+		const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		double threshold, bool annotated,
+		const std::vector<std::vector<std::string> >* trainingLabels,
+		ThreadPool* pool, StoppingPolicy* stopping) {
 
-					if (sum != 0) {
-						prob = cTransitions[i][jt->first] / sum;
-					}
+	std::vector<double> cTransitions, cEmissions, cInitial;
+	bool initialRun = true;
+	double maxDiffTransition, maxDiffEmission, maxDiffInitial;
+	int iteration;
+	FullEvaluation fullEvaluation;
+	StoppingPolicy& policy = stopping != NULL ? *stopping : fullEvaluation;
+	boost::shared_ptr<HMMCompiled> oldHMM(new HMMCompiled());
+	boost::shared_ptr<HMMCompiled> chmm(new HMMCompiled);
+
+	if (trainingset.size() == 0) {
+		std::cerr << "Training set is empty." << std::endl;
+		return Analytics::AnalyticsResult();
+	}
 
-					jt->second = prob;
-					_imapTransitions[jt->first][i] = prob;
+	if (trainingLabels != NULL && !hasStateLabels()) {
+		throw std::invalid_argument(
+				"baumWelch: The HMM has no state labels assigned.");
+	}
 
-				}
-			}
-		}
+	// the labels are compared as codes in every iteration
+	std::vector<std::vector<uint8_t> > labelCodes;
 
-		// new initial distribution
-		double sum = 0;
-		for (int i = 0; i < _numberNodes; i++) {
-			sum += cInitial[i];
-		}
+	if (trainingLabels != NULL) {
+		encodeLabels(*trainingLabels, labelCodes);
+	}
 
-		for (int i = 0; i < _numberNodes; i++) {
-			prob = cInitial[i] / sum;
-			_initialDistribution[i] = prob;
-		}
+	policy.start(testset, annotations, pool);
+
+	for (iteration = 0;; iteration++) {
+		// keep the best HMM (with respect to the analytics result/accuracy) found so far
+		chmm->copy(oldHMM);
+
+		clearCounts(cTransitions, cEmissions, cInitial);
+
+		internalBaumWelch(trainingset,
+				trainingLabels != NULL ? &labelCodes : NULL, cTransitions,
+				cEmissions, cInitial, initialRun);
+
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
 
 		initialRun = false;
 
 		// it the training set is annotated, then the HMMCompiled has to be translated
 		// to use the non-annotated emission symbols again for the analysis.
 		if (annotated) {
-			hmm->update(shared_from_this());
-			hmm->substituteEmissions(inverseSubstitution);
-			hmm->compile(chmm);
-			hmm->substituteEmissions(substitution);
+			projectEmissions(symbolMap, chmm);
 		} else {
 			copy(chmm);
 		}
 
-		currentAnalytics = Analytics::analyse(chmm, testset, annotations);
-		currentValue = Analytics::evaluate(currentAnalytics);
-
-		diff = currentValue - oldValue;
-
-	} while (diff > threshold);
-
-	delete[] cTransitions;
-	delete[] cEmissions;
-	delete[] cInitial;
+		if (!policy.proceed(oldHMM, chmm, iteration, threshold)) {
+			break;
+		}
+	}
 
 	oldHMM->copy(shared_from_this());
 
-	return oldAnalytics;
+	// oldHMM is the model of the preceding iteration
+	return policy.analyse(oldHMM, iteration - 1);
 }
 
 Analytics::AnalyticsResult HMMCompiled::baumWelchIterated(
-		boost::shared_ptr<HMM> hmm,
-		const boost::unordered_map<std::string,
-				boost::unordered_map<std::string, std::string> >& substitution,
-		const boost::unordered_map<std::string,
-				boost::unordered_map<std::string, std::string> >& inverseSubstitution,
+		const boost::unordered_map<std::string, std::string>& symbolMap,
 		const std::vector<std::vector<std::string> >& trainingset,
 		const std::vector<std::vector<std::string> >& testset,
-		const std::vector<std::vector<std::string> >& annotations,
-		int numIterations, bool annotated) {
-
-	boost::unordered_map<int, double>* cTransitions = new boost::unordered_map<
-			int, double>[_numberNodes];
-	boost::unordered_map<std::string, double>* cEmissions =
-			new boost::unordered_map<std::string, double>[_numberNodes];
-	double* cInitial = new double[_numberNodes];
+		const std::vector<std::vector<uint8_t> >& annotations,
+		int numIterations, bool annotated,
+		const std::vector<std::vector<std::string> >* trainingLabels,
+		ThreadPool* pool) {
+	SequenceBatch batch(trainingset);
+
+	return baumWelchIterated(symbolMap, SequenceBatch::View(batch), testset,
+			annotations, numIterations, annotated, trainingLabels, pool);
+}
+
+Analytics::AnalyticsResult HMMCompiled::baumWelchIterated(
+		const boost::unordered_map<std::string, std::string>& symbolMap,
+		const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		int numIterations, bool annotated,
+		const std::vector<std::vector<std::string> >* trainingLabels,
+		ThreadPool* pool) {
+
+	std::vector<double> cTransitions, cEmissions, cInitial;
 	bool initialRun = true;
-	double prob;
+	double maxDiffTransition, maxDiffEmission, maxDiffInitial;
 	double diff;
 	double oldValue = -std::numeric_limits<double>::infinity();
 	double currentValue = 0;
@@ -1197,134 +2113,39 @@ Analytics::AnalyticsResult HMMCompiled::baumWelchIterated(
 		return Analytics::AnalyticsResult();
 	}
 
-	for (int k = 0; k < numIterations; k++) {
-
-		for (int i = 0; i < _numberNodes; i++) {
-			cTransitions[i].clear();
-			cEmissions[i].clear();
-		}
-
-		for (int i = 0; i < _numberNodes; i++) {
-			cInitial[i] = 0;
-		}
-
-		internalBaumWelch(trainingset, cTransitions, cEmissions, cInitial,
-				initialRun);
-
-		//smoothing of transitions
-		for (int i = 0; i < _numberNodes; i++) {
-			for (boost::unordered_map<int, double>::iterator jt =
-					cTransitions[i].begin(); jt != cTransitions[i].end();
-					++jt) {
-				jt->second += 1;
-			}
-		}
-
-		// smoothing by pseudo counts
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissionSet(i)) {
-				for (boost::unordered_set<std::string>::const_iterator it =
-						_supersetEmissions.begin();
-						it != _supersetEmissions.end(); ++it) {
-					cEmissions[i][*it] += 1;
-				}
-			} else {
-				for (boost::unordered_map<std::string, double>::iterator it =
-						_emissions[i].begin(); it != _emissions[i].end();
-						++it) {
-					cEmissions[i][it->first] += 1;
-				}
-			}
-		}
-
-		// new emission probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantEmissions(i)) {
-				double sum = 0;
-
-				if (!hasConstantEmissionSet(i)) {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						sum += it->second;
-					}
-
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							cEmissions[i].begin(); it != cEmissions[i].end();
-							++it) {
-						prob = it->second / sum;
-						double eProb = getEmission(i, it->first);
-						_emissions[i][it->first] = prob;
-					}
-				} else {
-					for (boost::unordered_map<std::string, double>::const_iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						sum += cEmissions[i].at(it->first);
-					}
-
-					for (boost::unordered_map<std::string, double>::iterator it =
-							_emissions[i].begin(); it != _emissions[i].end();
-							++it) {
-						prob = cEmissions[i].at(it->first) / sum;
-						double eProb = it->second;
-						it->second = prob;
-					}
-
-				}
-			}
-		}
-
-		// new transition probabilities
-		for (int i = 0; i < _numberNodes; i++) {
-			if (!hasConstantTransitions(i)) {
-				double sum = 0;
-
-				for (boost::unordered_map<int, double>::const_iterator jt =
-						cTransitions[i].begin(); jt != cTransitions[i].end();
-						++jt) {
-					sum += jt->second;
-				}
+	if (trainingLabels != NULL && !hasStateLabels()) {
+		throw std::invalid_argument(
+				"baumWelch: The HMM has no state labels assigned.");
+	}
 
-				for (boost::unordered_map<int, double>::iterator jt =
-						_mapTransitions[i].begin();
-						jt != _mapTransitions[i].end(); ++jt) {
-					double prob = 0;
+	// the labels are compared as codes in every iteration
+	std::vector<std::vector<uint8_t> > labelCodes;
 
-					if (sum != 0) {
-						prob = cTransitions[i][jt->first] / sum;
-					}
+	if (trainingLabels != NULL) {
+		encodeLabels(*trainingLabels, labelCodes);
+	}
 
-					jt->second = prob;
-					_imapTransitions[jt->first][i] = prob;
+	for (int k = 0; k < numIterations; k++) {
 
-				}
-			}
-		}
+		clearCounts(cTransitions, cEmissions, cInitial);
 
-		// new initial distribution
-		double sum = 0;
-		for (int i = 0; i < _numberNodes; i++) {
-			sum += cInitial[i];
-		}
+		internalBaumWelch(trainingset,
+				trainingLabels != NULL ? &labelCodes : NULL, cTransitions,
+				cEmissions, cInitial, initialRun);
 
-		for (int i = 0; i < _numberNodes; i++) {
-			prob = cInitial[i] / sum;
-			_initialDistribution[i] = prob;
-		}
+		maximizationStep(cTransitions, cEmissions, cInitial, maxDiffInitial,
+				maxDiffTransition, maxDiffEmission);
 
 		initialRun = false;
 
 		if (annotated) {
-			hmm->update(shared_from_this());
-			hmm->substituteEmissions(inverseSubstitution);
-			hmm->compile(chmm);
-			hmm->substituteEmissions(substitution);
+			projectEmissions(symbolMap, chmm);
 		} else {
 			copy(chmm);
 		}
 
-		currentAnalytics = Analytics::analyse(chmm, testset, annotations);
+		currentAnalytics = Analytics::analyse(chmm, testset, annotations,
+				pool);
 		currentValue = Analytics::evaluate(currentAnalytics);
 
 		if (currentValue > oldValue) {
@@ -1338,16 +2159,91 @@ Analytics::AnalyticsResult HMMCompiled::baumWelchIterated(
 		std::cout << currentAnalytics << std::endl;
 	}
 
-	delete[] cTransitions;
-	delete[] cEmissions;
-	delete[] cInitial;
-
 	oldHMM->copy(shared_from_this());
 
 	return oldAnalytics;
 }
 
-void HMMCompiled::initProbabilities() {
+void HMMCompiled::onlineBaumWelch(boost::shared_ptr<HMM> hmm,
+		SequenceSource& source, int batchSize, int epochs, double stepExponent,
+		int checkpointInterval, const std::string& checkpointFilename) {
+	// sufficient statistics interpolated over all mini-batches
+	std::vector<double> sTransitions, sEmissions, sInitial;
+	// expected counts of the current mini-batch
+	std::vector<double> cTransitions, cEmissions, cInitial;
+	double maxDiffTransition, maxDiffEmission, maxDiffInitial;
+	std::vector<std::vector<std::string> > batch;
+	int k = 0;
+
+	if (stepExponent <= 0.5 || stepExponent > 1) {
+		throw std::invalid_argument(
+				"onlineBaumWelch: The step exponent has to be in (0.5,1].");
+	}
+
+	clearCounts(sTransitions, sEmissions, sInitial);
+
+	for (int epoch = 0; epoch < epochs; epoch++) {
+		source.reset();
+
+		while (source.nextBatch(batchSize, batch) > 0) {
+			// the first mini-batch replaces the initial statistics completely
+			double eta = std::pow(k + 1.0, -stepExponent);
+
+			SequenceBatch encoded(batch);
+
+			clearCounts(cTransitions, cEmissions, cInitial);
+
+			internalBaumWelch(SequenceBatch::View(encoded), NULL, cTransitions,
+					cEmissions, cInitial, epoch == 0);
+
+			// the alphabet may have been extended by the mini-batch
+			sEmissions.resize(cEmissions.size(), 0);
+
+			// s = (1-eta)*s + eta*c
+			for (int e = 0; e < sTransitions.size(); e++) {
+				sTransitions[e] = (1 - eta) * sTransitions[e]
+						+ eta * cTransitions[e];
+			}
+
+			for (int a = 0; a < sEmissions.size(); a++) {
+				sEmissions[a] = (1 - eta) * sEmissions[a] + eta * cEmissions[a];
+			}
+
+			for (int i = 0; i < _numberNodes; i++) {
+				sInitial[i] = (1 - eta) * sInitial[i] + eta * cInitial[i];
+			}
+
+			// the maximization step smoothes the counts, thus it gets a copy of them
+			cTransitions = sTransitions;
+			cEmissions = sEmissions;
+			cInitial = sInitial;
+
+			maximizationStep(cTransitions, cEmissions, cInitial,
+					maxDiffInitial, maxDiffTransition, maxDiffEmission);
+
+			k++;
+
+			std::cout << "Batch:" << k << " Epoch:" << epoch << " Step size:"
+					<< eta << " MaxDiff:"
+					<< std::max(maxDiffInitial,
+							std::max(maxDiffTransition, maxDiffEmission))
+					<< std::endl;
+
+			if (checkpointInterval > 0 && k % checkpointInterval == 0) {
+				std::ofstream os;
+
+				hmm->update(shared_from_this());
+
+				os.open(checkpointFilename.c_str(), std::ios_base::out);
+				hmm->serialize(os);
+				os.close();
+			}
+		}
+	}
+}
+
+void HMMCompiled::initProbabilities(RandomGenerator& random) {
+	const HMMTopology& topology = *_topology;
 	//initial probabilities
 	double constant = 0;
 	double sum = 0;
@@ -1356,7 +2252,7 @@ void HMMCompiled::initProbabilities() {
 			constant += _initialDistribution[i];
 		} else {
 			do {
-				_initialDistribution[i] = -_random();
+				_initialDistribution[i] = -random();
 			} while (_initialDistribution[i] == 0);
 			sum += _initialDistribution[i];
 		}
@@ -1373,26 +2269,22 @@ void HMMCompiled::initProbabilities() {
 		sum = 0;
 		constant = 0;
 
-		for (boost::unordered_map<int, double>::iterator jt =
-				_mapTransitions[i].begin(); jt != _mapTransitions[i].end();
-				++jt) {
-			if (jt->second >= 0) {
-				constant += jt->second;
+		for (int e = topology._transitionOffsets[i];
+				e < topology._transitionOffsets[i + 1]; e++) {
+			if (_transitions[e] >= 0) {
+				constant += _transitions[e];
 			} else {
 				do {
-					jt->second = -_random();
-				} while (jt->second == 0);
-				sum += jt->second;
+					_transitions[e] = -random();
+				} while (_transitions[e] == 0);
+				sum += _transitions[e];
 			}
 		}
 
-		for (boost::unordered_map<int, double>::iterator jt =
-				_mapTransitions[i].begin(); jt != _mapTransitions[i].end();
-				++jt) {
-			if (jt->second < 0) {
-				jt->second *= (1 - constant) / sum;
-
-				_imapTransitions[jt->first][i] = jt->second;
+		for (int e = topology._transitionOffsets[i];
+				e < topology._transitionOffsets[i + 1]; e++) {
+			if (_transitions[e] < 0) {
+				_transitions[e] *= (1 - constant) / sum;
 			}
 		}
 
@@ -1403,55 +2295,68 @@ void HMMCompiled::initProbabilities() {
 		sum = 0;
 		constant = 0;
 
-		for (boost::unordered_map<std::string, double>::iterator it =
-				_emissions[i].begin(); it != _emissions[i].end(); ++it) {
-			if (it->second >= 0) {
-				constant += it->second;
+		for (int a = 0; a < topology.getNumberSymbols(); a++) {
+			double& emission = _emissions[a * _numberNodes + i];
+
+			if (emission >= 0) {
+				constant += emission;
 			} else {
 				do {
-					it->second = -_random();
-				} while (it->second == 0);
+					emission = -random();
+				} while (emission == 0);
 
-				sum += it->second;
+				sum += emission;
 			}
 		}
 
-		for (boost::unordered_map<std::string, double>::iterator it =
-				_emissions[i].begin(); it != _emissions[i].end(); ++it) {
-			if (it->second < 0) {
-				it->second *= (1 - constant) / sum;
+		for (int a = 0; a < topology.getNumberSymbols(); a++) {
+			if (_emissions[a * _numberNodes + i] < 0) {
+				_emissions[a * _numberNodes + i] *= (1 - constant) / sum;
 			}
 		}
 	}
+
+	// tied nodes start with the same probabilities
+	applyTies();
 }
 
 void HMMCompiled::simulate(int length, std::vector<std::string>& sequence,
-		std::vector<int>& states) {
-	int state = getState(_initialDistribution);
+		std::vector<int>& states, RandomGenerator& random) const {
+	const HMMTopology& topology = *_topology;
+	int state = getState(&_initialDistribution[0], random);
 	int counter = 0;
 	states.push_back(state);
 
 	if (!isSilent(state)) {
-		std::string emission = getRandomEmission(_emissions[state]);
-		sequence.push_back(emission);
+		sequence.push_back(getRandomEmission(state, random));
 		counter++;
 	}
 
 	while (counter < length) {
-		state = getState(_mapTransitions[state]);
+		double rvalue = random();
+		double sum = 0;
+		int e = topology._transitionOffsets[state];
+
+		while (e < topology._transitionOffsets[state + 1] - 1
+				&& sum + _transitions[e] < rvalue) {
+			sum += _transitions[e];
+			e++;
+		}
+
+		state = topology._transitionTargets[e];
 
 		states.push_back(state);
 		if (!isSilent(state)) {
-			std::string emission = getRandomEmission(_emissions[state]);
-			sequence.push_back(emission);
+			sequence.push_back(getRandomEmission(state, random));
 			counter++;
 		}
 	}
 }
 
 int HMMCompiled::getState(
-		const boost::unordered_map<int, double>& distribution) {
-	double rvalue = _random();
+		const boost::unordered_map<int, double>& distribution,
+		RandomGenerator& random) const {
+	double rvalue = random();
 	double sum = 0;
 	int result = 0;
 
@@ -1465,8 +2370,9 @@ int HMMCompiled::getState(
 	return it->first;
 }
 
-int HMMCompiled::getState(double* distribution) {
-	double rvalue = _random();
+int HMMCompiled::getState(const double* distribution,
+		RandomGenerator& random) const {
+	double rvalue = random();
 	double sum = 0;
 	int result = 0;
 
@@ -1479,8 +2385,9 @@ int HMMCompiled::getState(double* distribution) {
 }
 
 std::string HMMCompiled::getRandomEmission(
-		boost::unordered_map<std::string, double>& emissions) {
-	double rvalue = _random();
+		const boost::unordered_map<std::string, double>& emissions,
+		RandomGenerator& random) const {
+	double rvalue = random();
 	double sum = 0;
 
 	boost::unordered_map<std::string, double>::const_iterator it =
@@ -1494,62 +2401,358 @@ std::string HMMCompiled::getRandomEmission(
 	return it->first;
 }
 
-void HMMCompiled::copy(boost::shared_ptr<HMMCompiled> dst) {
-	dst->clear();
+const std::string& HMMCompiled::getRandomEmission(int node,
+		RandomGenerator& random) const {
+	double rvalue = random();
+	double sum = 0;
+	int a = 0;
+
+	// symbols which the node does not emit have the probability 0 and are skipped
+	while (a < _topology->getNumberSymbols() - 1
+			&& (_emissions[a * _numberNodes + node] == 0
+					|| sum + _emissions[a * _numberNodes + node] < rvalue)) {
+		sum += _emissions[a * _numberNodes + node];
+		a++;
+	}
+
+	return _topology->getSymbol(a);
+}
+
+void HMMCompiled::copy(boost::shared_ptr<HMMCompiled> dst) const {
+	if (dst.get() == this) {
+		return;
+	}
+
 	dst->_numberNodes = _numberNodes;
+	dst->_topology = _topology;
+	dst->_transitions = _transitions;
+	dst->_emissions = _emissions;
+	dst->_initialDistribution = _initialDistribution;
+	dst->_compiledTransitions.clear();
+	dst->_compiledEmissions.clear();
+}
+
+void HMMCompiled::projectEmissions(
+		const boost::unordered_map<std::string, std::string>& symbolMap,
+		boost::shared_ptr<HMMCompiled> dst) const {
+	boost::shared_ptr<HMMTopology> topology = dst->_topology;
+	// projected[a] = id of the projection of the symbol a
+	std::vector<int> projected(_topology->getNumberSymbols());
+	std::vector<double> emissions;
+
+	// the topology of the last projection of this model is reused
+	if (topology->_projectedFrom == _topology
+			&& topology->_projectionMap == symbolMap) {
+		for (int a = 0; a < _topology->getNumberSymbols(); a++) {
+			boost::unordered_map<std::string, std::string>::const_iterator symbol =
+					symbolMap.find(_topology->getSymbol(a));
+
+			projected[a] = topology->getSymbolId(
+					symbol != symbolMap.end() ?
+							symbol->second : _topology->getSymbol(a));
+		}
+	} else {
+		topology.reset(new HMMTopology(*_topology));
+		topology->_symbols.clear();
+		topology->_symbolIds.clear();
+		topology->_emissionOffsets.assign(1, 0);
+		topology->_emissionSymbols.clear();
+		topology->_projectedFrom = _topology;
+		topology->_projectionMap = symbolMap;
+
+		for (int a = 0; a < _topology->getNumberSymbols(); a++) {
+			boost::unordered_map<std::string, std::string>::const_iterator symbol =
+					symbolMap.find(_topology->getSymbol(a));
+
+			projected[a] = topology->addSymbol(
+					symbol != symbolMap.end() ?
+							symbol->second : _topology->getSymbol(a));
+		}
+
+		// the emission sets consist of the projected symbols
+		for (int i = 0; i < _numberNodes; i++) {
+			int begin = topology->_emissionSymbols.size();
+
+			for (int k = _topology->_emissionOffsets[i];
+					k < _topology->_emissionOffsets[i + 1]; k++) {
+				int a = projected[_topology->_emissionSymbols[k]];
+
+				if (std::find(topology->_emissionSymbols.begin() + begin,
+						topology->_emissionSymbols.end(), a)
+						== topology->_emissionSymbols.end()) {
+					topology->_emissionSymbols.push_back(a);
+				}
+			}
+
+			topology->_emissionOffsets.push_back(
+					topology->_emissionSymbols.size());
+		}
+	}
+
+	emissions.assign(topology->getNumberSymbols() * _numberNodes, 0);
+
+	for (int a = 0; a < _topology->getNumberSymbols(); a++) {
+		for (int i = 0; i < _numberNodes; i++) {
+			emissions[projected[a] * _numberNodes + i] += _emissions[a
+					* _numberNodes + i];
+		}
+	}
+
+	// dst may be this, thus the projection is computed before copying
+	copy(dst);
+
+	dst->_topology = topology;
+	dst->_emissions.swap(emissions);
+}
+
+void HMMCompiled::minimize(boost::shared_ptr<HMMCompiled> dst,
+		double precision) const {
+	const HMMTopology& topology = *_topology;
+	int numberSymbols = topology.getNumberSymbols();
+	// classes[i] = class of the node i
+	std::vector<int> classes(_numberNodes);
+	int numberClasses = 0;
+	int previousClasses = -1;
+
+	if (dst.get() == this) {
+		throw std::invalid_argument("minimize: dst must not be this HMM.");
+	}
+
+	if (isRandom()) {
+		throw std::invalid_argument(
+				"minimize: The HMM contains random probabilities.");
+	}
+
+	// initial partition: nodes with the same emissions, label and flags. Every silent
+	// node is a class of its own, since merged silent nodes could form a self transition.
+	{
+		std::map<std::vector<double>, int> keys;
+
+		for (int i = 0; i < _numberNodes; i++) {
+			std::vector<double> key;
+			std::vector<char> emissionSet(numberSymbols, false);
+
+			for (int k = topology._emissionOffsets[i];
+					k < topology._emissionOffsets[i + 1]; k++) {
+				emissionSet[topology._emissionSymbols[k]] = true;
+			}
+
+			key.push_back(isSilent(i) ? -(i + 1) : 0);
+			key.push_back(
+					topology._stateLabels.empty() ?
+							HMMTopology::NO_LABEL : topology._stateLabels[i]);
+			key.push_back(topology._constantTransitions[i]);
+			key.push_back(topology._constantEmissions[i]);
+			key.push_back(topology._constantEmissionSet[i]);
+
+			for (int a = 0; a < numberSymbols; a++) {
+				key.push_back(emissionSet[a]);
+				key.push_back(
+						std::floor(
+								_emissions[a * _numberNodes + i] / precision
+										+ 0.5));
+			}
 
-	dst->_mapTransitions = new boost::unordered_map<int, double>[_numberNodes];
+			classes[i] = keys.insert(std::make_pair(key, keys.size())).first->second;
+		}
+
+		numberClasses = keys.size();
+	}
+
+	// refine the classes by the probabilities to move into every class until they are
+	// stable
+	while (numberClasses != previousClasses) {
+		std::map<std::vector<double>, int> keys;
+		std::vector<int> refined(_numberNodes);
+
+		for (int i = 0; i < _numberNodes; i++) {
+			std::map<int, double> sums;
+			std::vector<double> key(1, classes[i]);
+
+			for (int e = topology._transitionOffsets[i];
+					e < topology._transitionOffsets[i + 1]; e++) {
+				sums[classes[topology._transitionTargets[e]]] += _transitions[e];
+			}
+
+			for (std::map<int, double>::const_iterator it = sums.begin();
+					it != sums.end(); ++it) {
+				key.push_back(it->first);
+				key.push_back(std::floor(it->second / precision + 0.5));
+			}
+
+			refined[i] = keys.insert(std::make_pair(key, keys.size())).first->second;
+		}
+
+		previousClasses = numberClasses;
+		numberClasses = keys.size();
+		classes.swap(refined);
+	}
+
+	// the classes are numbered in the order of their smallest node, thus the order of the
+	// nodes (see HMM::compile) is kept
+	std::vector<int> representatives;
+	std::vector<int> renumbering(numberClasses, -1);
+
+	for (int i = 0; i < _numberNodes; i++) {
+		if (renumbering[classes[i]] < 0) {
+			renumbering[classes[i]] = representatives.size();
+			representatives.push_back(i);
+		}
+
+		classes[i] = renumbering[classes[i]];
+	}
+
+	dst->initialize(numberClasses);
+
+	for (int c = 0; c < numberClasses; c++) {
+		dst->addMapping(topology._nodes[representatives[c]]);
+
+		if (isSilent(representatives[c])) {
+			dst->addSilentNode(topology._nodes[representatives[c]]);
+		}
+	}
+
+	for (int c = 0; c < numberClasses; c++) {
+		int node = representatives[c];
+
+		// the transitions of a class are those of its representative lumped by class
+		for (int e = topology._transitionOffsets[node];
+				e < topology._transitionOffsets[node + 1]; e++) {
+			dst->_compiledTransitions[c][classes[topology._transitionTargets[e]]] +=
+					_transitions[e];
+		}
+
+		for (int k = topology._emissionOffsets[node];
+				k < topology._emissionOffsets[node + 1]; k++) {
+			int a = topology._emissionSymbols[k];
+
+			dst->_compiledEmissions[c][topology.getSymbol(a)] = _emissions[a
+					* _numberNodes + node];
+		}
+
+		// symbols which were added by the learning
+		for (int a = 0; a < numberSymbols; a++) {
+			if (_emissions[a * _numberNodes + node] > 0) {
+				dst->_compiledEmissions[c].insert(
+						std::make_pair(topology.getSymbol(a),
+								_emissions[a * _numberNodes + node]));
+			}
+		}
+	}
 
 	for (int i = 0; i < _numberNodes; i++) {
-		dst->_mapTransitions[i] = _mapTransitions[i];
+		dst->_initialDistribution[classes[i]] += _initialDistribution[i];
 	}
 
-	dst->_imapTransitions = new boost::unordered_map<int, double>[_numberNodes];
+	// the minimized model is not learned, thus its nodes are not tied
+	dst->buildTopology();
+
+	HMMTopology& minimized = dst->mutableTopology();
+
+	minimized._mergedOffsets.assign(numberClasses + 1, 0);
+	minimized._mergedNodes.resize(_numberNodes);
 
 	for (int i = 0; i < _numberNodes; i++) {
-		dst->_imapTransitions[i] = _imapTransitions[i];
+		minimized._mergedOffsets[classes[i] + 1]++;
+		minimized._node2Int[topology._nodes[i]] = classes[i];
+	}
+
+	for (int c = 0; c < numberClasses; c++) {
+		minimized._mergedOffsets[c + 1] += minimized._mergedOffsets[c];
 	}
 
-	dst->_emissions =
-			new boost::unordered_map<std::string, double>[_numberNodes];
+	std::vector<int> position(minimized._mergedOffsets.begin(),
+			minimized._mergedOffsets.end() - 1);
+
 	for (int i = 0; i < _numberNodes; i++) {
-		dst->_emissions[i] = _emissions[i];
+		minimized._mergedNodes[position[classes[i]]++] = topology._nodes[i];
+	}
+
+	// the merged nodes have the same label
+	if (!topology._stateLabels.empty()) {
+		minimized._labelNames = topology._labelNames;
+		minimized._stateLabels.resize(numberClasses);
+
+		for (int c = 0; c < numberClasses; c++) {
+			minimized._stateLabels[c] = topology._stateLabels[representatives[c]];
+		}
+
+		dst->buildLabelStates();
+	}
+}
+
+void HMMCompiled::getMergedNodes(int index,
+		std::vector<boost::shared_ptr<HMMNode> >& nodes) const {
+	const HMMTopology& topology = *_topology;
+
+	nodes.clear();
+
+	if (topology._mergedOffsets.empty()) {
+		nodes.push_back(topology._nodes[index]);
+	} else {
+		nodes.assign(
+				topology._mergedNodes.begin() + topology._mergedOffsets[index],
+				topology._mergedNodes.begin()
+						+ topology._mergedOffsets[index + 1]);
 	}
+}
+
+void HMMCompiled::viterbiLabels(const std::vector<std::string>& sequence,
+		std::vector<uint8_t>& labels, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
+
+	encode(sequence, symbols);
+	viterbiLabels(symbols, sequence.size(), labels, workspace);
+}
+
+void HMMCompiled::viterbiLabels(const PackedSequence& sequence,
+		std::vector<uint8_t>& labels, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
 
-	dst->_supersetEmissions = _supersetEmissions;
-	dst->_silentStateOrder = _silentStateOrder;
-	dst->_silentStates = _silentStates;
+	encode(sequence, symbols);
+	viterbiLabels(symbols, sequence.size(), labels, workspace);
+}
+
+void HMMCompiled::viterbiLabels(const SequenceBatch::Span& sequence,
+		std::vector<uint8_t>& labels, DPWorkspace& workspace) const {
+	workspace.reset();
+	int* symbols = workspace.getInts(sequence.size());
 
-	dst->_initialDistribution = new double[_numberNodes];
-	std::memcpy(dst->_initialDistribution, _initialDistribution,
-			sizeof(double) * _numberNodes);
+	encode(sequence, symbols);
+	viterbiLabels(symbols, sequence.size(), labels, workspace);
+}
 
-	dst->_constantTransitionNodes = new bool[_numberNodes];
-	std::memcpy(dst->_constantTransitionNodes, _constantTransitionNodes,
-			sizeof(bool) * _numberNodes);
+void HMMCompiled::viterbiLabels(const int* symbols, int length,
+		std::vector<uint8_t>& labels, DPWorkspace& workspace) const {
+	const std::vector<uint8_t>& stateLabels = _topology->_stateLabels;
+	const int* backtrack;
 
-	dst->_constantEmissionNodes = new bool[_numberNodes];
-	std::memcpy(dst->_constantEmissionNodes, _constantEmissionNodes,
-			sizeof(bool) * _numberNodes);
+	if (!hasStateLabels()) {
+		throw std::invalid_argument("viterbiLabels: The HMM has no state labels.");
+	}
 
-	dst->_constantEmissionSetNodes = new bool[_numberNodes];
-	std::memcpy(dst->_constantEmissionSetNodes, _constantEmissionSetNodes,
-			sizeof(bool) * _numberNodes);
+	int maxPred = viterbiMatrix(symbols, length, workspace, backtrack);
 
-	dst->_int2Node = _int2Node;
-	dst->_node2Int = _node2Int;
+	labels.clear();
+	labels.push_back(stateLabels[maxPred]);
 
-	dst->_counter = _counter;
+	// backtrack the labels like viterbi
+	for (int i = length - 2; i >= 0; i--) {
+		do {
+			maxPred = backtrack[i * _numberNodes + maxPred];
+			labels.push_back(stateLabels[maxPred]);
+		} while (isSilent(maxPred));
+	}
 
-	dst->_random.base().seed(
-			(unsigned int) (_random() * std::numeric_limits<unsigned int>::max())
-					+ time(NULL));
+	std::reverse(labels.begin(), labels.end());
 }
 
 void HMMCompiled::ID2Name(const std::vector<int>& ids,
 		std::vector<std::string>& names) const {
 	for (std::vector<int>::const_iterator it = ids.begin(); it != ids.end();
 			++it) {
-		names.push_back(_int2Node.at(*it)->getName());
+		names.push_back(_topology->_nodes[*it]->getName());
 	}
 }
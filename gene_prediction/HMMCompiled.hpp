@@ -16,18 +16,29 @@
 
 #include <vector>
 #include <list>
+#include <map>
+#include <cmath>
+#include <limits>
 
 #include "Analytics.hpp"
+#include "HMMTopology.hpp"
+#include "SequenceBatch.hpp"
 
 class HMMNode;
 class HMM;
+class SequenceSource;
+class DPWorkspace;
+class ThreadPool;
+class StoppingPolicy;
+class PackedSequence;
 
 /**
  * This class represents a HMM in its computability friendly form. For that purpose
- * The transitions and emissions of every node are organized in a vector of unordered_maps.
- * Since the VEIL model is sparse that is to say it contains relatively few transitions
- * per node, it is worth not to store the transitions in a quadratic matrix, but to store
- * only those entries which are different from 0. The same holds for the emissions. The
+ * the structure of the model is compiled into an HMMTopology and the probabilities are
+ * stored in flat arrays indexed by the topology. Since the VEIL model is sparse that is to
+ * say it contains relatively few transitions per node, it is worth not to store the
+ * transitions in a quadratic matrix, but to store only those entries which are different
+ * from 0. The emissions are stored for every symbol of the small emission alphabet. The
  * HMM algorithms which are supported are: forward, backward, viterbi, Baum-Welch. All
  * algorithms are computed in the log-space to make long sequences how they appear in
  * DNA-predictions can be handled.
@@ -35,35 +46,107 @@ class HMM;
 class HMMCompiled: public boost::enable_shared_from_this<HMMCompiled> {
 private:
 	int _numberNodes;
-	// _mapTransitions[i][j] = transition probability from i to j
-	boost::unordered_map<int, double>* _mapTransitions;
-	// inverse mapping: _imapTransitions[i][j] = transition probability from j to i
-	boost::unordered_map<int, double>* _imapTransitions;
-	// _constantTransitionNodes[i] = node with index i has constant transitions
-	bool* _constantTransitionNodes;
-	// same for emissions
-	bool* _constantEmissionNodes;
-	// same for emission sets
-	bool* _constantEmissionSetNodes;
-	// _emissions[i][a] = probability that node i emits a symbol a
-	boost::unordered_map<std::string, double>* _emissions;
-	// set of all possible emissions
-	boost::unordered_set<std::string> _supersetEmissions;
-	// set of silent states (states which does not emit anything)
-	boost::unordered_set<int> _silentStates;
-	// order in which the silent states has to be traversed for computing
-	// the transitions probabilities
-	std::vector<int> _silentStateOrder;
-	double* _initialDistribution;
-
-	// mapping between the internal used ids and the nodes
-	boost::unordered_map<int, boost::shared_ptr<HMMNode> > _int2Node;
-	// inverse mapping
-	boost::unordered_map<boost::shared_ptr<HMMNode>, int> _node2Int;
-
-	int _counter;
-
-	boost::random::uniform_01<boost::random::mt19937> _random;
+	// structure of the model which is shared by all copies (see HMMTopology)
+	boost::shared_ptr<HMMTopology> _topology;
+	// _transitions[e] = probability of the transition e of the topology
+	std::vector<double> _transitions;
+	// _emissions[a * _numberNodes + i] = probability that node i emits the symbol with id a.
+	// Symbols which a node does not emit have the probability 0.
+	std::vector<double> _emissions;
+	std::vector<double> _initialDistribution;
+
+	// transitions and emissions which are added during the compilation. They are moved into
+	// the topology and the parameter arrays by finishCompilation.
+	std::vector<std::map<int, double> > _compiledTransitions;
+	std::vector<std::map<std::string, double> > _compiledEmissions;
+
+	// scratch memory of the forward and backward matrices of the training, it is reused
+	// across the sequences and iterations
+	boost::shared_ptr<DPWorkspace> _trainingWorkspace;
+
+	/**
+	 * Returns the topology for a modification. If it is shared with another model, then it
+	 * is copied first.
+	 */
+	HMMTopology& mutableTopology();
+
+	/**
+	 * Adds the symbols of the sequences which are not yet contained in the emission alphabet.
+	 * The emissions of the new symbols have the probability 0.
+	 */
+	void extendAlphabet(const EncodedSequences& sequences);
+
+	/**
+	 * Stores in table[c] the symbol id of the symbol alphabet[c]. Unknown symbols get the
+	 * id -1.
+	 */
+	void symbolTable(const std::vector<std::string>& alphabet,
+			std::vector<int>& table) const;
+
+	/**
+	 * Stores the symbol ids of sequence in symbols. Unknown symbols get the id -1.
+	 */
+	void encode(const std::vector<std::string>& sequence, int* symbols) const;
+
+	/**
+	 * Stores the symbol ids of the bases of sequence in symbols. The bases are translated
+	 * by a table of 4 entries, thus no strings are created.
+	 */
+	void encode(const PackedSequence& sequence, int* symbols) const;
+
+	/**
+	 * Stores the symbol ids of the symbol codes of sequence in symbols. The codes are
+	 * translated by a table of the alphabet of its batch.
+	 */
+	void encode(const SequenceBatch::Span& sequence, int* symbols) const;
+
+	/**
+	 * The following functions are the kernels of the public forward, viterbi and
+	 * viterbiLabels functions. They work on the symbol ids of a sequence of length length
+	 * (see encode), which have to be allocated in workspace after its last reset.
+	 */
+	double forward(const int* symbols, int length, DPWorkspace& workspace) const;
+	void viterbi(const int* symbols, int length, std::vector<int>& stateSequence,
+			DPWorkspace& workspace) const;
+	void viterbiLabels(const int* symbols, int length,
+			std::vector<uint8_t>& labels, DPWorkspace& workspace) const;
+
+	/**
+	 * Computes the viterbi matrix of the symbol ids symbols in workspace.
+	 * backtrack[t*_numberNodes+i] is then the best predecessor of state i at the position t+1.
+	 *
+	 * @return last state of the most likely state sequence
+	 */
+	int viterbiMatrix(const int* symbols, int length, DPWorkspace& workspace,
+			const int*& backtrack) const;
+
+	double logTransition(int edge) const {
+		return std::log(_transitions[edge]);
+	}
+
+	double logEmission(int node, int symbol) const {
+		return symbol < 0 ?
+				-std::numeric_limits<double>::infinity() :
+				std::log(_emissions[symbol * _numberNodes + node]);
+	}
+
+	/**
+	 * Returns the states which are allowed to emit the t-th symbol of a sequence with the
+	 * label codes label (see expectationStep).
+	 */
+	const std::vector<int>& getAllowedStates(const std::vector<uint8_t>* label,
+			int t) const {
+		return label == NULL ?
+				_topology->_emittingStates :
+				_topology->_labelStates[(*label)[t]];
+	}
+
+	/**
+	 * Resizes the expected counts to the current topology and sets them to 0.
+	 */
+	void clearCounts(std::vector<double>& cTransitions,
+			std::vector<double>& cEmissions,
+			std::vector<double>& cInitial) const;
 
 	/**
 	 * This function calculates the sum of x and y in the log-space
@@ -73,36 +156,168 @@ private:
 	 *
 	 * @return the sum of exp(x) and exp(y) in the log space
 	 */
-	double elnsum(double x, double y);
+	static double elnsum(double x, double y);
 
 	/**
 	 * This function calculates the forward and backward function which is used to predict the
 	 * transition and emission probabilities. The contributions are added to cTransitions and
-	 * cEmissions.
+	 * cEmissions. If initialRun is true, then the emission alphabet is extended by the symbols
+	 * of the training set first. If labels is not NULL, then labels[k][t] is the code of the structure
+	 * label of the t-th symbol of the k-th sequence (see encodeLabels) and the forward and backward
+	 * function are only computed for those states whose label matches (see setStateLabels).
+	 *
+	 * @return log-likelihood of the sequences which can be emitted by this model
 	 */
-	void internalBaumWelch(
-			const std::vector<std::vector<std::string> >& trainingset,
-			boost::unordered_map<int, double>* cTransitions,
-			boost::unordered_map<std::string, double>* cEmissions,
-			double* cInitial, bool initialRun);
+	double internalBaumWelch(const EncodedSequences& trainingset,
+			const std::vector<std::vector<uint8_t> >* labels,
+			std::vector<double>& cTransitions,
+			std::vector<double>& cEmissions, std::vector<double>& cInitial,
+			bool initialRun);
+
+	/**
+	 * This function adds the contributions of a single sequence to the expected counts (see
+	 * internalBaumWelch). The symbol ids symbols of the sequence of length length have to be
+	 * allocated in _trainingWorkspace after its last reset.
+	 *
+	 * @argument label if not NULL, the codes of the structure labels of the sequence
+	 *
+	 * @return log-likelihood of the sequence, 0 if it cannot be emitted by this model
+	 */
+	double expectationStep(const int* symbols, int length,
+			const std::vector<uint8_t>* label,
+			std::vector<double>& cTransitions,
+			std::vector<double>& cEmissions, std::vector<double>& cInitial,
+			bool initialRun);
+
+	/**
+	 * This function moves the compiled transitions and emissions into the topology and the
+	 * parameter arrays and calculates the traversing order of the silent states. No node
+	 * is tied.
+	 */
+	void buildTopology();
+
+	/**
+	 * This function computes the tie groups of the topology from the tie groups of the
+	 * nodes (see HMM::setEmissionTie). If the nodes of a group are incompatible, then an
+	 * exception is thrown.
+	 */
+	void buildTies();
+
+	/**
+	 * Replaces the expected counts of every node with tied emissions or transitions by the
+	 * sum of the counts of its tie group.
+	 */
+	void poolTiedCounts(std::vector<double>& cTransitions,
+			std::vector<double>& cEmissions) const;
+
+	/**
+	 * Sets the tied probabilities of every node to those of the first node of its tie group.
+	 */
+	void applyTies();
+
+	/**
+	 * This function computes the new probabilities from the expected counts cTransitions,
+	 * cEmissions and cInitial. The counts of tied nodes are pooled and smoothed by pseudo
+	 * counts (the arguments are modified) and then normalized. Constant transitions and emissions are
+	 * not changed. The maximum probability changes are stored in maxDiffInitial,
+	 * maxDiffTransition and maxDiffEmission.
+	 */
+	void maximizationStep(std::vector<double>& cTransitions,
+			std::vector<double>& cEmissions, std::vector<double>& cInitial,
+			double& maxDiffInitial, double& maxDiffTransition,
+			double& maxDiffEmission);
+
+	/**
+	 * This function stores all learnable probabilities in parameters. These are the initial
+	 * distribution, the transitions of nodes without constant transitions and the emissions
+	 * of nodes without constant emissions. Tied probabilities are only stored once for their
+	 * tie group. The order is defined by the topology, thus it stays the same as long as
+	 * the emission alphabet does not change.
+	 */
+	void getParameters(std::vector<double>& parameters) const;
+
+	/**
+	 * This function sets the learnable probabilities to the values of parameters. The order
+	 * is the same as in getParameters.
+	 */
+	void setParameters(const std::vector<double>& parameters);
+
+	/**
+	 * This function projects the learnable probabilities back onto the probability simplex.
+	 * Negative probabilities are set to a small positive value and every distribution is
+	 * normalized again. Probabilities which are 0 stay 0.
+	 */
+	void projectParameters();
+
+	/**
+	 * This function contains the SQUAREM accelerated Baum-Welch algorithm. If labels is not
+	 * NULL, then the learning is label constrained by the label codes labels (see
+	 * encodeLabels).
+	 */
+	void squaremBaumWelch(const EncodedSequences& trainingset,
+			const std::vector<std::vector<uint8_t> >* labels, double threshold);
+
+	/**
+	 * This function contains the Baum-Welch algorithm with the maximum probability change as
+	 * termination criterium. If labels is not NULL, then the learning is label constrained
+	 * by the label codes labels (see encodeLabels).
+	 */
+	void thresholdBaumWelch(const EncodedSequences& trainingset,
+			const std::vector<std::vector<uint8_t> >* labels, double threshold);
+
+	/**
+	 * This function computes for every structure label the non-silent states which may
+	 * emit a symbol annotated with it from the state labels.
+	 */
+	void buildLabelStates();
+
+	/**
+	 * Returns the code of the structure label label. If the label is not known, then
+	 * an exception is thrown.
+	 */
+	int getLabelCode(const std::string& label) const;
 
 public:
+	/**
+	 * Uniform random number generator on [0,1). The HMM keeps no random state itself, thus
+	 * the caller provides the generator to the randomized functions. To get reproducible
+	 * results, every thread or try should use its own explicitly seeded generator.
+	 */
+	typedef boost::random::uniform_01<boost::random::mt19937> RandomGenerator;
+
 	HMMCompiled();
 	~HMMCompiled();
 
-	void copy(boost::shared_ptr<HMMCompiled> dst);
+	/**
+	 * Copies this model into dst. The topology is shared, thus only the parameter arrays
+	 * are copied.
+	 */
+	void copy(boost::shared_ptr<HMMCompiled> dst) const;
 
-	void setTransition(int x, int y, double value) {
-		_mapTransitions[x][y] = value;
-		_imapTransitions[y][x] = value;
-	}	//_transitions[x*_numberNodes + y] = value; }
+	/**
+	 * This function stores in dst a copy of this HMM whose emissions are projected by
+	 * symbolMap. Every emission symbol which is a key of symbolMap is replaced by the
+	 * associated value and the probabilities of all symbols which are mapped onto the
+	 * same value are summed up. Symbols which are no key of symbolMap are kept. Thus a
+	 * model learned on annotated sequences can be turned into one emitting the plain
+	 * bases without recompiling it from the HMM (see Models::createInverseAnnotatedSymbolMap).
+	 *
+	 * @argument symbolMap maps emission symbols to the projected symbols
+	 * @argument dst HMM which receives the projected model. It may be this.
+	 */
+	void projectEmissions(
+			const boost::unordered_map<std::string, std::string>& symbolMap,
+			boost::shared_ptr<HMMCompiled> dst) const;
+
+	void setTransition(int x, int y, double value);
 	double getTransition(int x, int y) const {
-		return _mapTransitions[x].count(y) > 0 ? _mapTransitions[x][y] : 0;
-	}	//return _transitions[x*_numberNodes + y]; }
+		int edge = _topology->getTransitionIndex(x, y);
+
+		return edge >= 0 ? _transitions[edge] : 0;
+	}
 	double getLogTransition(int x, int y) const {
-		return std::log(
-				_mapTransitions[x].count(y) > 0 ? _mapTransitions[x][y] : 0);
-	}	//return std::log(_transitions[x*_numberNodes + y]); }
+		return std::log(getTransition(x, y));
+	}
 	double getTransition(boost::shared_ptr<HMMNode> src,
 			boost::shared_ptr<HMMNode> dest);
 
@@ -135,8 +350,57 @@ public:
 	/**
 	 * Checks whether the node with id is silent
 	 */
-	bool isSilent(int id) {
-		return _silentStates.count(id) > 0;
+	bool isSilent(int id) const {
+		return _topology->isSilent(id);
+	}
+
+	/**
+	 * This function assigns to every node the structure label of the first key of mapping
+	 * which matches the name of the node. The keys are interpreted as regex (see
+	 * Models::veilMapping). The labels are needed for the label constrained Baum-Welch
+	 * algorithm and viterbiLabels. The names are matched only once per node, the labels
+	 * are shared by all copies of this model.
+	 */
+	void setStateLabels(
+			const boost::unordered_map<std::string, std::string>& mapping);
+
+	bool hasStateLabels() const {
+		return !_topology->_labelNames.empty();
+	}
+
+	/**
+	 * Returns the code of the structure label of the node with the index node,
+	 * HMMTopology::NO_LABEL if it has none.
+	 */
+	uint8_t getStateLabel(int node) const {
+		return _topology->_stateLabels[node];
+	}
+
+	int getNumberLabels() const {
+		return _topology->_labelNames.size();
+	}
+
+	/**
+	 * Returns the structure label with the code code (see setStateLabels).
+	 */
+	const std::string& getLabelName(int code) const {
+		return _topology->_labelNames[code];
+	}
+
+	/**
+	 * Appends the codes of the structure labels of every sequence of labels to codes. The
+	 * label constrained learning compares these codes instead of the label names. They
+	 * are valid for every model which shares the structure of this one, e.g. its copies.
+	 * If a label is not known, then an exception is thrown.
+	 */
+	void encodeLabels(const std::vector<std::vector<std::string> >& labels,
+			std::vector<std::vector<uint8_t> >& codes) const;
+
+	/**
+	 * Returns the structure of this model. It is shared by all copies of the model.
+	 */
+	const HMMTopology& getTopology() const {
+		return *_topology;
 	}
 
 	/**
@@ -161,10 +425,62 @@ public:
 	 */
 	boost::shared_ptr<HMMNode> getNode(int index) const;
 
-	double forward(const std::vector<std::string>& sequence);
+	double forward(const std::vector<std::string>& sequence) const;
+	void viterbi(const std::vector<std::string>& sequence,
+			std::vector<int>& stateSequence) const;
+	double backward(const std::vector<std::string>& sequence) const;
+
+	/**
+	 * These functions do the same as the previous ones, but they use the scratch memory of
+	 * workspace instead of allocating their own. They do not change the HMM, thus several
+	 * threads can use the same HMM concurrently as long as every thread has its own workspace.
+	 */
+	double forward(const std::vector<std::string>& sequence,
+			DPWorkspace& workspace) const;
 	void viterbi(const std::vector<std::string>& sequence,
-			std::vector<int>& stateSequence);
-	double backward(const std::vector<std::string>& sequence);
+			std::vector<int>& stateSequence, DPWorkspace& workspace) const;
+	double backward(const std::vector<std::string>& sequence,
+			DPWorkspace& workspace) const;
+
+	/**
+	 * These functions do the same as the previous ones for a sequence which is stored with
+	 * 2 bits per base. The bases are translated into symbol ids without creating strings.
+	 */
+	double forward(const PackedSequence& sequence,
+			DPWorkspace& workspace) const;
+	void viterbi(const PackedSequence& sequence,
+			std::vector<int>& stateSequence, DPWorkspace& workspace) const;
+
+	/**
+	 * These functions do the same for a sequence of a SequenceBatch.
+	 */
+	double forward(const SequenceBatch::Span& sequence,
+			DPWorkspace& workspace) const;
+	void viterbi(const SequenceBatch::Span& sequence,
+			std::vector<int>& stateSequence, DPWorkspace& workspace) const;
+
+	/**
+	 * This function computes the most likely state sequence like viterbi, but it stores
+	 * the code of the structure label of every state (see getStateLabel) instead of the
+	 * state. The labels are looked up in a table which is computed by setStateLabels while
+	 * backtracking, thus the state sequence is never materialized.
+	 *
+	 * @argument sequence sequence to decode
+	 * @argument labels label codes of the most likely state sequence
+	 * @argument workspace scratch memory of the viterbi algorithm
+	 */
+	void viterbiLabels(const std::vector<std::string>& sequence,
+			std::vector<uint8_t>& labels, DPWorkspace& workspace) const;
+	void viterbiLabels(const PackedSequence& sequence,
+			std::vector<uint8_t>& labels, DPWorkspace& workspace) const;
+	void viterbiLabels(const SequenceBatch::Span& sequence,
+			std::vector<uint8_t>& labels, DPWorkspace& workspace) const;
+
+	/**
+	 * Returns the maximum number of bytes of scratch memory the training used at the same
+	 * time, 0 if the model has not been trained yet.
+	 */
+	std::size_t getTrainingHighWaterMark() const;
 
 	/**
 	 * This function learns for the current model the transition and emission probabilities.
@@ -175,6 +491,93 @@ public:
 	void baumWelch(const std::vector<std::vector<std::string> >& trainingset,
 			double threshold);
 
+	/**
+	 * This function does the same as the previous one on an encoded training set, e.g. a
+	 * view of a SequenceBatch. The vector version copies the training set once into a
+	 * batch, thus learning several folds of the same sequences is cheaper with views (see
+	 * SequenceBatch::fold).
+	 */
+	void baumWelch(const EncodedSequences& trainingset, double threshold);
+
+	/**
+	 * This function does the same as the previous one, but it uses the structure annotation
+	 * labels of the training set. Instead of substituting the emissions by annotated symbols,
+	 * the forward and backward function of the t-th symbol of a sequence are only computed
+	 * for the states whose label (see setStateLabels) matches labels[k][t]. Thus the model
+	 * keeps emitting the plain bases and the learned model can be used directly for the
+	 * prediction.
+	 *
+	 * @argument trainingset plain DNA sequences
+	 * @argument labels structure annotation of every sequence of the training set
+	 * @argument threshold threshold value for the maximum probability change
+	 */
+	void baumWelch(const std::vector<std::vector<std::string> >& trainingset,
+			const std::vector<std::vector<std::string> >& labels,
+			double threshold);
+
+	/**
+	 * Label constrained version of baumWelch on an encoded training set. labels[k] are the
+	 * labels of its k-th sequence.
+	 */
+	void baumWelch(const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >& labels,
+			double threshold);
+
+	/**
+	 * This function performs a single iteration of the Baum-Welch algorithm. It allows to
+	 * interleave the learning of several HMMs, e.g. to compare them during the learning.
+	 *
+	 * @argument trainingset
+	 * @argument labels if not NULL, the structure labels of the training set used for the label
+	 * 	constrained learning (see baumWelch)
+	 * @argument initialRun has to be true for the first iteration on a training set. Then all
+	 * 	symbols of the training set are collected for the smoothing of the emissions.
+	 *
+	 * @return maximum probability change of this iteration
+	 */
+	double baumWelchStep(const std::vector<std::vector<std::string> >& trainingset,
+			const std::vector<std::vector<std::string> >* labels, bool initialRun);
+	double baumWelchStep(const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >* labels, bool initialRun);
+
+	/**
+	 * This function does the same as the previous one, but the labels are given as codes
+	 * (see encodeLabels). Thus the labels of a training set which is learned by many steps
+	 * are encoded only once.
+	 */
+	double baumWelchStep(const EncodedSequences& trainingset,
+			const std::vector<std::vector<uint8_t> >* labelCodes,
+			bool initialRun);
+
+	/**
+	 * This function learns the probabilities like baumWelch, but it accelerates the convergence
+	 * by the squared iterative method SQUAREM. Starting from the parameters p0, it computes two
+	 * Baum-Welch steps p1 = F(p0), p2 = F(p1) and extrapolates along r = p1 - p0 and
+	 * v = p2 - p1 - r: p' = p0 - 2*alpha*r + alpha^2*v with alpha = -|r|/|v|. The extrapolated
+	 * parameters are projected back onto the probability simplex and a further Baum-Welch step
+	 * is computed from them. If the log-likelihood of the extrapolated parameters is lower than
+	 * that of p1, then the step length is halved until it falls back to p2. Constant
+	 * transitions and emissions are never changed. It stops if the maximum probability change
+	 * of a Baum-Welch step is smaller than threshold.
+	 */
+	void acceleratedBaumWelch(
+			const std::vector<std::vector<std::string> >& trainingset,
+			double threshold);
+	void acceleratedBaumWelch(const EncodedSequences& trainingset,
+			double threshold);
+
+	/**
+	 * Label constrained version of acceleratedBaumWelch. See baumWelch for the meaning of
+	 * labels.
+	 */
+	void acceleratedBaumWelch(
+			const std::vector<std::vector<std::string> >& trainingset,
+			const std::vector<std::vector<std::string> >& labels,
+			double threshold);
+	void acceleratedBaumWelch(const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >& labels,
+			double threshold);
+
 	/**
 	 * This functions performs at its core the Baum-Welch algorithm to learn the probabilities of
 	 * a training set, but at the same time it uses a different termination criterium. For each
@@ -182,60 +585,115 @@ public:
 	 * learned model is used to predict the structure of the testing set and the accuracy of that
 	 * prediction is used as the termination criterium. If the difference of the current accuracy
 	 * value minus the previous one is lower than the negative threshold value, then it terminates.
+	 * The accuracy is computed by a StoppingPolicy, which may evaluate only a sample of the
+	 * testing set in most iterations.
 	 *
-	 * @argument hmm HMM from which this was compiled
-	 * @argument substitution emission substitution set if the models is learned by annotated sequences
-	 * @argument inverseSubstitution inverse substitution set for the emissions
+	 * @argument symbolMap maps the annotated emission symbols to the plain bases if the model is
+	 * 	learned by annotated sequences (see projectEmissions)
 	 * @argument trainingset
 	 * @argument testset
-	 * @argument annotations structure informations of the testset sequences
+	 * @argument annotations structure informations of the testset sequences as codes of
+	 * 	DatabaseEntry::Label (see Analytics::encodeAnnotations)
 	 * @argument threshold threshold value for the termination criterium
 	 * @argument annotated says whether the training set is annotated or not
+	 * @argument trainingLabels if not NULL, structure labels of the training set which are used
+	 * 	for the label constrained learning. The training set has then to be not annotated.
+	 * @argument pool if not NULL, the test set is evaluated in parallel by its workers (see
+	 * 	Analytics::analyse)
+	 * @argument stopping policy which decides when the learning stops. If it is NULL, then
+	 * 	every model is evaluated on the whole testing set (see FullEvaluation).
 	 *
-	 * @return best analytics result
+	 * @return best analytics result on the whole testing set
 	 */
-	Analytics::AnalyticsResult baumWelch(boost::shared_ptr<HMM> hmm,
-			const boost::unordered_map<std::string,
-					boost::unordered_map<std::string, std::string> >& substitution,
-			const boost::unordered_map<std::string,
-					boost::unordered_map<std::string, std::string> >& inverseSubstitution,
+	Analytics::AnalyticsResult baumWelch(
+			const boost::unordered_map<std::string, std::string>& symbolMap,
 			const std::vector<std::vector<std::string> >& trainingset,
 			const std::vector<std::vector<std::string> >& testset,
-			const std::vector<std::vector<std::string> >& annotations,
-			double threshold, bool annotated);
+			const std::vector<std::vector<uint8_t> >& annotations,
+			double threshold, bool annotated,
+			const std::vector<std::vector<std::string> >* trainingLabels = NULL,
+			ThreadPool* pool = NULL, StoppingPolicy* stopping = NULL);
+
+	/**
+	 * This function does the same as the previous one on an encoded training set, e.g.
+	 * the sequences of a GeneDatabase whose symbols are computed when they are read (see
+	 * DatabaseSequences).
+	 */
+	Analytics::AnalyticsResult baumWelch(
+			const boost::unordered_map<std::string, std::string>& symbolMap,
+			const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations,
+			double threshold, bool annotated,
+			const std::vector<std::vector<std::string> >* trainingLabels = NULL,
+			ThreadPool* pool = NULL, StoppingPolicy* stopping = NULL);
 
 	/**
 	 * This functions is similar to the previous one, only that the Baum-Welch algorithm is performed
 	 * a numIterations before it terminates.
-	 * @argument hmm HMM from which this was compiled
-	 * @argument substitution emission substitution set if the models is learned by annotated sequences
-	 * @argument inverseSubstitution inverse substitution set for the emissions
+	 * @argument symbolMap maps the annotated emission symbols to the plain bases if the model is
+	 * 	learned by annotated sequences (see projectEmissions)
 	 * @argument trainingset
 	 * @argument testset
-	 * @argument annotations structure informations of the testset sequences
+	 * @argument annotations structure informations of the testset sequences as codes of
+	 * 	DatabaseEntry::Label (see Analytics::encodeAnnotations)
 	 * @argument numIterations number of learning iterations
 	 * @argument annotated says whether the training set is annotated or not
+	 * @argument trainingLabels if not NULL, structure labels of the training set which are used
+	 * 	for the label constrained learning. The training set has then to be not annotated.
+	 * @argument pool if not NULL, the test set is evaluated in parallel by its workers (see
+	 * 	Analytics::analyse)
 	 *
 	 * @return best analytics result
 	 */
-	Analytics::AnalyticsResult baumWelchIterated(boost::shared_ptr<HMM> hmm,
-			const boost::unordered_map<std::string,
-					boost::unordered_map<std::string, std::string> >& substitution,
-			const boost::unordered_map<std::string,
-					boost::unordered_map<std::string, std::string> >& inverseSubstitution,
+	Analytics::AnalyticsResult baumWelchIterated(
+			const boost::unordered_map<std::string, std::string>& symbolMap,
 			const std::vector<std::vector<std::string> >& trainingset,
 			const std::vector<std::vector<std::string> >& testset,
-			const std::vector<std::vector<std::string> >& annotations,
-			int numIterations, bool annotated);
+			const std::vector<std::vector<uint8_t> >& annotations,
+			int numIterations, bool annotated,
+			const std::vector<std::vector<std::string> >* trainingLabels = NULL,
+			ThreadPool* pool = NULL);
+	Analytics::AnalyticsResult baumWelchIterated(
+			const boost::unordered_map<std::string, std::string>& symbolMap,
+			const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations,
+			int numIterations, bool annotated,
+			const std::vector<std::vector<std::string> >* trainingLabels = NULL,
+			ThreadPool* pool = NULL);
 
 	/**
-	 * This function calculates the traversing order of the silent states.
+	 * This function learns the probabilities by the stepwise online EM algorithm. Instead of
+	 * processing the complete training set in every iteration, the sequences are read in
+	 * mini-batches from source. For every mini-batch the expected counts are computed and
+	 * interpolated with the counts of the previous mini-batches using the decaying step size
+	 * eta_k = (k+1)^(-stepExponent) of the k-th mini-batch. After each mini-batch the
+	 * probabilities are updated. Thus only one mini-batch has to be kept in memory.
+	 *
+	 * @argument hmm HMM from which this was compiled. It is used to write the checkpoints.
+	 * @argument source source of the training sequences
+	 * @argument batchSize number of sequences of a mini-batch
+	 * @argument epochs number of passes over the sequences of source
+	 * @argument stepExponent exponent of the step size. It has to be in (0.5,1].
+	 * @argument checkpointInterval the learned HMM is written every checkpointInterval
+	 * 	mini-batches to checkpointFilename. If it is 0, then no checkpoints are written.
+	 * @argument checkpointFilename file to which the checkpoints are written
+	 */
+	void onlineBaumWelch(boost::shared_ptr<HMM> hmm, SequenceSource& source,
+			int batchSize, int epochs, double stepExponent,
+			int checkpointInterval, const std::string& checkpointFilename);
+
+	/**
+	 * This function calculates the traversing order of the silent states and the tie
+	 * groups.
 	 */
 	void finishCompilation();
 	/**
-	 * This function inits all random probabilities with a uniformly distributed value.
+	 * This function inits all random probabilities with a uniformly distributed value
+	 * drawn from random.
 	 */
-	void initProbabilities();
+	void initProbabilities(RandomGenerator& random);
 
 	/**
 	 * This function simulates n steps of the HMM and stores its output into sequence
@@ -244,29 +702,69 @@ public:
 	 * @argument n length of simulation sequence
 	 * @argument sequence output sequence
 	 * @argument states state sequence of the simulation
+	 * @argument random random number generator used for the simulation
 	 */
 	void simulate(int n, std::vector<std::string>& sequence,
-			std::vector<int>& states);
+			std::vector<int>& states, RandomGenerator& random) const;
 
 	/**
 	 * Draws randomly a state from the distribution given by distribution. For that
 	 * purpose it draws a uniformly value r from [0,1) and looks for the partial sum
 	 * s_i = sum_{j=0}^{i} distribution[j] such that s_i <= r < s_(i+1).
 	 */
-	int getState(double* distribution);
+	int getState(const double* distribution, RandomGenerator& random) const;
 
 	/**
 	 * Does the same as the previous function. It just takes the distribution in a different
 	 * form.
 	 */
-	int getState(const boost::unordered_map<int, double>& distribution);
+	int getState(const boost::unordered_map<int, double>& distribution,
+			RandomGenerator& random) const;
 
 	/**
 	 * This function draws randomly emission from the emission distribution emissions. It
 	 * works the same way as getState.
 	 */
 	std::string getRandomEmission(
-			boost::unordered_map<std::string, double>& emissions);
+			const boost::unordered_map<std::string, double>& emissions,
+			RandomGenerator& random) const;
+
+	/**
+	 * Draws randomly a symbol from the emission distribution of the node with the index
+	 * node.
+	 */
+	const std::string& getRandomEmission(int node,
+			RandomGenerator& random) const;
+
+	/**
+	 * This function stores in dst the minimized version of this HMM. For that purpose the
+	 * probabilistically bisimilar states are merged. Two emitting states are bisimilar if
+	 * they have the same emission distribution, the same structure label (see
+	 * setStateLabels), the same constant flags and for every class of bisimilar states the
+	 * same probability to move into it. The classes are computed by partition refinement.
+	 * Silent states are never merged. Every class is represented by its node with the
+	 * smallest index. The minimized model assigns every sequence the same forward
+	 * likelihood, but not the same Viterbi path: the most likely path of the lumped model
+	 * may run through a merged class whose states are less likely one by one than another
+	 * state of the original model. Thus it is only meant for likelihood computations, the
+	 * decoding and the learning have to be done on the original model.
+	 *
+	 * @argument dst HMM which receives the minimized model. It must not be this. Its
+	 * 	getIndex maps every node of this HMM onto the index of its class and
+	 * 	getMergedNodes maps a class back onto its nodes.
+	 * @argument precision probabilities are considered equal if they are equal after
+	 * 	rounding them to a multiple of precision
+	 */
+	void minimize(boost::shared_ptr<HMMCompiled> dst,
+			double precision = 1e-9) const;
+
+	/**
+	 * Stores in nodes the nodes of the original model which were merged into the node
+	 * with the internal index index (see minimize). If the model has not been minimized,
+	 * then this is only the node itself.
+	 */
+	void getMergedNodes(int index,
+			std::vector<boost::shared_ptr<HMMNode> >& nodes) const;
 
 	/**
 	 * This function gets a sequence of state ids and translates those into a sequence
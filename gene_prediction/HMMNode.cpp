@@ -57,6 +57,16 @@ void HMMNode::serialize(std::ostream& os) const{
 	os << "ConstantTransitions:" << _constantTransitions << std::endl;
 	os << "ConstantEmissions:" << _constantEmissions << std::endl;
 	os << "ConstantEmissionSet:" << _constantEmissionSet << std::endl;
+
+	// the tie groups are optional to be able to read models without them
+	if(!_emissionTie.empty()){
+		os << "EmissionTie:" << _emissionTie << std::endl;
+	}
+
+	if(!_transitionTie.empty()){
+		os << "TransitionTie:" << _transitionTie << std::endl;
+	}
+
 	os << "Transitions:" << _transitions.size() << std::endl;
 
 	for(boost::unordered_map<int,HMMTransition>::const_iterator it = _transitions.begin();
@@ -82,6 +92,8 @@ void HMMNode::deserialize(std::istream& is,boost::shared_ptr<HMMNode> hmmNode){
 	bool constantTransitions;
 	bool constantEmissions;
 	bool constantEmissionSet;
+	std::string emissionTie;
+	std::string transitionTie;
 	boost::smatch sm;
 
 	std::getline(is,line);
@@ -150,6 +162,16 @@ void HMMNode::deserialize(std::istream& is,boost::shared_ptr<HMMNode> hmmNode){
 
 	std::getline(is,line);
 
+	if(boost::regex_match(line,sm,boost::regex("EmissionTie:(.*)"))){
+		emissionTie = sm[1];
+		std::getline(is,line);
+	}
+
+	if(boost::regex_match(line,sm,boost::regex("TransitionTie:(.*)"))){
+		transitionTie = sm[1];
+		std::getline(is,line);
+	}
+
 	if(boost::regex_match(line,sm,boost::regex("Transitions:(.*)"))){
 		int numberTransitions;
 		ss.str(sm[1]);
@@ -186,6 +208,8 @@ void HMMNode::deserialize(std::istream& is,boost::shared_ptr<HMMNode> hmmNode){
 	hmmNode->_constantTransitions = constantTransitions;
 	hmmNode->_constantEmissions = constantEmissions;
 	hmmNode->_constantEmissionSet = constantEmissionSet;
+	hmmNode->_emissionTie = emissionTie;
+	hmmNode->_transitionTie = transitionTie;
 }
 
 boost::shared_ptr<HMMNode> HMMNode::deserialize(std::istream& is){
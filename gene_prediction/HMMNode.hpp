@@ -34,6 +34,10 @@ protected:
 	bool _constantEmissions;
 	bool _constantTransitions;
 	bool _constantEmissionSet;
+	// name of the tie group of the emissions, empty if they are not tied
+	std::string _emissionTie;
+	// name of the tie group of the transitions, empty if they are not tied
+	std::string _transitionTie;
 public:
 	HMMNode(int id=-1,const std::string& name = "");
 	HMMNode(int id,const std::string& name, const Transition& transitions,const Emission& emissions,
@@ -55,6 +59,12 @@ public:
 	bool& constantEmissions() { return _constantEmissions;}
 	bool& constantEmissionSet() {return _constantEmissionSet;}
 
+	const std::string& emissionTie() const { return _emissionTie; }
+	const std::string& transitionTie() const { return _transitionTie; }
+
+	std::string& emissionTie() { return _emissionTie; }
+	std::string& transitionTie() { return _transitionTie; }
+
 	virtual int size() const { return 1; }
 	int shallowSize() const { return 1; }
 
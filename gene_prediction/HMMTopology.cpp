@@ -0,0 +1,52 @@
+/*
+ * HMMTopology.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "HMMTopology.hpp"
+
+#include <algorithm>
+
+const uint8_t HMMTopology::NO_LABEL;
+
+HMMTopology::HMMTopology() :
+		_numberNodes(0), _silentLast(false), _transitionOffsets(1, 0), _inverseOffsets(
+				1, 0), _emissionOffsets(1, 0) {
+}
+
+int HMMTopology::addSymbol(const std::string& symbol) {
+	boost::unordered_map<std::string, int>::const_iterator it = _symbolIds.find(
+			symbol);
+
+	if (it != _symbolIds.end()) {
+		return it->second;
+	}
+
+	_symbols.push_back(symbol);
+	_symbolIds.emplace(symbol, _symbols.size() - 1);
+
+	return _symbols.size() - 1;
+}
+
+int HMMTopology::getSymbolId(const std::string& symbol) const {
+	boost::unordered_map<std::string, int>::const_iterator it = _symbolIds.find(
+			symbol);
+
+	return it != _symbolIds.end() ? it->second : -1;
+}
+
+int HMMTopology::getTransitionIndex(int src, int dest) const {
+	std::vector<int>::const_iterator begin = _transitionTargets.begin()
+			+ _transitionOffsets[src];
+	std::vector<int>::const_iterator end = _transitionTargets.begin()
+			+ _transitionOffsets[src + 1];
+	std::vector<int>::const_iterator it = std::lower_bound(begin, end, dest);
+
+	if (it != end && *it == dest) {
+		return it - _transitionTargets.begin();
+	} else {
+		return -1;
+	}
+}
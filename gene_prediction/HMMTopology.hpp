@@ -0,0 +1,156 @@
+/*
+ * HMMTopology.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef HMMTOPOLOGY_HPP_
+#define HMMTOPOLOGY_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+class HMMNode;
+class HMMCompiled;
+
+/**
+ * This class contains the structure of a compiled HMM which does not change during the
+ * learning: the mapping between nodes and indices, the node flags, the transitions as
+ * compressed sparse rows, the traversal order of the silent states, the emission alphabet
+ * and the structure labels. The probabilities are stored by the HMMCompiled in flat
+ * arrays which are indexed by the transition and symbol ids of the topology. Once compiled,
+ * a topology is never changed, thus it can be shared by all copies of an HMMCompiled and a
+ * copy of a model only copies its parameter arrays. An HMMCompiled which needs a different
+ * structure (e.g. another alphabet) creates a new topology.
+ */
+class HMMTopology {
+private:
+	friend class HMMCompiled;
+
+	int _numberNodes;
+	// _nodes[i] = node with the internal index i
+	std::vector<boost::shared_ptr<HMMNode> > _nodes;
+	// inverse mapping
+	boost::unordered_map<boost::shared_ptr<HMMNode>, int> _node2Int;
+
+	// _silent[i] = node i is silent
+	std::vector<char> _silent;
+	// _constantTransitions[i] = node i has constant transitions
+	std::vector<char> _constantTransitions;
+	// same for emissions
+	std::vector<char> _constantEmissions;
+	// same for emission sets
+	std::vector<char> _constantEmissionSet;
+	// non-silent nodes in increasing order
+	std::vector<int> _emittingStates;
+	// true if the silent nodes have the highest indices (see HMM::compile), then a node
+	// is silent iff its index is at least _emittingStates.size()
+	bool _silentLast;
+	// order in which the silent states has to be traversed for computing
+	// the transitions probabilities
+	std::vector<int> _silentStateOrder;
+
+	// The outgoing transitions of node i are the edges _transitionOffsets[i],...,
+	// _transitionOffsets[i+1]-1 and edge e leads to _transitionTargets[e]. The targets of
+	// every node are sorted.
+	std::vector<int> _transitionOffsets;
+	std::vector<int> _transitionTargets;
+	// The incoming transitions of node i are _inverseOffsets[i],...,_inverseOffsets[i+1]-1.
+	// The k-th one comes from _inverseSources[k] and is the edge _inverseEdges[k].
+	std::vector<int> _inverseOffsets;
+	std::vector<int> _inverseSources;
+	std::vector<int> _inverseEdges;
+
+	// _symbols[a] = emission symbol with the id a
+	std::vector<std::string> _symbols;
+	// inverse mapping
+	boost::unordered_map<std::string, int> _symbolIds;
+	// The symbols which node i emits according to the HMM it was compiled from are
+	// _emissionSymbols[_emissionOffsets[i]],...,_emissionSymbols[_emissionOffsets[i+1]-1].
+	// They are the emission set of nodes with constant emission sets.
+	std::vector<int> _emissionOffsets;
+	std::vector<int> _emissionSymbols;
+
+	// _stateLabels[i] = code of the structure label of node i, NO_LABEL if the node has no
+	// label. A decoded state sequence is translated into labels by a lookup in this table.
+	std::vector<uint8_t> _stateLabels;
+	// _labelNames[l] = structure label ("E", "I", "U", "D") associated to the code l
+	std::vector<std::string> _labelNames;
+	// _labelStates[l] = non-silent states which may emit a symbol annotated with label l.
+	// Unlabeled states are contained in every list.
+	std::vector<std::vector<int> > _labelStates;
+
+	// _emissionTies[i] = smallest index of the nodes whose emissions are tied to those of
+	// node i (see HMMNode::emissionTie), i if the emissions of node i are not tied. The same
+	// for the transitions.
+	std::vector<int> _emissionTies;
+	std::vector<int> _transitionTies;
+
+	// nodes whose transitions are learned, i.e. which have no constant transitions
+	std::vector<int> _learnableTransitionNodes;
+	// non-silent nodes whose emissions are learned, i.e. which have no constant emissions
+	std::vector<int> _learnableEmissionNodes;
+
+	// If this topology was created by HMMCompiled::minimize, then node i represents the nodes
+	// _mergedNodes[_mergedOffsets[i]],...,_mergedNodes[_mergedOffsets[i+1]-1] of the original
+	// model. Otherwise both are empty.
+	std::vector<int> _mergedOffsets;
+	std::vector<boost::shared_ptr<HMMNode> > _mergedNodes;
+
+	// If this topology was created by HMMCompiled::projectEmissions, then it is the
+	// projection of _projectedFrom by _projectionMap. This allows to reuse it for the
+	// next projection of the same model.
+	boost::shared_ptr<const HMMTopology> _projectedFrom;
+	boost::unordered_map<std::string, std::string> _projectionMap;
+
+	/**
+	 * Returns the id of symbol. If symbol is not contained in the alphabet, then it is
+	 * added.
+	 */
+	int addSymbol(const std::string& symbol);
+
+public:
+	// label code of the states without a structure label
+	static const uint8_t NO_LABEL = 0xff;
+
+	HMMTopology();
+
+	int getNumberNodes() const {
+		return _numberNodes;
+	}
+
+	int getNumberTransitions() const {
+		return _transitionTargets.size();
+	}
+
+	int getNumberSymbols() const {
+		return _symbols.size();
+	}
+
+	bool isSilent(int node) const {
+		return _silentLast ?
+				node >= static_cast<int>(_emittingStates.size()) :
+				_silent[node] != 0;
+	}
+
+	const std::string& getSymbol(int id) const {
+		return _symbols[id];
+	}
+
+	/**
+	 * Returns the id of symbol, -1 if it is not contained in the alphabet.
+	 */
+	int getSymbolId(const std::string& symbol) const;
+
+	/**
+	 * Returns the id of the transition from src to dest, -1 if there is no such transition.
+	 */
+	int getTransitionIndex(int src, int dest) const;
+};
+
+#endif /* HMMTOPOLOGY_HPP_ */
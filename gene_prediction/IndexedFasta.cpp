@@ -0,0 +1,261 @@
+/*
+ * IndexedFasta.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "IndexedFasta.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <limits>
+
+bool IndexedFasta::open(const std::string& filename, int numberThreads) {
+	std::string indexFilename = filename + ".fai";
+
+	_records.clear();
+	_index.clear();
+
+	if (!_file.open(filename)) {
+		return false;
+	}
+
+	if (!readIndex(indexFilename)) {
+		buildIndex(numberThreads);
+
+		if (!writeIndex(indexFilename)) {
+			std::cerr << "Could not write index:" << indexFilename << std::endl;
+		}
+	}
+
+	// emplace keeps the first record of a name, later ones are only found by getRecord
+	for (int k = 0; k < (int) _records.size(); k++) {
+		_index.emplace(_records[k]._name, k);
+	}
+
+	return true;
+}
+
+bool IndexedFasta::readIndex(const std::string& filename) {
+	std::ifstream is;
+	std::string line;
+
+	is.open(filename.c_str(), std::ios_base::in);
+
+	if (!is) {
+		return false;
+	}
+
+	while (std::getline(is, line)) {
+		std::istringstream ss(line);
+		Record record;
+
+		if (line.empty()) {
+			continue;
+		}
+
+		std::getline(ss, record._name, '\t');
+		ss >> record._length >> record._offset >> record._lineBases
+				>> record._lineWidth;
+
+		if (!ss || record._length < 0
+				|| (record._length > 0
+						&& (record._lineBases <= 0
+								|| record._lineWidth < record._lineBases))) {
+			throw std::invalid_argument(
+					"IndexedFasta: Invalid line of the index " + filename + ": "
+							+ line);
+		}
+
+		_records.push_back(record);
+	}
+
+	return true;
+}
+
+void IndexedFasta::buildIndex(int numberThreads) {
+	std::vector<char> data;
+	// true if the current record had a line with less bases than the first one
+	bool ended = false;
+
+	_file.readAll(data, numberThreads);
+
+	const char* begin = data.empty() ? NULL : &data[0];
+	const char* end = begin + data.size();
+
+	for (const char* position = begin; position < end;) {
+		const char* newline = (const char*) memchr(position, '\n',
+				end - position);
+		const char* lineEnd = newline != NULL ? newline + 1 : end;
+		const char* contentEnd = newline != NULL ? newline : end;
+
+		if (contentEnd > position && contentEnd[-1] == '\r') {
+			contentEnd--;
+		}
+
+		if (*position == '>') {
+			Record record;
+			const char* nameEnd = position + 1;
+
+			while (nameEnd < contentEnd && !std::isspace((unsigned char) *nameEnd)) {
+				nameEnd++;
+			}
+
+			record._name.assign(position + 1, nameEnd);
+			record._length = 0;
+			record._offset = lineEnd - begin;
+			record._lineBases = 0;
+			record._lineWidth = 0;
+
+			_records.push_back(record);
+			ended = false;
+		} else if (!_records.empty()) {
+			// lines before the first record are skipped
+			Record& record = _records.back();
+			int bases = contentEnd - position;
+			int width = lineEnd - position;
+
+			if (bases > 0) {
+				if (ended || (record._lineBases > 0 && (bases > record._lineBases
+						|| (bases == record._lineBases
+								&& width != record._lineWidth)))) {
+					throw std::invalid_argument(
+							"IndexedFasta: The record " + record._name
+									+ " has lines of different length.");
+				}
+
+				if (record._lineBases == 0) {
+					record._lineBases = bases;
+					record._lineWidth = width;
+				} else if (bases < record._lineBases) {
+					ended = true;
+				}
+
+				record._length += bases;
+			} else {
+				// only blank lines may follow a blank line
+				ended = true;
+			}
+		}
+
+		position = lineEnd;
+	}
+}
+
+bool IndexedFasta::writeIndex(const std::string& filename) const {
+	std::ofstream os;
+
+	os.open(filename.c_str(), std::ios_base::out);
+
+	for (std::vector<Record>::const_iterator it = _records.begin();
+			it != _records.end(); ++it) {
+		os << it->_name << '\t' << it->_length << '\t' << it->_offset << '\t'
+				<< it->_lineBases << '\t' << it->_lineWidth << '\n';
+	}
+
+	os.close();
+
+	return !os.fail();
+}
+
+std::string IndexedFasta::getName(const std::string& id) {
+	std::size_t end = 0;
+
+	while (end < id.size() && !std::isspace((unsigned char) id[end])) {
+		end++;
+	}
+
+	return id.substr(0, end);
+}
+
+IndexedFasta::Region IndexedFasta::parseRegion(const std::string& region) {
+	Region result;
+	std::size_t colon = region.rfind(':');
+	char separator;
+
+	result._name = region;
+	result._begin = 0;
+	result._end = std::numeric_limits<int64_t>::max();
+
+	if (colon == std::string::npos) {
+		return result;
+	}
+
+	std::istringstream ss(region.substr(colon + 1));
+
+	result._name = region.substr(0, colon);
+	ss >> result._begin;
+
+	bool valid = !ss.fail();
+
+	// the end is optional
+	if (valid && ss >> separator) {
+		valid = separator == '-' && ss >> result._end && !(ss >> separator);
+	}
+
+	if (!valid || result._name.empty() || result._begin < 1
+			|| result._end < result._begin) {
+		throw std::invalid_argument(
+				"IndexedFasta: Invalid region " + region + ".");
+	}
+
+	result._begin--;
+
+	return result;
+}
+
+int IndexedFasta::find(const std::string& name) const {
+	boost::unordered_map<std::string, int>::const_iterator it = _index.find(
+			name);
+
+	return it != _index.end() ? it->second : -1;
+}
+
+void IndexedFasta::fetch(const std::string& name, int64_t begin, int64_t end,
+		PackedSequence& sequence,
+		PackedSequence::RandomGenerator& random) const {
+	int k = find(name);
+	std::string text;
+
+	if (k < 0) {
+		throw std::invalid_argument(
+				"IndexedFasta: There is no record " + name + ".");
+	}
+
+	const Record& record = _records[k];
+
+	end = std::min(end, record._length);
+
+	if (begin < 0 || begin > end) {
+		throw std::invalid_argument(
+				"IndexedFasta: Invalid range of the record " + name + ".");
+	}
+
+	if (begin == end) {
+		return;
+	}
+
+	// the line breaks between the bases are skipped by PackedSequence::append
+	_file.read(getOffset(record, begin), getOffset(record, end - 1) + 1, text);
+
+	sequence.reserve(sequence.size() + (end - begin));
+	sequence.append(text.data(), text.data() + text.size(), random);
+}
+
+void IndexedFasta::fetch(const std::string& name, PackedSequence& sequence,
+		PackedSequence::RandomGenerator& random) const {
+	int k = find(name);
+
+	if (k < 0) {
+		throw std::invalid_argument(
+				"IndexedFasta: There is no record " + name + ".");
+	}
+
+	fetch(name, 0, _records[k]._length, sequence, random);
+}
@@ -0,0 +1,158 @@
+/*
+ * IndexedFasta.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef INDEXEDFASTA_HPP_
+#define INDEXEDFASTA_HPP_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+#include <boost/utility.hpp>
+
+#include "BgzfFile.hpp"
+#include "PackedSequence.hpp"
+
+/**
+ * This class gives random access to the records of a fasta file, which may be compressed
+ * by bgzip (see BgzfFile). The positions of the records are taken from an index in the
+ * format of samtools faidx (filename followed by ".fai"), thus a region of a record is
+ * read by decompressing only the blocks which contain it. Several threads can fetch
+ * records concurrently.
+ *
+ * Like in samtools faidx, the name of a record is its identifier line up to the first
+ * whitespace, whereas GeneDatabase::importFile keys an entry by its whole identifier
+ * line. getName maps the identifier of an entry to the name of its record.
+ */
+class IndexedFasta: boost::noncopyable {
+public:
+	/**
+	 * Line of the faidx index.
+	 */
+	struct Record {
+		// identifier up to the first whitespace
+		std::string _name;
+		// number of bases
+		int64_t _length;
+		// position of the first base in the uncompressed file
+		uint64_t _offset;
+		// number of bases per line and number of bytes per line including the line break
+		int _lineBases;
+		int _lineWidth;
+	};
+
+	/**
+	 * Range of bases of a record.
+	 */
+	struct Region {
+		std::string _name;
+		// first base (starting at 0) and the base after the last one
+		int64_t _begin;
+		int64_t _end;
+	};
+
+private:
+	BgzfFile _file;
+	std::vector<Record> _records;
+	boost::unordered_map<std::string, int> _index;
+
+	/**
+	 * Reads the faidx index filename.
+	 *
+	 * @return false if it does not exist
+	 */
+	bool readIndex(const std::string& filename);
+
+	/**
+	 * Builds the index by a full scan of the file, which is decompressed by numberThreads
+	 * threads. The lines of a record must have the same length except for its last line.
+	 */
+	void buildIndex(int numberThreads);
+
+	/**
+	 * Writes the index in faidx format to filename.
+	 *
+	 * @return false if the file could not be written
+	 */
+	bool writeIndex(const std::string& filename) const;
+
+	/**
+	 * Returns the position of the base position of record in the uncompressed file.
+	 */
+	static uint64_t getOffset(const Record& record, int64_t position) {
+		return record._offset + position / record._lineBases * record._lineWidth
+				+ position % record._lineBases;
+	}
+
+public:
+	/**
+	 * Opens the fasta file filename and its index filename.fai. If there is no index,
+	 * then it is built by a full scan and written.
+	 *
+	 * @argument numberThreads number of threads which decompress the file if the index
+	 * 		has to be built, one per hardware thread if it is not positive
+	 * @return false if the file could not be opened
+	 */
+	bool open(const std::string& filename, int numberThreads = 0);
+
+	int size() const {
+		return _records.size();
+	}
+
+	/**
+	 * Returns the k-th record in the order of the file.
+	 */
+	const Record& getRecord(int k) const {
+		return _records[k];
+	}
+
+	/**
+	 * Returns the name of the record whose identifier line is id (without ">"), e.g. the
+	 * identifier of a GeneDatabase entry: id up to its first whitespace.
+	 */
+	static std::string getName(const std::string& id);
+
+	/**
+	 * Parses a region in the notation of samtools faidx: name, name:begin or
+	 * name:begin-end, where the positions start at 1 and end is included. Without end
+	 * the region reaches up to the end of the record (see fetch). Malformed regions cause
+	 * a std::invalid_argument.
+	 */
+	static Region parseRegion(const std::string& region);
+
+	/**
+	 * Returns the index of the record name, -1 if there is no such record.
+	 */
+	int find(const std::string& name) const;
+
+	/**
+	 * Appends the bases begin,...,end-1 (starting at 0) of the record name to sequence.
+	 * end is clipped to the length of the record. If there is no record name or the
+	 * range is invalid, then a std::invalid_argument is thrown.
+	 *
+	 * @argument random instantiates ambiguity codes (see PackedSequence::append)
+	 */
+	void fetch(const std::string& name, int64_t begin, int64_t end,
+			PackedSequence& sequence, PackedSequence::RandomGenerator& random) const;
+
+	/**
+	 * Appends the bases of region to sequence.
+	 */
+	void fetch(const Region& region, PackedSequence& sequence,
+			PackedSequence::RandomGenerator& random) const {
+		fetch(region._name, region._begin, region._end, sequence, random);
+	}
+
+	/**
+	 * Appends all bases of the record name to sequence.
+	 */
+	void fetch(const std::string& name, PackedSequence& sequence,
+			PackedSequence::RandomGenerator& random) const;
+};
+
+#endif /* INDEXEDFASTA_HPP_ */
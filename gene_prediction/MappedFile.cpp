@@ -0,0 +1,70 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile() :
+		_data(NULL), _size(0) {
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& filename, bool sequential) {
+	struct stat status;
+
+	close();
+
+	int file = ::open(filename.c_str(), O_RDONLY);
+
+	if (file < 0) {
+		return false;
+	}
+
+	if (fstat(file, &status) != 0) {
+		::close(file);
+		return false;
+	}
+
+	// an empty file cannot be mapped
+	if (status.st_size > 0) {
+		void* memory = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file,
+				0);
+
+		if (memory == MAP_FAILED) {
+			::close(file);
+			return false;
+		}
+
+		if (sequential) {
+			madvise(memory, status.st_size, MADV_SEQUENTIAL);
+		}
+
+		_data = (const char*) memory;
+		_size = status.st_size;
+	}
+
+	// the mapping stays valid after the file is closed
+	::close(file);
+
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data != NULL) {
+		munmap((void*) _data, _size);
+	}
+
+	_data = NULL;
+	_size = 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * MappedFile.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef MAPPEDFILE_HPP_
+#define MAPPEDFILE_HPP_
+
+#include <string>
+#include <cstddef>
+
+#include <boost/utility.hpp>
+
+/**
+ * This class maps a file read-only into the memory. The pages are read by the kernel when
+ * they are accessed, thus a large file can be parsed without copying it into buffers of
+ * streams. The mapping is removed by the destructor.
+ */
+class MappedFile: boost::noncopyable {
+private:
+	const char* _data;
+	std::size_t _size;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	/**
+	 * Maps the file filename. A previously mapped file is unmapped first.
+	 *
+	 * @argument sequential if true, the kernel is advised that the file is read
+	 * 	sequentially, thus it reads ahead more aggressively
+	 *
+	 * @return false if the file could not be opened or mapped
+	 */
+	bool open(const std::string& filename, bool sequential = true);
+
+	void close();
+
+	/**
+	 * Returns the content of the file. It is NULL if the file is empty.
+	 */
+	const char* data() const {
+		return _data;
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+};
+
+#endif /* MAPPEDFILE_HPP_ */
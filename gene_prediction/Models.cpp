@@ -21,7 +21,7 @@ boost::unordered_map<std::string,std::string> Models::veilMapping = createVeilMa
  * For the explanation of the model see the paper
  * "Finding Genes in DNA with a Hidden Markov Model".
  */
-boost::shared_ptr<HMM> Models::createExonModel(){
+boost::shared_ptr<HMM> Models::createExonModel(bool tied){
 	boost::shared_ptr<HMM> result(new HMM());
 	std::string endings[] = {"A", "C", "G", "T"};
 	std::stringstream ss1,ss2,ss3;
@@ -50,6 +50,13 @@ boost::shared_ptr<HMM> Models::createExonModel(){
 	result->setConstantEmissionSet(absorbing3);
 	result->setConstantEmissionSet(absorbing4);
 
+	if(tied){
+		result->setEmissionTie(absorbing1,"ExonAbsorbing");
+		result->setEmissionTie(absorbing2,"ExonAbsorbing");
+		result->setEmissionTie(absorbing3,"ExonAbsorbing");
+		result->setEmissionTie(absorbing4,"ExonAbsorbing");
+	}
+
 	result->addEmission(stopCodonA1,HMMEmission("A",1));
 	result->setConstantEmissions(stopCodonA1,true);
 	result->addEmission(stopCodonA2,HMMEmission("A",1));
@@ -153,7 +160,7 @@ boost::shared_ptr<HMM> Models::createExonModel(){
  * For the explanation of the model see the paper
  * "Finding Genes in DNA with a Hidden Markov Model".
  */
-boost::shared_ptr<HMM> Models::createIntronModel(){
+boost::shared_ptr<HMM> Models::createIntronModel(bool tied){
 	boost::shared_ptr<HMM> result(new HMM());
 	std::string endings[] = {"A","C","G","T"};
 	std::stringstream ss;
@@ -185,9 +192,23 @@ boost::shared_ptr<HMM> Models::createIntronModel(){
 			nodes[i][j] = result->createNode(ss.str());
 			result->addEmission(nodes[i][j],HMMEmission(endings[j],1));
 			result->setConstantEmissions(nodes[i][j],true);
+
+			if(tied){
+				ss.clear();
+				ss.str(std::string());
+				ss << "Intron" << i+1;
+				result->setTransitionTie(nodes[i][j],ss.str());
+			}
 		}
 	}
 
+	if(tied){
+		result->setEmissionTie(absorbing1,"IntronAbsorbing");
+		result->setEmissionTie(absorbing2,"IntronAbsorbing");
+		result->setEmissionTie(absorbing3,"IntronAbsorbing");
+		result->setEmissionTie(absorbing4,"IntronAbsorbing");
+	}
+
 	result->addTransition(absorbing1,HMMTransition(absorbing2,1));
 	result->setConstantTransitions(absorbing1,true);
 
@@ -634,9 +655,9 @@ boost::unordered_map<std::string,std::string> Models::createVeilMapping(){
 	return result;
 }
 
-boost::shared_ptr<HMM> Models::createVeilModel(){
-	boost::shared_ptr<HMM> exonModel = Models::createExonModel();
-	boost::shared_ptr<HMM> intronModel = Models::createIntronModel();
+boost::shared_ptr<HMM> Models::createVeilModel(bool tied){
+	boost::shared_ptr<HMM> exonModel = Models::createExonModel(tied);
+	boost::shared_ptr<HMM> intronModel = Models::createIntronModel(tied);
 	boost::shared_ptr<HMM> upstreamModel = Models::createUpstreamModel();
 	boost::shared_ptr<HMM> downstreamModel = Models::createDownstreamModel();
 	boost::shared_ptr<HMM> acceptorModel = Models::create3SpliceSite();
@@ -728,6 +749,13 @@ void Models::createAnnotatedSubstitution(boost::unordered_map<std::string, boost
 
 void Models::createInverseAnnotatedSubstitution(boost::unordered_map<std::string, boost::unordered_map<std::string,std::string> >& inverseSubstitution){
 	boost::unordered_map<std::string, std::string> iSubstitution;
+
+	createInverseAnnotatedSymbolMap(iSubstitution);
+
+	inverseSubstitution.emplace(".*",iSubstitution);
+}
+
+void Models::createInverseAnnotatedSymbolMap(boost::unordered_map<std::string, std::string>& symbolMap){
 	std::string bases[] = { "A", "C", "G", "T" };
 	std::string prefixes[] = { "D", "U", "E", "I" };
 	std::stringstream ss;
@@ -738,11 +766,9 @@ void Models::createInverseAnnotatedSubstitution(boost::unordered_map<std::string
 			ss.clear();
 			ss << prefixes[i] << bases[j];
 
-			iSubstitution.emplace(ss.str(), bases[j]);
+			symbolMap.emplace(ss.str(), bases[j]);
 		}
 	}
-
-	inverseSubstitution.emplace(".*",iSubstitution);
 }
 
 
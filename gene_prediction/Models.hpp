@@ -31,8 +31,14 @@ boost::unordered_map<std::string, std::string> createVeilMapping();
  */
 extern boost::unordered_map<std::string, std::string> veilMapping;
 
-boost::shared_ptr<HMM> createExonModel();
-boost::shared_ptr<HMM> createIntronModel();
+/**
+ * These functions create the exon and intron model. If tied is true, then the
+ * emissions of the absorbing states are tied (see HMM::setEmissionTie). The intron
+ * model additionally ties the transitions of the states of the same codon position,
+ * since an intron is not translated.
+ */
+boost::shared_ptr<HMM> createExonModel(bool tied = false);
+boost::shared_ptr<HMM> createIntronModel(bool tied = false);
 boost::shared_ptr<HMM> createUpstreamModel();
 boost::shared_ptr<HMM> createStartCodon();
 boost::shared_ptr<HMM> create5SpliceSite();
@@ -40,7 +46,11 @@ boost::shared_ptr<HMM> create3SpliceSite();
 boost::shared_ptr<HMM> createDownstreamModel();
 boost::shared_ptr<HMM> create5PolyASite();
 
-boost::shared_ptr<HMM> createVeilModel();
+/**
+ * This function creates the complete VEIL model. If tied is true, then the exon and
+ * intron model are created with tied parameters.
+ */
+boost::shared_ptr<HMM> createVeilModel(bool tied = false);
 
 /**
  * This functions create the substitution for annotated sequences. That is
@@ -62,6 +72,14 @@ void createInverseAnnotatedSubstitution(
 		boost::unordered_map<std::string,
 				boost::unordered_map<std::string, std::string> >& result);
 
+/**
+ * This function creates the symbol map which maps every annotated emission symbol
+ * to its plain base. It is used by HMMCompiled::projectEmissions to reverse
+ * the effect of createAnnotatedSubstitution on a compiled HMM.
+ */
+void createInverseAnnotatedSymbolMap(
+		boost::unordered_map<std::string, std::string>& result);
+
 /**
  * This function takes the individual models of the VEIL model and connects
  * them properly.
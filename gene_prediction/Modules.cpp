@@ -8,7 +8,10 @@
 #include "Modules.hpp"
 
 #include <fstream>
+#include <iostream>
 #include <string>
+#include <stdexcept>
+#include <stdlib.h>
 #include <boost/shared_ptr.hpp>
 
 #include "HMM.hpp"
@@ -21,16 +24,20 @@
 #include "GeneDatabase.hpp"
 #include "Models.hpp"
 #include "Analytics.hpp"
+#include "SequenceSource.hpp"
+#include "PredictionPipeline.hpp"
+#include "IndexedFasta.hpp"
+#include "DPWorkspace.hpp"
+#include "SequenceBatch.hpp"
 
 void Modules::learnCompleteModel() {
 	std::string databaseFilename = "DNASequences.fasta";
 	std::string cdsFilename = "CDS.tbl";
 	GeneDatabase database;
-	std::vector<std::vector<std::string> > trainingset;
+	SequenceBatch trainingset;
 	std::string filename = "completeModel.hmm";
 
-	database.importFile(databaseFilename);
-	database.importCDS(cdsFilename);
+	database.importFiles(databaseFilename, cdsFilename);
 
 	boost::shared_ptr<HMMCompiled> compiled(new HMMCompiled());
 
@@ -46,7 +53,7 @@ void Modules::learnCompleteModel() {
 
 	model->substituteEmissions(substitution);
 
-	model->compile(compiled);
+	model->compile(compiled, true);
 
 	database.extractAnnotatedSequences(trainingset);
 
@@ -70,8 +77,7 @@ void Modules::learnCompleteModel() {
 
 void Modules::learnExonModel() {
 	GeneDatabase database;
-	database.importFile("DNASequences.fasta");
-	database.importCDS("CDS.tbl");
+	database.importFiles("DNASequences.fasta", "CDS.tbl");
 
 	boost::shared_ptr<HMMCompiled> chmm(new HMMCompiled());
 	boost::shared_ptr<HMM> exon = Models::createExonModel();
@@ -118,9 +124,11 @@ void Modules::test2StateToyExample() {
 
 	toy->compile(ctoy);
 
+	HMMCompiled::RandomGenerator random((boost::random::mt19937()));
+
 	for (int i = 0; i < 250; i++) {
 		toyoutput.clear();
-		ctoy->simulate(20, toyoutput, toystates);
+		ctoy->simulate(20, toyoutput, toystates, random);
 
 		toytrainingSet.push_back(toyoutput);
 	}
@@ -176,9 +184,11 @@ void Modules::test3StateToyExample() {
 	std::vector<int> states;
 	std::vector<std::string> output;
 	std::vector<std::vector<std::string> > trainingSet;
+	HMMCompiled::RandomGenerator random((boost::random::mt19937()));
+
 	for (int i = 0; i < 500; i++) {
 		output.clear();
-		compiled->simulate(30, output, states);
+		compiled->simulate(30, output, states, random);
 		trainingSet.push_back(output);
 
 		std::cout << i << ":";
@@ -260,8 +270,7 @@ void Modules::evaluateModel(const std::string& hmmFilename) {
 	std::vector<std::vector<std::string> > sequences;
 	std::vector<std::vector<std::string> > annotations;
 
-	database.importFile(dataFilename);
-	database.importCDS(cdsFilename);
+	database.importFiles(dataFilename, cdsFilename);
 
 	is.open(hmmFilename.c_str(), std::ios_base::in);
 
@@ -270,7 +279,7 @@ void Modules::evaluateModel(const std::string& hmmFilename) {
 
 	is.close();
 
-	hmm->compile(hmmCompiled);
+	hmm->compile(hmmCompiled, true);
 
 	// get test data
 	database.extractSequencesAndAnnotations(sequences, annotations);
@@ -281,6 +290,141 @@ void Modules::evaluateModel(const std::string& hmmFilename) {
 	std::cout << result << std::endl;
 }
 
+void Modules::predictStructure(const std::string& hmmFilename,
+		const std::string& filename, int numberThreads,
+		const std::vector<std::string>& regions) {
+	std::ifstream is;
+	boost::shared_ptr<HMM> hmm(new HMM());
+	boost::shared_ptr<HMMCompiled> hmmCompiled(new HMMCompiled());
+
+	is.open(hmmFilename.c_str(), std::ios_base::in);
+
+	// read HMM
+	HMM::deserialize(is, hmm);
+
+	is.close();
+
+	hmm->compile(hmmCompiled, true);
+
+	// the pipeline reports the structure labels of the decoded states. The decoding
+	// uses the original model since HMMCompiled::minimize does not keep the Viterbi path.
+	hmmCompiled->setStateLabels(Models::veilMapping);
+
+	PredictionPipeline pipeline(hmmCompiled, numberThreads);
+
+	if (regions.empty()) {
+		FastaSequenceSource source(filename);
+
+		pipeline.run(source, std::cout);
+		return;
+	}
+
+	IndexedFasta fasta;
+	std::vector<IndexedFasta::Region> parsedRegions;
+
+	try {
+		if (!fasta.open(filename, numberThreads)) {
+			std::cerr << "Could not open file:" << filename << std::endl;
+			exit(1);
+		}
+	} catch (std::exception& e) {
+		std::cerr << "Could not index file:" << filename << std::endl;
+		std::cerr << e.what() << std::endl;
+		exit(1);
+	}
+
+	for (std::vector<std::string>::const_iterator it = regions.begin();
+			it != regions.end(); ++it) {
+		int k = -1;
+
+		try {
+			parsedRegions.push_back(IndexedFasta::parseRegion(*it));
+			k = fasta.find(parsedRegions.back()._name);
+		} catch (std::invalid_argument& e) {
+		}
+
+		if (k < 0 || parsedRegions.back()._begin > fasta.getRecord(k)._length) {
+			std::cerr << "Invalid region:" << *it << std::endl;
+			exit(1);
+		}
+	}
+
+	pipeline.run(fasta, parsedRegions, std::cout);
+}
+
+void Modules::pruneModel(const std::string& hmmFilename,
+		const std::string& validationFilename,
+		const std::string& validationCDSFilename, double threshold) {
+	GeneDatabase database;
+	std::string prunedFilename = "prunedModel.hmm";
+	std::ifstream is;
+	std::ofstream os;
+	boost::shared_ptr<HMM> hmm(new HMM());
+	boost::shared_ptr<HMMCompiled> original(new HMMCompiled());
+	boost::shared_ptr<HMMCompiled> pruned(new HMMCompiled());
+	std::vector<std::vector<std::string> > sequences;
+	std::vector<std::vector<std::string> > annotations;
+	DPWorkspace workspace;
+	double originalLikelihood = 0;
+	double prunedLikelihood = 0;
+	int lostSequences = 0;
+
+	database.importFiles(validationFilename, validationCDSFilename);
+
+	is.open(hmmFilename.c_str(), std::ios_base::in);
+
+	HMM::deserialize(is, hmm);
+
+	is.close();
+
+	int nodes = hmm->size();
+	int transitions = hmm->numTransitions();
+
+	hmm->compile(original, true);
+	hmm->prune(threshold);
+	hmm->compile(pruned, true);
+
+	database.extractSequencesAndAnnotations(sequences, annotations);
+
+	// sequences which the pruned model cannot emit any more are counted separately,
+	// otherwise the loss would be infinite
+	for (std::vector<std::vector<std::string> >::const_iterator it =
+			sequences.begin(); it != sequences.end(); ++it) {
+		double before = original->forward(*it, workspace);
+		double after = pruned->forward(*it, workspace);
+
+		if (before == -std::numeric_limits<double>::infinity()) {
+			continue;
+		}
+
+		if (after == -std::numeric_limits<double>::infinity()) {
+			lostSequences++;
+		} else {
+			originalLikelihood += before;
+			prunedLikelihood += after;
+		}
+	}
+
+	std::cout << "Nodes:" << nodes << " -> " << hmm->size() << std::endl;
+	std::cout << "Transitions:" << transitions << " -> "
+			<< hmm->numTransitions() << std::endl;
+	std::cout << "Log-likelihood loss:"
+			<< originalLikelihood - prunedLikelihood << std::endl;
+	std::cout << "Sequences which cannot be emitted any more:"
+			<< lostSequences << std::endl;
+
+	Analytics::AnalyticsResult result = Analytics::analyse(pruned, sequences,
+			annotations);
+
+	std::cout << result << std::endl;
+
+	os.open(prunedFilename.c_str(), std::ios_base::out);
+
+	hmm->serialize(os);
+
+	os.close();
+}
+
 void Modules::learnAndEvaluateModel(const std::string& prefix) {
 	GeneDatabase database;
 	std::string dataFilename = "DNASequences.fasta";
@@ -288,8 +432,7 @@ void Modules::learnAndEvaluateModel(const std::string& prefix) {
 	std::vector<DatabaseEntry*> entries;
 	boost::shared_ptr<HMM> hmm(new HMM());
 
-	database.importFile(dataFilename);
-	database.importCDS(cdsFilename);
+	database.importFiles(dataFilename, cdsFilename);
 
 	database.extractDatabaseEntries(entries);
 
@@ -298,3 +441,26 @@ void Modules::learnAndEvaluateModel(const std::string& prefix) {
 	CrossValidation::modelLearning(prefix, hmm, entries, 114, 1, "Threshold",
 			0.01, true);
 }
+
+void Modules::learnModelOnline(const std::string& filename) {
+	std::string modelFilename = "onlineModel.hmm";
+	FastaSequenceSource source(filename);
+	boost::shared_ptr<HMM> hmm = Models::createVeilModel();
+	boost::shared_ptr<HMMCompiled> compiled(new HMMCompiled());
+	std::ofstream os;
+
+	HMMCompiled::RandomGenerator random((boost::random::mt19937()));
+
+	hmm->compile(compiled);
+	compiled->initProbabilities(random);
+
+	compiled->onlineBaumWelch(hmm, source, 20, 3, 0.7, 10, modelFilename);
+
+	hmm->update(compiled);
+
+	os.open(modelFilename.c_str(), std::ios_base::out);
+
+	hmm->serialize(os);
+
+	os.close();
+}
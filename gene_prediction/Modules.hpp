@@ -9,6 +9,7 @@
 #define MODULES_HPP_
 
 #include <string>
+#include <vector>
 
 /**
  * This class encapsulates different tasks which the program supports
@@ -38,6 +39,45 @@ void learnExonModel();
  */
 void evaluateModel(const std::string & hmmFilename);
 
+/**
+ * This function predicts the DNA structure of the sequences found in the fasta file
+ * filename with the HMM stored in hmmFilename. The records are streamed through a
+ * PredictionPipeline, thus reading, decoding and output overlap and only the records
+ * in flight are kept in memory. For every run of equal structure labels one line with
+ * the identifier, the first and last position and the label is printed to stdout.
+ *
+ * @argument hmmFilename string to file containing the HMM
+ * @argument filename fasta file containing the DNA sequences
+ * @argument numberThreads number of decoding threads, one per hardware thread if it is
+ * 		not positive
+ * @argument regions if not empty, only these regions in the notation of samtools faidx
+ * 		(see IndexedFasta::parseRegion) are decoded. They are fetched by the faidx index
+ * 		of filename, which is built if it does not exist, thus only the blocks of a file
+ * 		compressed by bgzip which contain a region are decompressed.
+ */
+void predictStructure(const std::string& hmmFilename,
+		const std::string& filename = "DNASequences.fasta",
+		int numberThreads = 0,
+		const std::vector<std::string>& regions = std::vector<std::string>());
+
+/**
+ * This function removes the negligible transitions and the unreachable and dead
+ * states (see HMM::prune) of the HMM stored in hmmFilename. The DNA sequences of
+ * the validation files, which must not have been used to learn the HMM, are used
+ * to compute the log-likelihood loss and the prediction accuracy of the pruned
+ * model, which are printed to stdout. The pruned model is written to
+ * "prunedModel.hmm".
+ *
+ * @argument hmmFilename string to file containing the learned HMM
+ * @argument validationFilename fasta file containing the validation sequences
+ * @argument validationCDSFilename CDS file containing the exons of the validation
+ * 		sequences
+ * @argument threshold transitions with a smaller probability are removed
+ */
+void pruneModel(const std::string& hmmFilename,
+		const std::string& validationFilename,
+		const std::string& validationCDSFilename, double threshold = 1e-4);
+
 /**
  * This function learns the complete VEIL model from the set of DNA sequences
  * found in "DNASequences.fasta". For that purpose it splits the set of
@@ -48,6 +88,17 @@ void evaluateModel(const std::string & hmmFilename);
  */
 void learnAndEvaluateModel(const std::string& prefix = "");
 
+/**
+ * This function learns the complete VEIL model from the plain DNA sequences
+ * found in the fasta file filename by the online EM algorithm. The sequences
+ * are streamed from the file in mini-batches, thus the file does not have to
+ * fit into memory. Every 10 mini-batches the current model is written to
+ * "onlineModel.hmm" and at the end the learned model is stored there, too.
+ *
+ * @argument filename fasta file containing the training sequences
+ */
+void learnModelOnline(const std::string& filename = "DNASequences.fasta");
+
 /**
  * This function runs a 2 state toy example to see whether the learning
  * algorithm can correctly learn the HMM. For that purpose, a HMM is defined
@@ -0,0 +1,268 @@
+/*
+ * PackedSequence.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "PackedSequence.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+
+#include "MappedFile.hpp"
+
+namespace {
+/**
+ * Sets of bases of the IUPAC nucleotide codes, indexed by the character.
+ */
+struct IUPACTable {
+	uint8_t _sets[256];
+	// code of the base of an unambiguous code, 0xff otherwise
+	uint8_t _bases[256];
+
+	IUPACTable() {
+		const char* codes = "ACGTURYSWKMBDHVN";
+		// A=1, C=2, G=4, T=8
+		const uint8_t sets[] = { 1, 2, 4, 8, 8, 5, 10, 6, 9, 12, 3, 14, 13, 11,
+				7, 15 };
+
+		for (int c = 0; c < 256; c++) {
+			_sets[c] = 0;
+		}
+
+		for (int i = 0; codes[i] != 0; i++) {
+			_sets[(unsigned char) codes[i]] = sets[i];
+			// soft-masked bases
+			_sets[(unsigned char) (codes[i] - 'A' + 'a')] = sets[i];
+		}
+
+		for (int c = 0; c < 256; c++) {
+			switch (_sets[c]) {
+			case 1:
+				_bases[c] = 0;
+				break;
+			case 2:
+				_bases[c] = 1;
+				break;
+			case 4:
+				_bases[c] = 2;
+				break;
+			case 8:
+				_bases[c] = 3;
+				break;
+			default:
+				_bases[c] = 0xff;
+			}
+		}
+	}
+};
+
+const IUPACTable iupacTable;
+
+const std::string symbols[] = { "A", "C", "G", "T" };
+
+/**
+ * Appends the bits 0,...,otherBits-1 of other to the bits 0,...,bits-1 of bytes. Bit i is
+ * stored in the bit i%8 of the byte i/8 and the unused bits of the last bytes are 0.
+ */
+void appendBits(std::vector<uint8_t>& bytes, std::size_t bits,
+		const uint8_t* other, std::size_t otherBits) {
+	std::size_t position = bits / 8;
+	std::size_t otherBytes = (otherBits + 7) / 8;
+	int shift = bits & 7;
+
+	bytes.resize((bits + otherBits + 7) / 8, 0);
+
+	if (shift == 0) {
+		std::copy(other, other + otherBytes, bytes.begin() + position);
+		return;
+	}
+
+	for (std::size_t i = 0; i < otherBytes; i++) {
+		bytes[position + i] |= other[i] << shift;
+
+		if (position + i + 1 < bytes.size()) {
+			bytes[position + i + 1] |= other[i] >> (8 - shift);
+		}
+	}
+}
+}
+
+PackedSequence::PackedSequence() :
+		_size(0), _basesData(NULL), _ambiguousData(NULL) {
+}
+
+PackedSequence::PackedSequence(const PackedSequence& other) :
+		_bases(other._bases), _ambiguous(other._ambiguous), _size(other._size), _basesData(
+				other._basesData), _ambiguousData(other._ambiguousData), _mapping(
+				other._mapping) {
+	if (!_mapping) {
+		refresh();
+	}
+}
+
+PackedSequence::PackedSequence(boost::shared_ptr<const MappedFile> mapping,
+		const uint8_t* bases, const uint8_t* ambiguous, int size) :
+		_size(size), _basesData(bases), _ambiguousData(ambiguous), _mapping(
+				mapping) {
+}
+
+PackedSequence& PackedSequence::operator=(const PackedSequence& other) {
+	PackedSequence copy(other);
+
+	swap(copy);
+
+	return *this;
+}
+
+PackedSequence::PackedSequence(const std::string& data,
+		RandomGenerator& random) :
+		_size(0), _basesData(NULL), _ambiguousData(NULL) {
+	reserve(data.size());
+
+	for (std::string::const_iterator it = data.begin(); it != data.end();
+			++it) {
+		append(*it, random);
+	}
+}
+
+void PackedSequence::refresh() {
+	_basesData = _bases.empty() ? NULL : &_bases[0];
+	_ambiguousData = _ambiguous.empty() ? NULL : &_ambiguous[0];
+}
+
+void PackedSequence::detach() {
+	if (!_mapping) {
+		return;
+	}
+
+	_bases.assign(_basesData, _basesData + (_size + 3) / 4);
+	_ambiguous.assign(_ambiguousData, _ambiguousData + (_size + 7) / 8);
+	_mapping.reset();
+	refresh();
+}
+
+void PackedSequence::reserve(int size) {
+	detach();
+	_bases.reserve((size + 3) / 4);
+	_ambiguous.reserve((size + 7) / 8);
+	refresh();
+}
+
+void PackedSequence::append(char code, RandomGenerator& random) {
+	uint8_t set = iupacTable._sets[(unsigned char) code];
+	uint8_t base = 0;
+	bool ambiguous = false;
+
+	switch (set) {
+	case 0:
+		throw std::invalid_argument(
+				std::string("PackedSequence: Invalid nucleotide code ") + code
+						+ ".");
+	case 1:
+		base = 0;
+		break;
+	case 2:
+		base = 1;
+		break;
+	case 4:
+		base = 2;
+		break;
+	case 8:
+		base = 3;
+		break;
+	default: {
+		// choose one of the represented bases with the same probability
+		int number = 0;
+
+		for (int b = 0; b < 4; b++) {
+			number += (set >> b) & 1;
+		}
+
+		int k = (int) (number * random());
+
+		for (base = 0; base < 4; base++) {
+			if ((set >> base) & 1) {
+				if (k == 0) {
+					break;
+				}
+
+				k--;
+			}
+		}
+
+		ambiguous = true;
+	}
+	}
+
+	push(base, ambiguous);
+}
+
+void PackedSequence::append(const char* begin, const char* end,
+		RandomGenerator& random) {
+	for (const char* it = begin; it != end; ++it) {
+		uint8_t base = iupacTable._bases[(unsigned char) *it];
+
+		if (base != 0xff) {
+			push(base, false);
+		} else if (!std::isspace((unsigned char) *it)) {
+			// ambiguity code or invalid code
+			append(*it, random);
+		}
+	}
+}
+
+void PackedSequence::append(const PackedSequence& other) {
+	// appendBits reallocates _bases while it reads the bases of other
+	if (&other == this) {
+		PackedSequence copy(other);
+		append(copy);
+		return;
+	}
+
+	detach();
+	appendBits(_bases, 2 * (std::size_t) _size, other._basesData,
+			2 * (std::size_t) other._size);
+	appendBits(_ambiguous, _size, other._ambiguousData, other._size);
+	_size += other._size;
+	refresh();
+}
+
+void PackedSequence::swap(PackedSequence& other) {
+	_bases.swap(other._bases);
+	_ambiguous.swap(other._ambiguous);
+	std::swap(_size, other._size);
+	std::swap(_basesData, other._basesData);
+	std::swap(_ambiguousData, other._ambiguousData);
+	_mapping.swap(other._mapping);
+}
+
+void PackedSequence::decode(int begin, int end,
+		std::vector<std::string>& result) const {
+	result.reserve(result.size() + end - begin);
+
+	for (int i = begin; i < end; i++) {
+		result.push_back(symbols[(*this)[i]]);
+	}
+}
+
+void PackedSequence::encode(const int* table, int begin, int end,
+		int* result) const {
+	for (int i = begin; i < end; i++) {
+		result[i - begin] = table[(*this)[i]];
+	}
+}
+
+std::size_t PackedSequence::getMemoryUsage() const {
+	return _bases.capacity() + _ambiguous.capacity();
+}
+
+const std::string& PackedSequence::getSymbol(uint8_t base) {
+	return symbols[base];
+}
+
+uint8_t PackedSequence::getBaseSet(char code) {
+	return iupacTable._sets[(unsigned char) code];
+}
@@ -0,0 +1,306 @@
+/*
+ * PackedSequence.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef PACKEDSEQUENCE_HPP_
+#define PACKEDSEQUENCE_HPP_
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <stdint.h>
+
+#include <boost/random.hpp>
+#include <boost/shared_ptr.hpp>
+
+class MappedFile;
+
+/**
+ * This class stores a DNA sequence with 2 bits per base (A=0, C=1, G=2, T=3). Ambiguity
+ * codes of the IUPAC alphabet (e.g. N, R, Y) are instantiated with a random base which
+ * they represent when they are appended, and a side bitmap marks their positions. Lower
+ * case (soft-masked) bases are treated like upper case ones.
+ *
+ * A sequence can also reference packed bytes in a mapped file (e.g. a database cache), which
+ * it keeps mapped. Those bytes are copied when the sequence is changed for the first time.
+ */
+class PackedSequence {
+public:
+	typedef boost::random::uniform_01<boost::random::mt19937> RandomGenerator;
+
+	/**
+	 * Random access iterator over the base codes of a sequence.
+	 */
+	class const_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef uint8_t value_type;
+		typedef int difference_type;
+		typedef const uint8_t* pointer;
+		typedef uint8_t reference;
+
+	private:
+		const PackedSequence* _sequence;
+		int _position;
+
+	public:
+		const_iterator() :
+				_sequence(0), _position(0) {
+		}
+
+		const_iterator(const PackedSequence* sequence, int position) :
+				_sequence(sequence), _position(position) {
+		}
+
+		uint8_t operator*() const {
+			return (*_sequence)[_position];
+		}
+
+		uint8_t operator[](int n) const {
+			return (*_sequence)[_position + n];
+		}
+
+		const_iterator& operator++() {
+			++_position;
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator result = *this;
+			++_position;
+			return result;
+		}
+
+		const_iterator& operator--() {
+			--_position;
+			return *this;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator result = *this;
+			--_position;
+			return result;
+		}
+
+		const_iterator& operator+=(int n) {
+			_position += n;
+			return *this;
+		}
+
+		const_iterator& operator-=(int n) {
+			_position -= n;
+			return *this;
+		}
+
+		const_iterator operator+(int n) const {
+			return const_iterator(_sequence, _position + n);
+		}
+
+		const_iterator operator-(int n) const {
+			return const_iterator(_sequence, _position - n);
+		}
+
+		int operator-(const const_iterator& ref) const {
+			return _position - ref._position;
+		}
+
+		bool operator==(const const_iterator& ref) const {
+			return _position == ref._position;
+		}
+
+		bool operator!=(const const_iterator& ref) const {
+			return _position != ref._position;
+		}
+
+		bool operator<(const const_iterator& ref) const {
+			return _position < ref._position;
+		}
+
+		bool operator>(const const_iterator& ref) const {
+			return _position > ref._position;
+		}
+
+		bool operator<=(const const_iterator& ref) const {
+			return _position <= ref._position;
+		}
+
+		bool operator>=(const const_iterator& ref) const {
+			return _position >= ref._position;
+		}
+	};
+
+private:
+	// 4 bases per byte, the base i is stored in the bits 2*(i%4) and 2*(i%4)+1 of the
+	// byte i/4
+	std::vector<uint8_t> _bases;
+	// bit i%8 of the byte i/8 is set if the base i was an ambiguity code
+	std::vector<uint8_t> _ambiguous;
+	int _size;
+	// packed bytes which are read: the ones of _bases and _ambiguous or the ones of _mapping
+	const uint8_t* _basesData;
+	const uint8_t* _ambiguousData;
+	// NULL if the bytes are stored in _bases and _ambiguous
+	boost::shared_ptr<const MappedFile> _mapping;
+
+	/**
+	 * Points _basesData and _ambiguousData to the bytes of _bases and _ambiguous.
+	 */
+	void refresh();
+
+	/**
+	 * Copies the bytes of the mapped file, thus the sequence can be changed.
+	 */
+	void detach();
+
+	/**
+	 * Appends the base with the code base and marks it as ambiguous if ambiguous is true.
+	 */
+	void push(uint8_t base, bool ambiguous) {
+		if (_mapping) {
+			detach();
+		}
+
+		if ((_size & 3) == 0) {
+			_bases.push_back(0);
+			_basesData = &_bases[0];
+		}
+
+		if ((_size & 7) == 0) {
+			_ambiguous.push_back(0);
+			_ambiguousData = &_ambiguous[0];
+		}
+
+		_bases.back() |= base << ((_size & 3) << 1);
+
+		if (ambiguous) {
+			_ambiguous.back() |= 1 << (_size & 7);
+		}
+
+		_size++;
+	}
+
+public:
+	PackedSequence();
+	PackedSequence(const PackedSequence& other);
+
+	/**
+	 * References size packed bases in the memory of mapping. bases and ambiguous have the
+	 * layout of getPackedBases and getPackedAmbiguous.
+	 */
+	PackedSequence(boost::shared_ptr<const MappedFile> mapping,
+			const uint8_t* bases, const uint8_t* ambiguous, int size);
+
+	PackedSequence& operator=(const PackedSequence& other);
+
+	/**
+	 * Packs the nucleotide codes of data. Ambiguity codes are instantiated by random.
+	 */
+	PackedSequence(const std::string& data, RandomGenerator& random);
+
+	/**
+	 * Appends the base with the IUPAC code code. If it is an ambiguity code, then it is
+	 * instantiated by random. An invalid code causes a std::invalid_argument.
+	 */
+	void append(char code, RandomGenerator& random);
+
+	/**
+	 * Appends the bases of the IUPAC codes begin,...,end-1 like append. Whitespace
+	 * characters (e.g. the line breaks of a fasta file) are skipped.
+	 */
+	void append(const char* begin, const char* end, RandomGenerator& random);
+
+	/**
+	 * Appends the bases of other. The packed bytes are shifted as a whole, thus the bases
+	 * are not unpacked. other may be this sequence.
+	 */
+	void append(const PackedSequence& other);
+
+	/**
+	 * Exchanges the bases of this sequence and of other.
+	 */
+	void swap(PackedSequence& other);
+
+	void reserve(int size);
+
+	int size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	/**
+	 * Returns the code (0-3) of the base at position.
+	 */
+	uint8_t operator[](int position) const {
+		return (_basesData[position >> 2] >> ((position & 3) << 1)) & 3;
+	}
+
+	/**
+	 * Returns true if the base at position was given as an ambiguity code.
+	 */
+	bool isAmbiguous(int position) const {
+		return (_ambiguousData[position >> 3] >> (position & 7)) & 1;
+	}
+
+	/**
+	 * Returns the (size()+3)/4 bytes of the bases. The base i is stored in the bits
+	 * 2*(i%4) and 2*(i%4)+1 of the byte i/4, unused bits are 0.
+	 */
+	const uint8_t* getPackedBases() const {
+		return _basesData;
+	}
+
+	/**
+	 * Returns the (size()+7)/8 bytes of the ambiguity bitmap. The bit i%8 of the byte i/8
+	 * is set if the base i was an ambiguity code.
+	 */
+	const uint8_t* getPackedAmbiguous() const {
+		return _ambiguousData;
+	}
+
+	const_iterator begin() const {
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const {
+		return const_iterator(this, _size);
+	}
+
+	/**
+	 * Appends the symbols ("A", "C", "G", "T") of the bases begin,...,end-1 to symbols.
+	 */
+	void decode(int begin, int end, std::vector<std::string>& symbols) const;
+
+	/**
+	 * Stores table[b] for every base b of the positions begin,...,end-1 in symbols. This
+	 * translates the bases into the symbol ids of a model (see HMMCompiled::encode) without
+	 * creating strings.
+	 *
+	 * @argument table table[b] = symbol id of the base with the code b
+	 */
+	void encode(const int* table, int begin, int end, int* symbols) const;
+
+	/**
+	 * Returns the number of bytes which are used to store the bases and the bitmap. Bytes
+	 * of a mapped file are not counted.
+	 */
+	std::size_t getMemoryUsage() const;
+
+	/**
+	 * Returns the symbol of the base with the code base.
+	 */
+	static const std::string& getSymbol(uint8_t base);
+
+	/**
+	 * Returns the set of bases which the IUPAC code code represents: bit b is set if the
+	 * base with the code b is contained. The result is 0 if code is not a valid code.
+	 */
+	static uint8_t getBaseSet(char code);
+};
+
+#endif /* PACKEDSEQUENCE_HPP_ */
@@ -0,0 +1,252 @@
+/*
+ * PredictionPipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "PredictionPipeline.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <boost/bind/bind.hpp>
+
+#include "HMMCompiled.hpp"
+#include "HMMTopology.hpp"
+#include "DPWorkspace.hpp"
+#include "SequenceSource.hpp"
+#include "ThreadPool.hpp"
+
+PredictionPipeline::PredictionPipeline(boost::shared_ptr<HMMCompiled> hmm,
+		int numberThreads, int maxRecords) :
+		_hmm(hmm), _numberThreads(numberThreads), _maxRecords(maxRecords), _taken(
+				0), _finished(false) {
+	if (_numberThreads <= 0) {
+		_numberThreads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	if (_maxRecords <= 0) {
+		_maxRecords = 2 * _numberThreads;
+	}
+}
+
+void PredictionPipeline::fail(const std::string& error) {
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+
+		if (_error.empty()) {
+			_error = error;
+		}
+	}
+
+	_changed.notify_all();
+}
+
+bool PredictionPipeline::readRecord(FastaSequenceSource& source,
+		Record& record) {
+	record._start = 0;
+
+	return source.next(record._id, record._sequence);
+}
+
+bool PredictionPipeline::fetchRegion(const IndexedFasta& fasta,
+		const std::vector<IndexedFasta::Region>& regions, int& next,
+		Record& record) {
+	if (next >= (int) regions.size()) {
+		return false;
+	}
+
+	const IndexedFasta::Region& region = regions[next++];
+	// every region instantiates its ambiguity codes in the same way
+	PackedSequence::RandomGenerator random((boost::random::mt19937()));
+
+	record._id = region._name;
+	record._start = region._begin;
+	fasta.fetch(region, record._sequence, random);
+
+	return true;
+}
+
+void PredictionPipeline::read(const boost::function<bool(Record&)>& next) {
+	try {
+		while (true) {
+			boost::shared_ptr<Record> record(new Record());
+
+			// wait for space before reading, thus at most _maxRecords records are in memory
+			{
+				boost::unique_lock<boost::mutex> lock(_mutex);
+
+				while (_error.empty() && (int) _records.size() >= _maxRecords) {
+					_changed.wait(lock);
+				}
+
+				if (!_error.empty()) {
+					return;
+				}
+			}
+
+			if (!next(*record)) {
+				break;
+			}
+
+			record->_decoded = false;
+
+			{
+				boost::lock_guard<boost::mutex> lock(_mutex);
+				_records.push_back(record);
+			}
+
+			_changed.notify_all();
+		}
+	} catch (const std::exception& e) {
+		fail(e.what());
+		return;
+	}
+
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_finished = true;
+	}
+
+	_changed.notify_all();
+}
+
+void PredictionPipeline::decode() {
+	DPWorkspace workspace;
+
+	while (true) {
+		boost::shared_ptr<Record> record;
+
+		{
+			boost::unique_lock<boost::mutex> lock(_mutex);
+
+			while (_error.empty() && _taken >= (int) _records.size()
+					&& !_finished) {
+				_changed.wait(lock);
+			}
+
+			if (!_error.empty() || _taken >= (int) _records.size()) {
+				return;
+			}
+
+			record = _records[_taken++];
+		}
+
+		try {
+			if (record->_sequence.size() > 0) {
+				_hmm->viterbiLabels(record->_sequence, record->_labels,
+						workspace);
+			}
+		} catch (const std::exception& e) {
+			fail(record->_id + ": " + e.what());
+			return;
+		}
+
+		// States without a label are skipped like in Analytics::analyse.
+		record->_labels.erase(
+				std::remove(record->_labels.begin(), record->_labels.end(),
+						HMMTopology::NO_LABEL), record->_labels.end());
+
+		// the bases are not needed any more
+		PackedSequence().swap(record->_sequence);
+
+		{
+			boost::lock_guard<boost::mutex> lock(_mutex);
+			record->_decoded = true;
+		}
+
+		_changed.notify_all();
+	}
+}
+
+void PredictionPipeline::write(const Record& record, std::ostream& os) const {
+	const std::vector<uint8_t>& labels = record._labels;
+	int begin = 0;
+
+	for (int t = 1; t <= (int) labels.size(); t++) {
+		if (t == (int) labels.size() || labels[t] != labels[begin]) {
+			os << record._id << '\t' << record._start + begin + 1 << '\t'
+					<< record._start + t << '\t'
+					<< _hmm->getLabelName(labels[begin]) << '\n';
+			begin = t;
+		}
+	}
+}
+
+int PredictionPipeline::run(FastaSequenceSource& source, std::ostream& os) {
+	return runRecords(
+			boost::bind(&PredictionPipeline::readRecord, boost::ref(source),
+					boost::placeholders::_1), os);
+}
+
+int PredictionPipeline::run(const IndexedFasta& fasta,
+		const std::vector<IndexedFasta::Region>& regions, std::ostream& os) {
+	int next = 0;
+
+	return runRecords(
+			boost::bind(&PredictionPipeline::fetchRegion, boost::cref(fasta),
+					boost::cref(regions), boost::ref(next),
+					boost::placeholders::_1), os);
+}
+
+int PredictionPipeline::runRecords(
+		const boost::function<bool(Record&)>& next, std::ostream& os) {
+	int written = 0;
+
+	_records.clear();
+	_taken = 0;
+	_finished = false;
+	_error = "";
+
+	{
+		ThreadPool pool(_numberThreads + 1);
+		ThreadPool::Batch batch;
+
+		pool.schedule(batch,
+				boost::bind(&PredictionPipeline::read, this, boost::cref(next)));
+
+		for (int i = 0; i < _numberThreads; i++) {
+			pool.schedule(batch, boost::bind(&PredictionPipeline::decode, this));
+		}
+
+		// write the records in the order of the file as soon as they are decoded
+		while (true) {
+			boost::shared_ptr<Record> record;
+
+			{
+				boost::unique_lock<boost::mutex> lock(_mutex);
+
+				while (_error.empty()
+						&& (_records.empty() ?
+								!_finished : !_records.front()->_decoded)) {
+					_changed.wait(lock);
+				}
+
+				if (!_error.empty() || _records.empty()) {
+					break;
+				}
+
+				record = _records.front();
+				_records.pop_front();
+				_taken--;
+			}
+
+			_changed.notify_all();
+
+			write(*record, os);
+			written++;
+		}
+
+		batch.wait();
+	}
+
+	_records.clear();
+
+	if (!_error.empty()) {
+		throw std::runtime_error("PredictionPipeline: " + _error);
+	}
+
+	os.flush();
+
+	return written;
+}
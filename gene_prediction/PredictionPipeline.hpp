@@ -0,0 +1,125 @@
+/*
+ * PredictionPipeline.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef PREDICTIONPIPELINE_HPP_
+#define PREDICTIONPIPELINE_HPP_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+
+#include "PackedSequence.hpp"
+#include "IndexedFasta.hpp"
+
+class HMMCompiled;
+class FastaSequenceSource;
+
+/**
+ * This class predicts the structure of the records of a fasta file while it is read. One
+ * thread reads the records from a FastaSequenceSource or fetches regions of them from an
+ * IndexedFasta, several threads decode them by
+ * HMMCompiled::viterbiLabels and the calling thread writes the predicted structure in the
+ * order of the file. At most maxRecords records are in flight, i.e. read but not yet
+ * written, thus the memory usage does not depend on the number of records of the file.
+ */
+class PredictionPipeline: boost::noncopyable {
+private:
+	struct Record {
+		std::string _id;
+		// position of the first base in the record, which is not 0 for a region
+		int64_t _start;
+		PackedSequence _sequence;
+		std::vector<uint8_t> _labels;
+		bool _decoded;
+	};
+
+	boost::shared_ptr<HMMCompiled> _hmm;
+	int _numberThreads;
+	int _maxRecords;
+
+	// records which have been read but not yet written in the order of the file
+	std::deque<boost::shared_ptr<Record> > _records;
+	// number of records of _records which have been taken by a decoder
+	int _taken;
+	bool _finished;
+	// message of the first error, which stops the pipeline
+	std::string _error;
+	boost::mutex _mutex;
+	boost::condition_variable _changed;
+
+	/**
+	 * Reads the records by next, which returns false if there is no record left.
+	 */
+	void read(const boost::function<bool(Record&)>& next);
+	void decode();
+
+	static bool readRecord(FastaSequenceSource& source, Record& record);
+
+	/**
+	 * Fetches the region next of regions and increments next.
+	 */
+	static bool fetchRegion(const IndexedFasta& fasta,
+			const std::vector<IndexedFasta::Region>& regions, int& next,
+			Record& record);
+
+	/**
+	 * Runs the pipeline for the records which are read by next (see run).
+	 */
+	int runRecords(const boost::function<bool(Record&)>& next,
+			std::ostream& os);
+
+	/**
+	 * Stops the pipeline because of error. Only the first error is kept.
+	 */
+	void fail(const std::string& error);
+
+	/**
+	 * Writes the runs of equal labels of record to os.
+	 */
+	void write(const Record& record, std::ostream& os) const;
+
+public:
+	/**
+	 * @argument hmm HMM with state labels (see HMMCompiled::setStateLabels)
+	 * @argument numberThreads number of decoding threads. If it is not positive, then one
+	 * 		thread per hardware thread is used.
+	 * @argument maxRecords maximum number of records in flight. If it is not positive,
+	 * 		then twice the number of decoding threads is used.
+	 */
+	PredictionPipeline(boost::shared_ptr<HMMCompiled> hmm, int numberThreads = 0,
+			int maxRecords = 0);
+
+	/**
+	 * Decodes all records of source and writes one line per run of equal structure labels
+	 * to os: the identifier of the record, the first and the last position of the run
+	 * (starting at 1) and the name of the label, separated by tabs. The records are
+	 * written in the order of source. If a record cannot be read or decoded, then a
+	 * std::runtime_error is thrown after the pipeline has stopped.
+	 *
+	 * @return number of decoded records
+	 */
+	int run(FastaSequenceSource& source, std::ostream& os);
+
+	/**
+	 * Decodes the regions of fasta like run. Only the blocks of a compressed file which
+	 * contain a region are read. The positions are written relative to the start of the
+	 * record and the identifier is the name of the record.
+	 *
+	 * @return number of decoded regions
+	 */
+	int run(const IndexedFasta& fasta,
+			const std::vector<IndexedFasta::Region>& regions, std::ostream& os);
+};
+
+#endif /* PREDICTIONPIPELINE_HPP_ */
@@ -0,0 +1,221 @@
+/*
+ * RestartScheduler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "RestartScheduler.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
+
+#include "HMMCompiled.hpp"
+#include "ThreadPool.hpp"
+#include "Analytics.hpp"
+#include "Pair.hpp"
+#include "DPWorkspace.hpp"
+
+RestartScheduler::RestartScheduler(ThreadPool& pool, int roundIterations,
+		double keepFraction) :
+		_pool(pool), _roundIterations(roundIterations), _keepFraction(
+				keepFraction) {
+	if (roundIterations <= 0) {
+		throw std::invalid_argument(
+				"RestartScheduler: The number of iterations per round has to be positive.");
+	}
+
+	if (keepFraction <= 0 || keepFraction > 1) {
+		throw std::invalid_argument(
+				"RestartScheduler: The keep fraction has to be in (0,1].");
+	}
+}
+
+void RestartScheduler::learnRound(boost::shared_ptr<HMMCompiled> hmm,
+		const EncodedSequences& trainingset,
+		const std::vector<std::vector<uint8_t> >* labels, double threshold,
+		char* initialRun, char* converged) const {
+	for (int k = 0; k < _roundIterations; k++) {
+		double maxDiff = hmm->baumWelchStep(trainingset, labels, *initialRun);
+		*initialRun = false;
+
+		if (maxDiff <= threshold) {
+			*converged = true;
+			break;
+		}
+	}
+}
+
+void RestartScheduler::scoreHMM(boost::shared_ptr<HMMCompiled> hmm,
+		const ScoreFunction& score, double* result) {
+	*result = score(hmm);
+
+	if (*result != *result) {
+		*result = -std::numeric_limits<double>::infinity();
+	}
+}
+
+int RestartScheduler::learn(
+		const std::vector<boost::shared_ptr<HMMCompiled> >& tries,
+		std::vector<bool>& active,
+		const std::vector<std::vector<std::string> >& trainingset,
+		const std::vector<std::vector<std::string> >* labels, double threshold,
+		const ScoreFunction& score, std::vector<double>& scores) {
+	SequenceBatch batch(trainingset);
+
+	return learn(tries, active, SequenceBatch::View(batch), labels, threshold,
+			score, scores);
+}
+
+int RestartScheduler::learn(
+		const std::vector<boost::shared_ptr<HMMCompiled> >& tries,
+		std::vector<bool>& active, const EncodedSequences& trainingset,
+		const std::vector<std::vector<std::string> >* labels, double threshold,
+		const ScoreFunction& score, std::vector<double>& scores) {
+	// char instead of bool, because the jobs write concurrently to different elements
+	std::vector<char> initialRun(tries.size(), true);
+	std::vector<char> converged(tries.size(), false);
+	std::vector<int> remaining;
+	int round = 0;
+
+	scores.resize(tries.size(), -std::numeric_limits<double>::infinity());
+
+	for (int j = 0; j < tries.size(); j++) {
+		if (active[j]) {
+			remaining.push_back(j);
+		}
+	}
+
+	if (remaining.empty()) {
+		throw std::invalid_argument("RestartScheduler: There is no active try.");
+	}
+
+	// the labels are encoded once for all rounds. The tries share the structure of their
+	// model, thus their label codes are equal.
+	std::vector<std::vector<uint8_t> > labelCodes;
+	const std::vector<std::vector<uint8_t> >* codes = NULL;
+
+	if (labels != NULL) {
+		tries[remaining[0]]->encodeLabels(*labels, labelCodes);
+		codes = &labelCodes;
+	}
+
+	while (true) {
+		ThreadPool::Batch learning;
+		ThreadPool::Batch scoring;
+		std::vector<int> learned;
+		bool finished = true;
+
+		for (std::vector<int>::const_iterator it = remaining.begin();
+				it != remaining.end(); ++it) {
+			if (!converged[*it]) {
+				learned.push_back(*it);
+				_pool.schedule(learning,
+						boost::bind(&RestartScheduler::learnRound, this,
+								tries[*it], boost::cref(trainingset), codes,
+								threshold, &initialRun[*it], &converged[*it]));
+			}
+		}
+
+		learning.wait();
+
+		// the scores of tries which had already converged are still valid
+		for (std::vector<int>::const_iterator it = learned.begin();
+				it != learned.end(); ++it) {
+			_pool.schedule(scoring,
+					boost::bind(&RestartScheduler::scoreHMM, tries[*it],
+							boost::cref(score), &scores[*it]));
+		}
+
+		for (std::vector<int>::const_iterator it = remaining.begin();
+				it != remaining.end(); ++it) {
+			finished = finished && converged[*it];
+		}
+
+		scoring.wait();
+		round++;
+
+		if (finished) {
+			break;
+		}
+
+		// keep the best tries
+		if (remaining.size() > 1) {
+			std::vector<Pair<double> > ranking;
+
+			for (std::vector<int>::const_iterator it = remaining.begin();
+					it != remaining.end(); ++it) {
+				ranking.push_back(Pair<double>(scores[*it], *it));
+			}
+
+			std::sort(ranking.begin(), ranking.end(),
+					std::greater<Pair<double> >());
+
+			int keep = std::max(1,
+					(int) std::ceil(_keepFraction * remaining.size()));
+
+			remaining.clear();
+
+			for (int k = 0; k < ranking.size(); k++) {
+				int index = (int) ranking[k]._second;
+
+				if (k < keep) {
+					remaining.push_back(index);
+				} else {
+					active[index] = false;
+
+					std::cout << "Round:" << round << " culled try:" << index
+							<< " score:"
+							<< ranking[k]._first << std::endl;
+				}
+			}
+		}
+	}
+
+	int best = remaining[0];
+
+	for (std::vector<int>::const_iterator it = remaining.begin();
+			it != remaining.end(); ++it) {
+		if (scores[*it] > scores[best]) {
+			best = *it;
+		}
+	}
+
+	return best;
+}
+
+double RestartScheduler::likelihoodScore(boost::shared_ptr<HMMCompiled> hmm,
+		const SequenceBatch::View& set) {
+	DPWorkspace workspace;
+	double result = 0;
+
+	for (int k = 0; k < set.size(); k++) {
+		double prob = hmm->forward(set[k], workspace);
+
+		if (prob != -std::numeric_limits<double>::infinity())
+			result += prob;
+	}
+
+	return result;
+}
+
+double RestartScheduler::evaluationScore(boost::shared_ptr<HMMCompiled> hmm,
+		const boost::unordered_map<std::string, std::string>* symbolMap,
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations) {
+	if (symbolMap != NULL) {
+		boost::shared_ptr<HMMCompiled> projected(new HMMCompiled());
+		hmm->projectEmissions(*symbolMap, projected);
+
+		return Analytics::evaluate(
+				Analytics::analyse(projected, testset, annotations));
+	}
+
+	return Analytics::evaluate(Analytics::analyse(hmm, testset, annotations));
+}
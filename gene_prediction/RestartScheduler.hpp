@@ -0,0 +1,119 @@
+/*
+ * RestartScheduler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef RESTARTSCHEDULER_HPP_
+#define RESTARTSCHEDULER_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "SequenceBatch.hpp"
+
+class HMMCompiled;
+class ThreadPool;
+
+/**
+ * This class learns several randomly initialized HMMs (tries) in parallel on a thread pool.
+ * The tries are learned in rounds of a fixed number of Baum-Welch iterations. After each
+ * round all remaining tries are scored and only the best fraction of them is kept for the
+ * next round (successive halving). Thus the computing time is spent on the promising
+ * initializations. The learning stops if all remaining tries have converged.
+ */
+class RestartScheduler {
+public:
+	/**
+	 * A score function rates a HMM. Higher scores are better.
+	 */
+	typedef boost::function<double(boost::shared_ptr<HMMCompiled>)> ScoreFunction;
+
+private:
+	ThreadPool& _pool;
+	int _roundIterations;
+	double _keepFraction;
+
+	/**
+	 * This function performs up to _roundIterations Baum-Welch iterations on hmm and
+	 * stores whether it has converged in converged.
+	 */
+	void learnRound(boost::shared_ptr<HMMCompiled> hmm,
+			const EncodedSequences& trainingset,
+			const std::vector<std::vector<uint8_t> >* labels,
+			double threshold, char* initialRun, char* converged) const;
+
+	/**
+	 * This function stores score(hmm) in result. Undefined scores are mapped to -infinity.
+	 */
+	static void scoreHMM(boost::shared_ptr<HMMCompiled> hmm,
+			const ScoreFunction& score, double* result);
+
+public:
+	/**
+	 * @argument pool thread pool which executes the learning and scoring of the tries
+	 * @argument roundIterations number of Baum-Welch iterations between two scorings
+	 * @argument keepFraction fraction of the tries which is kept after every round.
+	 * 	At least one try is always kept and 1 disables the culling.
+	 */
+	RestartScheduler(ThreadPool& pool, int roundIterations = 5,
+			double keepFraction = 0.5);
+
+	/**
+	 * This function learns all active tries on the training set. Tries which are culled
+	 * are marked as inactive and are not learned any further.
+	 *
+	 * @argument tries HMMs which are learned
+	 * @argument active active[j] says whether tries[j] takes part in the learning. It is
+	 * 	updated by the culling.
+	 * @argument trainingset
+	 * @argument labels if not NULL, the structure labels of the training set used for the
+	 * 	label constrained learning
+	 * @argument threshold a try has converged if all probability changes of an iteration are
+	 * 	smaller than the threshold
+	 * @argument score function used to rate the tries after every round
+	 * @argument scores scores[j] contains the last score of tries[j]
+	 *
+	 * @return index of the best active try
+	 */
+	int learn(const std::vector<boost::shared_ptr<HMMCompiled> >& tries,
+			std::vector<bool>& active,
+			const std::vector<std::vector<std::string> >& trainingset,
+			const std::vector<std::vector<std::string> >* labels,
+			double threshold, const ScoreFunction& score,
+			std::vector<double>& scores);
+
+	/**
+	 * This function does the same as the previous one on an encoded training set, e.g. a
+	 * view of a SequenceBatch. labels[k] are then the labels of its k-th sequence.
+	 */
+	int learn(const std::vector<boost::shared_ptr<HMMCompiled> >& tries,
+			std::vector<bool>& active, const EncodedSequences& trainingset,
+			const std::vector<std::vector<std::string> >* labels,
+			double threshold, const ScoreFunction& score,
+			std::vector<double>& scores);
+
+	/**
+	 * Score function: sum of the log-likelihoods of the sequences of the set. Sequences
+	 * which cannot be emitted by the HMM are ignored.
+	 */
+	static double likelihoodScore(boost::shared_ptr<HMMCompiled> hmm,
+			const SequenceBatch::View& set);
+
+	/**
+	 * Score function: Analytics::evaluate of the prediction of the structure of the test
+	 * set. If symbolMap is not NULL, then the emissions of hmm are projected before the
+	 * prediction (see HMMCompiled::projectEmissions).
+	 */
+	static double evaluationScore(boost::shared_ptr<HMMCompiled> hmm,
+			const boost::unordered_map<std::string, std::string>* symbolMap,
+			const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations);
+};
+
+#endif /* RESTARTSCHEDULER_HPP_ */
@@ -0,0 +1,190 @@
+/*
+ * SequenceBatch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "SequenceBatch.hpp"
+
+#include <stdexcept>
+
+#include "PackedSequence.hpp"
+
+SequenceBatch::View::View() :
+		_batch(NULL) {
+}
+
+SequenceBatch::View::View(const SequenceBatch& batch) :
+		_batch(&batch), _indices(batch.size()) {
+	for (int k = 0; k < batch.size(); k++) {
+		_indices[k] = k;
+	}
+}
+
+SequenceBatch::View::View(const SequenceBatch& batch,
+		const std::vector<int>& indices) :
+		_batch(&batch), _indices(indices) {
+}
+
+const std::vector<std::string>& SequenceBatch::View::getAlphabet() const {
+	static const std::vector<std::string> empty;
+
+	// a default constructed view selects no sequence of no batch
+	return _batch != NULL ? _batch->getAlphabet() : empty;
+}
+
+std::size_t SequenceBatch::View::getNumberSymbols() const {
+	std::size_t result = 0;
+
+	for (std::vector<int>::const_iterator it = _indices.begin();
+			it != _indices.end(); ++it) {
+		result += _batch->getLength(*it);
+	}
+
+	return result;
+}
+
+void SequenceBatch::View::decode(
+		std::vector<std::vector<std::string> >& result) const {
+	result.reserve(result.size() + _indices.size());
+
+	for (std::vector<int>::const_iterator it = _indices.begin();
+			it != _indices.end(); ++it) {
+		Span sequence = _batch->getSequence(*it);
+
+		result.push_back(std::vector<std::string>());
+		result.back().reserve(sequence.size());
+
+		for (int t = 0; t < sequence.size(); t++) {
+			result.back().push_back(_batch->getSymbol(sequence[t]));
+		}
+	}
+}
+
+SequenceBatch::SequenceBatch() :
+		_offsets(1, 0) {
+}
+
+SequenceBatch::SequenceBatch(
+		const std::vector<std::vector<std::string> >& sequences) :
+		_offsets(1, 0) {
+	std::size_t numberSymbols = 0;
+
+	for (std::vector<std::vector<std::string> >::const_iterator it =
+			sequences.begin(); it != sequences.end(); ++it) {
+		numberSymbols += it->size();
+	}
+
+	reserve(sequences.size(), numberSymbols);
+
+	for (std::vector<std::vector<std::string> >::const_iterator it =
+			sequences.begin(); it != sequences.end(); ++it) {
+		add(*it);
+	}
+}
+
+void SequenceBatch::reserve(int numberSequences, std::size_t numberSymbols) {
+	_offsets.reserve(numberSequences + 1);
+	_symbols.reserve(numberSymbols);
+}
+
+uint8_t SequenceBatch::getCode(const std::string& symbol) {
+	boost::unordered_map<std::string, uint8_t>::const_iterator it = _codes.find(
+			symbol);
+
+	if (it != _codes.end()) {
+		return it->second;
+	}
+
+	if (_alphabet.size() >= MAX_SYMBOLS) {
+		throw std::invalid_argument(
+				"SequenceBatch: The sequences contain more than 256 different symbols.");
+	}
+
+	uint8_t code = _alphabet.size();
+
+	_alphabet.push_back(symbol);
+	_codes[symbol] = code;
+
+	return code;
+}
+
+void SequenceBatch::add(const std::vector<std::string>& sequence) {
+	// the symbols of a run mostly repeat, thus the last one is checked before the map
+	const std::string* last = NULL;
+	uint8_t code = 0;
+
+	for (std::vector<std::string>::const_iterator it = sequence.begin();
+			it != sequence.end(); ++it) {
+		if (last == NULL || *it != *last) {
+			code = getCode(*it);
+			last = &*it;
+		}
+
+		_symbols.push_back(code);
+	}
+
+	_offsets.push_back(_symbols.size());
+}
+
+void SequenceBatch::add(const PackedSequence& sequence, int begin, int end) {
+	uint8_t codes[4];
+
+	for (int b = 0; b < 4; b++) {
+		codes[b] = getCode(PackedSequence::getSymbol(b));
+	}
+
+	_symbols.reserve(_symbols.size() + end - begin);
+
+	for (int t = begin; t < end; t++) {
+		_symbols.push_back(codes[sequence[t]]);
+	}
+
+	_offsets.push_back(_symbols.size());
+}
+
+void SequenceBatch::add(const int* codes, int length,
+		const std::vector<std::string>& alphabet) {
+	// batch codes of the symbols of alphabet, -1 if the symbol did not yet occur
+	std::vector<int> table(alphabet.size(), -1);
+
+	_symbols.reserve(_symbols.size() + length);
+
+	for (int t = 0; t < length; t++) {
+		int& code = table[codes[t]];
+
+		if (code < 0) {
+			code = getCode(alphabet[codes[t]]);
+		}
+
+		_symbols.push_back(code);
+	}
+
+	_offsets.push_back(_symbols.size());
+}
+
+void SequenceBatch::fold(int begin, int end, View& training,
+		View& test) const {
+	std::vector<int> trainingIndices;
+	std::vector<int> testIndices;
+
+	if (begin < 0 || end > size() || begin > end) {
+		throw std::invalid_argument(
+				"SequenceBatch: The test set is not a range of the sequences.");
+	}
+
+	trainingIndices.reserve(size() - (end - begin));
+	testIndices.reserve(end - begin);
+
+	for (int k = 0; k < size(); k++) {
+		if (k >= begin && k < end) {
+			testIndices.push_back(k);
+		} else {
+			trainingIndices.push_back(k);
+		}
+	}
+
+	training = View(*this, trainingIndices);
+	test = View(*this, testIndices);
+}
@@ -0,0 +1,237 @@
+/*
+ * SequenceBatch.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef SEQUENCEBATCH_HPP_
+#define SEQUENCEBATCH_HPP_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "EncodedSequences.hpp"
+
+class PackedSequence;
+
+/**
+ * This class stores a set of sequences in columnar form: The symbols of all sequences are
+ * stored one after another in a single buffer and offsets[k] is the position of the first
+ * symbol of the k-th sequence. Every symbol is replaced by a one byte code of the local
+ * alphabet of the batch, thus at most 256 different symbols are supported. Subsets of the
+ * sequences, e.g. the training and test sets of the folds of a cross validation, are
+ * selected by Views, which only store the indices of their sequences.
+ */
+class SequenceBatch {
+public:
+	/**
+	 * Reference to the symbol codes of a single sequence of a batch. It is valid as long as
+	 * no sequence is added to the batch.
+	 */
+	class Span {
+	private:
+		const SequenceBatch* _batch;
+		const uint8_t* _data;
+		int _length;
+
+	public:
+		Span(const SequenceBatch* batch, const uint8_t* data, int length) :
+				_batch(batch), _data(data), _length(length) {
+		}
+
+		int size() const {
+			return _length;
+		}
+
+		const uint8_t* data() const {
+			return _data;
+		}
+
+		uint8_t operator[](int position) const {
+			return _data[position];
+		}
+
+		const SequenceBatch& getBatch() const {
+			return *_batch;
+		}
+
+		/**
+		 * Stores table[c] for every symbol code c of this sequence in symbols.
+		 */
+		void encode(const int* table, int* symbols) const {
+			for (int t = 0; t < _length; t++) {
+				symbols[t] = table[_data[t]];
+			}
+		}
+	};
+
+	/**
+	 * Selection of sequences of a batch. It only stores the indices of the selected
+	 * sequences, thus it costs O(number of sequences) to create one.
+	 */
+	class View: public EncodedSequences {
+	private:
+		const SequenceBatch* _batch;
+		std::vector<int> _indices;
+
+	public:
+		View();
+
+		/**
+		 * Selects all sequences of batch.
+		 */
+		explicit View(const SequenceBatch& batch);
+
+		/**
+		 * Selects the sequences of batch with the given indices in their order.
+		 */
+		View(const SequenceBatch& batch, const std::vector<int>& indices);
+
+		int size() const {
+			return _indices.size();
+		}
+
+		/**
+		 * Returns the k-th sequence of this view.
+		 */
+		Span operator[](int k) const {
+			return _batch->getSequence(_indices[k]);
+		}
+
+		int getLength(int k) const {
+			return _batch->getLength(_indices[k]);
+		}
+
+		const std::vector<std::string>& getAlphabet() const;
+
+		void encode(int k, const int* table, int* symbols) const {
+			(*this)[k].encode(table, symbols);
+		}
+
+		/**
+		 * Returns the index of the k-th sequence of this view in the batch.
+		 */
+		int getIndex(int k) const {
+			return _indices[k];
+		}
+
+		/**
+		 * Returns the batch of this view. It must not be called on a default constructed
+		 * view.
+		 */
+		const SequenceBatch& getBatch() const {
+			return *_batch;
+		}
+
+		/**
+		 * Returns the total number of symbols of the selected sequences.
+		 */
+		std::size_t getNumberSymbols() const;
+
+		/**
+		 * Appends the selected sequences as symbol strings to result.
+		 */
+		void decode(std::vector<std::vector<std::string> >& result) const;
+	};
+
+private:
+	std::vector<uint8_t> _symbols;
+	// _offsets[k] = position of the first symbol of the k-th sequence in _symbols. The last
+	// entry is the total number of symbols.
+	std::vector<std::size_t> _offsets;
+	std::vector<std::string> _alphabet;
+	boost::unordered_map<std::string, uint8_t> _codes;
+
+	/**
+	 * Returns the code of symbol. If it is not yet contained in the alphabet, it is added.
+	 */
+	uint8_t getCode(const std::string& symbol);
+
+public:
+	// maximum number of different symbols of a batch
+	static const int MAX_SYMBOLS = 256;
+
+	SequenceBatch();
+
+	/**
+	 * Copies the sequences into a new batch.
+	 */
+	explicit SequenceBatch(
+			const std::vector<std::vector<std::string> >& sequences);
+
+	/**
+	 * Reserves memory for numberSequences sequences with numberSymbols symbols in total.
+	 */
+	void reserve(int numberSequences, std::size_t numberSymbols);
+
+	/**
+	 * Appends sequence to the batch. If its symbols would exceed the MAX_SYMBOLS different
+	 * symbols of a batch, then a std::invalid_argument is thrown.
+	 */
+	void add(const std::vector<std::string>& sequence);
+
+	/**
+	 * Appends the bases begin,...,end-1 of the packed sequence to the batch. The bases are
+	 * added as the symbols "A", "C", "G", "T" without creating strings per base.
+	 */
+	void add(const PackedSequence& sequence, int begin, int end);
+
+	/**
+	 * Appends the sequence of length symbols whose t-th symbol is alphabet[codes[t]], e.g.
+	 * the composite codes of DatabaseEntry::encodeAnnotatedSequence. Only the symbols of
+	 * alphabet which occur are added to the alphabet of the batch.
+	 */
+	void add(const int* codes, int length,
+			const std::vector<std::string>& alphabet);
+
+	int size() const {
+		return _offsets.size() - 1;
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	Span getSequence(int k) const {
+		return Span(this, _symbols.empty() ? NULL : &_symbols[0] + _offsets[k],
+				_offsets[k + 1] - _offsets[k]);
+	}
+
+	/**
+	 * Returns the number of symbols of the k-th sequence.
+	 */
+	int getLength(int k) const {
+		return _offsets[k + 1] - _offsets[k];
+	}
+
+	/**
+	 * Returns the total number of symbols of all sequences.
+	 */
+	std::size_t getNumberSymbols() const {
+		return _offsets.back();
+	}
+
+	/**
+	 * Returns the symbols of the batch. The code of a symbol is its position.
+	 */
+	const std::vector<std::string>& getAlphabet() const {
+		return _alphabet;
+	}
+
+	const std::string& getSymbol(uint8_t code) const {
+		return _alphabet[code];
+	}
+
+	/**
+	 * Splits the sequences into the test set begin,...,end-1 and the training set of all
+	 * other sequences, which keep their order. This is one fold of a cross validation.
+	 */
+	void fold(int begin, int end, View& training, View& test) const;
+};
+
+#endif /* SEQUENCEBATCH_HPP_ */
@@ -0,0 +1,138 @@
+/*
+ * SequenceSource.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "SequenceSource.hpp"
+
+#include <iostream>
+#include <cctype>
+#include <stdlib.h>
+
+#include <ctime>
+
+namespace {
+/**
+ * Returns the identifier of the identifier line line without '>' and a trailing '\r'.
+ */
+std::string readID(const std::string& line) {
+	std::size_t end = line.size();
+
+	if (end > 1 && line[end - 1] == '\r') {
+		end--;
+	}
+
+	return line.substr(1, end - 1);
+}
+}
+
+SequenceSource::~SequenceSource() {
+}
+
+int SequenceSource::nextBatch(int batchSize,
+		std::vector<std::vector<std::string> >& batch) {
+	batch.clear();
+
+	while (batch.size() < batchSize) {
+		batch.push_back(std::vector<std::string>());
+
+		if (!next(batch.back())) {
+			batch.pop_back();
+			break;
+		}
+	}
+
+	return batch.size();
+}
+
+VectorSequenceSource::VectorSequenceSource(
+		const std::vector<std::vector<std::string> >& sequences) :
+		_sequences(sequences), _position(0) {
+}
+
+bool VectorSequenceSource::next(std::vector<std::string>& sequence) {
+	if (_position >= _sequences.size()) {
+		return false;
+	}
+
+	sequence = _sequences[_position++];
+
+	return true;
+}
+
+void VectorSequenceSource::reset() {
+	_position = 0;
+}
+
+FastaSequenceSource::FastaSequenceSource(const std::string& filename) :
+		_filename(filename), _random(boost::random::mt19937(time(NULL))) {
+	reset();
+}
+
+void FastaSequenceSource::reset() {
+	std::string line;
+
+	_is.close();
+	_is.clear();
+	_is.open(_filename.c_str(), std::ios_base::in);
+
+	if (!_is) {
+		std::cerr << "Could not open file:" << _filename << std::endl;
+		exit(1);
+	}
+
+	_nextID = "";
+	_id = "";
+
+	// skip everything before the first record
+	while (std::getline(_is, line)) {
+		if (!line.empty() && line[0] == '>') {
+			_nextID = readID(line);
+			break;
+		}
+	}
+}
+
+bool FastaSequenceSource::next(std::vector<std::string>& sequence) {
+	std::string id;
+	PackedSequence data;
+
+	if (!next(id, data)) {
+		return false;
+	}
+
+	sequence.clear();
+	data.decode(0, data.size(), sequence);
+
+	return true;
+}
+
+bool FastaSequenceSource::next(std::string& id, PackedSequence& sequence) {
+	std::string line;
+
+	if (_nextID == "") {
+		return false;
+	}
+
+	_id = _nextID;
+	_nextID = "";
+
+	PackedSequence().swap(sequence);
+
+	while (std::getline(_is, line)) {
+		// read identifier of the following sequence
+		if (!line.empty() && line[0] == '>') {
+			_nextID = readID(line);
+			break;
+		}
+
+		// whitespace like '\r' is skipped
+		sequence.append(line.data(), line.data() + line.size(), _random);
+	}
+
+	id = _id;
+
+	return true;
+}
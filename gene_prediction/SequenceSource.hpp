@@ -0,0 +1,96 @@
+/*
+ * SequenceSource.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef SEQUENCESOURCE_HPP_
+#define SEQUENCESOURCE_HPP_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "PackedSequence.hpp"
+
+/**
+ * This class represents a source of DNA sequences which are read one after another. In
+ * contrast to the GeneDatabase, a source does not have to keep all sequences in memory.
+ * It is used by the online learning algorithm which processes the sequences in
+ * mini-batches.
+ */
+class SequenceSource {
+public:
+	virtual ~SequenceSource();
+
+	/**
+	 * Reads the next sequence into sequence. If there is no sequence left, then false
+	 * is returned.
+	 */
+	virtual bool next(std::vector<std::string>& sequence) = 0;
+
+	/**
+	 * Restarts the source at its first sequence.
+	 */
+	virtual void reset() = 0;
+
+	/**
+	 * Reads up to batchSize sequences into batch. The previous content of batch is
+	 * removed.
+	 *
+	 * @return number of read sequences
+	 */
+	int nextBatch(int batchSize, std::vector<std::vector<std::string> >& batch);
+};
+
+/**
+ * Sequence source for a set of sequences which is already in memory.
+ */
+class VectorSequenceSource: public SequenceSource {
+private:
+	const std::vector<std::vector<std::string> >& _sequences;
+	int _position;
+public:
+	VectorSequenceSource(const std::vector<std::vector<std::string> >& sequences);
+
+	bool next(std::vector<std::string>& sequence);
+	void reset();
+};
+
+/**
+ * Sequence source which reads the DNA sequences record by record from a fasta file.
+ * Only the current record is kept in memory.
+ */
+class FastaSequenceSource: public SequenceSource {
+private:
+	std::string _filename;
+	std::ifstream _is;
+	// identifier line of the record which is read next
+	std::string _nextID;
+	// identifier of the last read record
+	std::string _id;
+	// instantiates the placeholders for sets of bases
+	PackedSequence::RandomGenerator _random;
+public:
+	FastaSequenceSource(const std::string& filename);
+
+	bool next(std::vector<std::string>& sequence);
+	void reset();
+
+	/**
+	 * Reads the next record with 2 bits per base into sequence and its identifier into
+	 * id. The bases are encoded line by line, thus the record is never stored as text.
+	 * If there is no record left, then false is returned.
+	 */
+	bool next(std::string& id, PackedSequence& sequence);
+
+	/**
+	 * Returns the identifier of the last read sequence.
+	 */
+	const std::string& getID() const {
+		return _id;
+	}
+};
+
+#endif /* SEQUENCESOURCE_HPP_ */
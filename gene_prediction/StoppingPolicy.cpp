@@ -0,0 +1,305 @@
+/*
+ * StoppingPolicy.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "StoppingPolicy.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/random.hpp>
+
+#include "HMMCompiled.hpp"
+
+namespace {
+struct LongerSequence {
+	const std::vector<std::vector<std::string> >& _sequences;
+
+	LongerSequence(const std::vector<std::vector<std::string> >& sequences) :
+			_sequences(sequences) {
+	}
+
+	bool operator()(int a, int b) const {
+		return _sequences[a].size() > _sequences[b].size();
+	}
+};
+}
+
+StoppingPolicy::Score::Score() :
+		_value(-std::numeric_limits<double>::infinity()), _lower(
+				-std::numeric_limits<double>::infinity()), _upper(
+				-std::numeric_limits<double>::infinity()), _sampled(false) {
+}
+
+StoppingPolicy::~StoppingPolicy() {
+}
+
+FullEvaluation::FullEvaluation() :
+		_testset(NULL), _annotations(NULL), _pool(NULL), _iteration(-1) {
+}
+
+StoppingPolicy::Score FullEvaluation::evaluate(
+		boost::shared_ptr<HMMCompiled> hmm) const {
+	Score result;
+
+	result._analytics = Analytics::analyse(hmm, *_testset, *_annotations,
+			_pool);
+	result._value = result._lower = result._upper = Analytics::evaluate(
+			result._analytics);
+
+	return result;
+}
+
+void FullEvaluation::start(
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		ThreadPool* pool) {
+	_testset = &testset;
+	_annotations = &annotations;
+	_pool = pool;
+	_current = _previous = Score();
+	_iteration = -1;
+}
+
+bool FullEvaluation::proceed(boost::shared_ptr<HMMCompiled>,
+		boost::shared_ptr<HMMCompiled> current, int iteration,
+		double threshold) {
+	// the score of previous has been computed in the last call
+	_previous = _current;
+	_current = evaluate(current);
+	_iteration = iteration;
+
+	if (iteration == 0) {
+		return true;
+	}
+
+	return _current._value - _previous._value > threshold;
+}
+
+Analytics::AnalyticsResult FullEvaluation::analyse(
+		boost::shared_ptr<HMMCompiled> hmm, int iteration) {
+	if (iteration == _iteration) {
+		return _current._analytics;
+	} else if (iteration >= 0 && iteration == _iteration - 1) {
+		return _previous._analytics;
+	}
+
+	return evaluate(hmm)._analytics;
+}
+
+SampledEvaluation::SampledEvaluation(int sampleSize, int fullInterval,
+		double confidence, int resamples, unsigned int seed) :
+		_sampleSize(sampleSize), _fullInterval(fullInterval), _confidence(
+				confidence), _resamples(resamples), _seed(seed), _testset(NULL), _annotations(
+				NULL), _pool(NULL), _currentFullIteration(-1), _previousFullIteration(
+				-1), _numberFullEvaluations(0), _improvementLower(
+				-std::numeric_limits<double>::infinity()), _improvementUpper(
+				std::numeric_limits<double>::infinity()) {
+	if (sampleSize <= 0 || fullInterval <= 0 || resamples <= 0) {
+		throw std::invalid_argument(
+				"SampledEvaluation: The sample size, the interval of the full evaluations and the number of resamples have to be positive.");
+	}
+
+	if (confidence <= 0 || confidence >= 1) {
+		throw std::invalid_argument(
+				"SampledEvaluation: The confidence level has to be in (0,1).");
+	}
+}
+
+StoppingPolicy::Score SampledEvaluation::evaluate(
+		boost::shared_ptr<HMMCompiled> hmm) const {
+	Score result;
+
+	result._analytics = Analytics::analyse(hmm, *_testset, *_annotations,
+			_pool);
+	result._value = result._lower = result._upper = Analytics::evaluate(
+			result._analytics);
+
+	return result;
+}
+
+void SampledEvaluation::start(
+		const std::vector<std::vector<std::string> >& testset,
+		const std::vector<std::vector<uint8_t> >& annotations,
+		ThreadPool* pool) {
+	boost::random::mt19937 random(_seed);
+	std::vector<int> order;
+	int size = testset.size();
+	int strata = std::min(_sampleSize, size);
+
+	_testset = &testset;
+	_annotations = &annotations;
+	_pool = pool;
+	_sample.clear();
+	_sampleAnnotations.clear();
+	_currentCounts.clear();
+	_previousCounts.clear();
+	_current = _currentFull = _previousFull = Score();
+	_currentFullIteration = _previousFullIteration = -1;
+	_numberFullEvaluations = 0;
+	_improvementLower = -std::numeric_limits<double>::infinity();
+	_improvementUpper = std::numeric_limits<double>::infinity();
+
+	for (int i = 0; i < size; i++) {
+		order.push_back(i);
+	}
+
+	std::stable_sort(order.begin(), order.end(), LongerSequence(testset));
+
+	// draw one sequence from every stratum of sequences with similar lengths
+	for (int s = 0; s < strata; s++) {
+		boost::random::uniform_int_distribution<int> position(
+				(long long) s * size / strata,
+				(long long) (s + 1) * size / strata - 1);
+		int index = order[position(random)];
+
+		_sample.push_back(testset[index]);
+		_sampleAnnotations.push_back(annotations[index]);
+	}
+}
+
+void SampledEvaluation::confidenceInterval(
+		const std::vector<Analytics::AnalyticsIntermediate>& counts,
+		const std::vector<Analytics::AnalyticsIntermediate>* reference,
+		double& lower, double& upper) const {
+	boost::random::mt19937 random(_seed + 1);
+	boost::random::uniform_int_distribution<int> position(0, counts.size() - 1);
+	std::vector<double> values;
+	double alpha = (1 - _confidence) / 2;
+
+	for (int r = 0; r < _resamples; r++) {
+		Analytics::AnalyticsIntermediate sum;
+		Analytics::AnalyticsIntermediate referenceSum;
+
+		for (int i = 0; i < counts.size(); i++) {
+			int index = position(random);
+
+			sum += counts[index];
+
+			if (reference != NULL) {
+				referenceSum += (*reference)[index];
+			}
+		}
+
+		double value = Analytics::evaluate(Analytics::analyse(sum));
+
+		if (reference != NULL) {
+			value -= Analytics::evaluate(Analytics::analyse(referenceSum));
+		}
+
+		// a resample without exons has no accuracy value
+		if (!std::isnan(value)) {
+			values.push_back(value);
+		}
+	}
+
+	if (values.empty()) {
+		lower = -std::numeric_limits<double>::infinity();
+		upper = std::numeric_limits<double>::infinity();
+		return;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	lower = values[(int) std::floor(alpha * (values.size() - 1))];
+	upper = values[(int) std::ceil((1 - alpha) * (values.size() - 1))];
+}
+
+const StoppingPolicy::Score& SampledEvaluation::fullScore(
+		boost::shared_ptr<HMMCompiled> hmm, int iteration) {
+	if (iteration == _currentFullIteration) {
+		return _currentFull;
+	} else if (iteration == _previousFullIteration) {
+		return _previousFull;
+	}
+
+	_numberFullEvaluations++;
+
+	if (iteration > _currentFullIteration) {
+		_previousFull = _currentFull;
+		_previousFullIteration = _currentFullIteration;
+		_currentFull = evaluate(hmm);
+		_currentFullIteration = iteration;
+
+		return _currentFull;
+	} else {
+		_previousFull = evaluate(hmm);
+		_previousFullIteration = iteration;
+
+		return _previousFull;
+	}
+}
+
+bool SampledEvaluation::proceed(boost::shared_ptr<HMMCompiled> previous,
+		boost::shared_ptr<HMMCompiled> current, int iteration,
+		double threshold) {
+	Analytics::AnalyticsIntermediate sum;
+	Analytics::AnalyticsIntermediate previousSum;
+
+	if (_testset == NULL) {
+		throw std::invalid_argument(
+				"SampledEvaluation: The learning run has not been started.");
+	}
+
+	// the counts of previous have been computed in the last call
+	_previousCounts.swap(_currentCounts);
+	Analytics::analyse(current, _sample, _sampleAnnotations, _currentCounts,
+			_pool);
+
+	for (int i = 0; i < _currentCounts.size(); i++) {
+		sum += _currentCounts[i];
+	}
+
+	_current = Score();
+	_current._analytics = Analytics::analyse(sum);
+	_current._value = Analytics::evaluate(_current._analytics);
+	_current._sampled = true;
+	confidenceInterval(_currentCounts, NULL, _current._lower, _current._upper);
+
+	if (iteration == 0) {
+		return true;
+	}
+
+	for (int i = 0; i < _previousCounts.size(); i++) {
+		previousSum += _previousCounts[i];
+	}
+
+	double diff = _current._value
+			- Analytics::evaluate(Analytics::analyse(previousSum));
+
+	// the models are compared on the same sequences, thus the paired differences are
+	// resampled
+	confidenceInterval(_currentCounts, &_previousCounts, _improvementLower,
+			_improvementUpper);
+
+	// the learning is only stopped if the whole test set confirms it
+	if (iteration % _fullInterval == 0 || !(diff > threshold)) {
+		double previousValue = fullScore(previous, iteration - 1)._value;
+
+		_current = fullScore(current, iteration);
+		diff = _current._value - previousValue;
+	}
+
+	return diff > threshold;
+}
+
+Analytics::AnalyticsResult SampledEvaluation::analyse(
+		boost::shared_ptr<HMMCompiled> hmm, int iteration) {
+	return fullScore(hmm, iteration)._analytics;
+}
+
+std::ostream& operator<<(std::ostream& os, const StoppingPolicy::Score& score) {
+	os << "Value:" << score._value << " Confidence interval:[" << score._lower
+			<< "," << score._upper << "]";
+
+	if (score._sampled) {
+		os << " (sampled)";
+	}
+
+	return os;
+}
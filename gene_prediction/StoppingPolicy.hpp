@@ -0,0 +1,230 @@
+/*
+ * StoppingPolicy.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef STOPPINGPOLICY_HPP_
+#define STOPPINGPOLICY_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "Analytics.hpp"
+
+class HMMCompiled;
+class ThreadPool;
+
+/**
+ * This class decides when the evaluation driven Baum-Welch algorithm (see
+ * HMMCompiled::baumWelch) stops. After every iteration the accuracy value (see
+ * Analytics::evaluate) of the learned model is compared to that of the model of the
+ * preceding iteration and the learning stops as soon as the improvement is not larger
+ * than the threshold. A policy has a state, thus every learning run needs its own
+ * instance.
+ */
+class StoppingPolicy {
+public:
+	/**
+	 * Estimate of the accuracy of a model.
+	 */
+	struct Score {
+		Analytics::AnalyticsResult _analytics;
+		// accuracy value (see Analytics::evaluate)
+		double _value;
+		// confidence interval of _value. It is [_value,_value] if the whole test set was
+		// evaluated.
+		double _lower;
+		double _upper;
+		// whether only a sample of the test set was evaluated
+		bool _sampled;
+
+		Score();
+	};
+
+	virtual ~StoppingPolicy();
+
+	/**
+	 * Starts a new learning run whose models are evaluated on testset.
+	 *
+	 * @argument testset
+	 * @argument annotations structure informations of the testset sequences as codes of
+	 * 	DatabaseEntry::Label (see Analytics::encodeAnnotations)
+	 * @argument pool if not NULL, the test set is evaluated in parallel by its workers (see
+	 * 	Analytics::analyse)
+	 */
+	virtual void start(const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations,
+			ThreadPool* pool) = 0;
+
+	/**
+	 * Decides after the iteration-th learning iteration whether the learning proceeds.
+	 *
+	 * @argument previous model of the preceding iteration, it is not used for the iteration 0.
+	 * 	Policies which keep the score of the preceding iteration may ignore it.
+	 * @argument current model of the iteration-th iteration
+	 * @argument iteration number of the iteration, starting with 0
+	 * @argument threshold the learning proceeds if the accuracy value of current minus the one
+	 * 	of previous is larger than threshold
+	 *
+	 * @return true if the learning proceeds
+	 */
+	virtual bool proceed(boost::shared_ptr<HMMCompiled> previous,
+			boost::shared_ptr<HMMCompiled> current, int iteration,
+			double threshold) = 0;
+
+	/**
+	 * Returns the analytics result of hmm on the whole test set. hmm is the model of the
+	 * iteration-th iteration, thus a result computed by proceed can be reused.
+	 */
+	virtual Analytics::AnalyticsResult analyse(
+			boost::shared_ptr<HMMCompiled> hmm, int iteration) = 0;
+
+	/**
+	 * Returns the score of the model which was passed as current to the last call of
+	 * proceed.
+	 */
+	virtual const Score& getScore() const = 0;
+};
+
+/**
+ * This policy evaluates every model on the whole test set.
+ */
+class FullEvaluation: public StoppingPolicy {
+private:
+	const std::vector<std::vector<std::string> >* _testset;
+	const std::vector<std::vector<uint8_t> >* _annotations;
+	ThreadPool* _pool;
+	// score of the model of the iteration _iteration and of its predecessor
+	Score _current;
+	Score _previous;
+	int _iteration;
+
+	Score evaluate(boost::shared_ptr<HMMCompiled> hmm) const;
+
+public:
+	FullEvaluation();
+
+	void start(const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations,
+			ThreadPool* pool);
+	// previous is not used since its score is kept from the last call
+	bool proceed(boost::shared_ptr<HMMCompiled>,
+			boost::shared_ptr<HMMCompiled> current, int iteration,
+			double threshold);
+	Analytics::AnalyticsResult analyse(boost::shared_ptr<HMMCompiled> hmm,
+			int iteration);
+
+	const Score& getScore() const {
+		return _current;
+	}
+};
+
+/**
+ * This policy evaluates every model only on a sample of the test set which is stratified
+ * by the sequence length: The sequences are sorted by their lengths and divided into
+ * sampleSize strata of equal size, from each of which one sequence is drawn. The sample
+ * is fixed for the whole learning run, thus consecutive models are compared on the same
+ * sequences. The confidence intervals of the sampled accuracy value and of the improvement
+ * are estimated by the bootstrap percentile method. The models are evaluated on the whole
+ * test set every fullInterval iterations and whenever the sampled improvement is not larger
+ * than the threshold, thus the learning is only stopped if the whole test set confirms it.
+ * Since consecutive models differ only slightly, the confidence interval of the improvement
+ * usually contains the threshold near the convergence, thus it is reported but does not
+ * trigger a full evaluation.
+ */
+class SampledEvaluation: public StoppingPolicy {
+private:
+	int _sampleSize;
+	int _fullInterval;
+	double _confidence;
+	int _resamples;
+	unsigned int _seed;
+
+	const std::vector<std::vector<std::string> >* _testset;
+	const std::vector<std::vector<uint8_t> >* _annotations;
+	ThreadPool* _pool;
+	std::vector<std::vector<std::string> > _sample;
+	std::vector<std::vector<uint8_t> > _sampleAnnotations;
+	// counts of the sequences of the sample for the models of the last two iterations
+	std::vector<Analytics::AnalyticsIntermediate> _currentCounts;
+	std::vector<Analytics::AnalyticsIntermediate> _previousCounts;
+	// score of the model of the last iteration
+	Score _current;
+	// scores on the whole test set and the iterations of their models, -1 if there is none
+	Score _currentFull;
+	Score _previousFull;
+	int _currentFullIteration;
+	int _previousFullIteration;
+	int _numberFullEvaluations;
+	// confidence interval of the sampled improvement of the last iteration
+	double _improvementLower;
+	double _improvementUpper;
+
+	Score evaluate(boost::shared_ptr<HMMCompiled> hmm) const;
+
+	/**
+	 * Computes the bootstrap confidence interval of the accuracy value of the counts
+	 * (if reference is NULL) or of its difference to the value of the counts reference
+	 * on the same resampled sequences.
+	 */
+	void confidenceInterval(
+			const std::vector<Analytics::AnalyticsIntermediate>& counts,
+			const std::vector<Analytics::AnalyticsIntermediate>* reference,
+			double& lower, double& upper) const;
+
+	/**
+	 * Returns the score of the model of the iteration-th iteration on the whole test set.
+	 * If it has already been computed, then the stored one is returned.
+	 */
+	const Score& fullScore(boost::shared_ptr<HMMCompiled> hmm, int iteration);
+
+public:
+	/**
+	 * @argument sampleSize number of sequences of the sample
+	 * @argument fullInterval number of iterations between two evaluations on the whole
+	 * 	test set
+	 * @argument confidence confidence level of the confidence intervals
+	 * @argument resamples number of bootstrap resamples
+	 * @argument seed seed of the random generator which draws the sample and the resamples
+	 */
+	SampledEvaluation(int sampleSize, int fullInterval = 10, double confidence =
+			0.95, int resamples = 200, unsigned int seed = 0);
+
+	void start(const std::vector<std::vector<std::string> >& testset,
+			const std::vector<std::vector<uint8_t> >& annotations,
+			ThreadPool* pool);
+	bool proceed(boost::shared_ptr<HMMCompiled> previous,
+			boost::shared_ptr<HMMCompiled> current, int iteration,
+			double threshold);
+	Analytics::AnalyticsResult analyse(boost::shared_ptr<HMMCompiled> hmm,
+			int iteration);
+
+	const Score& getScore() const {
+		return _current;
+	}
+
+	/**
+	 * Returns the confidence interval of the sampled improvement of the accuracy value in the
+	 * last iteration.
+	 */
+	void getImprovementInterval(double& lower, double& upper) const {
+		lower = _improvementLower;
+		upper = _improvementUpper;
+	}
+
+	/**
+	 * Returns the number of evaluations on the whole test set since the start of the
+	 * learning run.
+	 */
+	int getNumberFullEvaluations() const {
+		return _numberFullEvaluations;
+	}
+};
+
+std::ostream& operator<<(std::ostream& os, const StoppingPolicy::Score& score);
+
+#endif /* STOPPINGPOLICY_HPP_ */
@@ -0,0 +1,133 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#include "ThreadPool.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/bind/bind.hpp>
+
+ThreadPool::Batch::Batch() :
+		_pending(0) {
+}
+
+void ThreadPool::Batch::wait() {
+	boost::unique_lock<boost::mutex> lock(_mutex);
+
+	while (_pending > 0) {
+		_finished.wait(lock);
+	}
+
+	if (!_error.empty()) {
+		std::string error = _error;
+		_error.clear();
+
+		throw std::runtime_error(error);
+	}
+}
+
+ThreadPool::ThreadPool(int numberThreads) :
+		_stopped(false) {
+	if (numberThreads <= 0) {
+		numberThreads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	for (int i = 0; i < numberThreads; i++) {
+		_workers.create_thread(boost::bind(&ThreadPool::work, this));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_stopped = true;
+	}
+
+	_available.notify_all();
+	_workers.join_all();
+}
+
+void ThreadPool::schedule(Batch& batch, const boost::function<void()>& job) {
+	Job entry;
+	entry._job = job;
+	entry._batch = &batch;
+
+	{
+		boost::lock_guard<boost::mutex> lock(batch._mutex);
+		batch._pending++;
+	}
+
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_jobs.push_back(entry);
+	}
+
+	_available.notify_one();
+}
+
+void ThreadPool::schedule(const boost::function<void()>& job) {
+	Job entry;
+	entry._job = job;
+	entry._batch = NULL;
+
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_jobs.push_back(entry);
+	}
+
+	_available.notify_one();
+}
+
+int ThreadPool::size() const {
+	return _workers.size();
+}
+
+void ThreadPool::work() {
+	while (true) {
+		Job entry;
+
+		{
+			boost::unique_lock<boost::mutex> lock(_mutex);
+
+			while (_jobs.empty() && !_stopped) {
+				_available.wait(lock);
+			}
+
+			if (_jobs.empty()) {
+				return;
+			}
+
+			entry = _jobs.front();
+			_jobs.pop_front();
+		}
+
+		std::string error;
+
+		try {
+			entry._job();
+		} catch (std::exception& e) {
+			error = e.what();
+		} catch (...) {
+			error = "ThreadPool: Job has thrown an unknown exception.";
+		}
+
+		if (entry._batch == NULL) {
+			continue;
+		}
+
+		boost::lock_guard<boost::mutex> lock(entry._batch->_mutex);
+
+		if (!error.empty() && entry._batch->_error.empty()) {
+			entry._batch->_error = error;
+		}
+
+		if (--entry._batch->_pending == 0) {
+			entry._batch->_finished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,92 @@
+/*
+ * ThreadPool.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Till Rohrmann
+ */
+
+#ifndef THREADPOOL_HPP_
+#define THREADPOOL_HPP_
+
+#include <deque>
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+
+/**
+ * This class represents a fixed number of worker threads which execute the scheduled jobs.
+ * Jobs are grouped into batches. A batch allows to wait for the completion of its own jobs,
+ * thus several batches can share one pool as long as no worker waits for a batch.
+ */
+class ThreadPool: boost::noncopyable {
+public:
+	/**
+	 * This class keeps track of the jobs of a batch which have not yet finished.
+	 */
+	class Batch: boost::noncopyable {
+	private:
+		int _pending;
+		// error message of the first job which has thrown an exception
+		std::string _error;
+		boost::mutex _mutex;
+		boost::condition_variable _finished;
+
+		friend class ThreadPool;
+
+	public:
+		Batch();
+
+		/**
+		 * Blocks until all jobs of this batch have finished. If a job has thrown an
+		 * exception, then a std::runtime_error with its message is thrown.
+		 */
+		void wait();
+	};
+
+private:
+	struct Job {
+		boost::function<void()> _job;
+		// NULL if the job does not belong to a batch
+		Batch* _batch;
+	};
+
+	std::deque<Job> _jobs;
+	boost::mutex _mutex;
+	boost::condition_variable _available;
+	boost::thread_group _workers;
+	bool _stopped;
+
+	/**
+	 * Main loop of every worker thread.
+	 */
+	void work();
+
+public:
+	/**
+	 * Starts numberThreads worker threads. If numberThreads is not positive, then
+	 * one thread per hardware thread is started.
+	 */
+	ThreadPool(int numberThreads = 0);
+
+	/**
+	 * Finishes the remaining jobs and joins all worker threads.
+	 */
+	~ThreadPool();
+
+	/**
+	 * Schedules job as part of batch.
+	 */
+	void schedule(Batch& batch, const boost::function<void()>& job);
+
+	/**
+	 * Schedules job without a batch. Nobody waits for such a job, thus it has to keep
+	 * alive the data it accesses and it must not throw an exception.
+	 */
+	void schedule(const boost::function<void()>& job);
+
+	int size() const;
+};
+
+#endif /* THREADPOOL_HPP_ */